@@ -0,0 +1,144 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <msfce/core/snes.h>
+#include <msfce/core/log.h>
+
+#include "frontend_headless.h"
+
+#define TAG "FrontendHeadless"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Value below which `percent` % of the sorted samples are
+double getPercentile(const std::vector<double>& sorted, int percent)
+{
+    size_t idx = (sorted.size() - 1) * percent / 100;
+    return sorted[idx];
+}
+
+} // anonymous namespace
+
+FrontendHeadless::FrontendHeadless(
+    int frameCount,
+    const std::string& statePath,
+    bool render,
+    int runAheadFrames)
+    : Frontend()
+    , m_FrameCount(frameCount)
+    , m_StatePath(statePath)
+    , m_Render(render)
+    , m_RunAheadFrames(runAheadFrames)
+{
+}
+
+int FrontendHeadless::init(const std::shared_ptr<msfce::core::Snes>& snes)
+{
+    m_Snes = snes;
+
+    if (m_RunAheadFrames > 0) {
+        m_RunAhead = std::make_unique<msfce::core::RunAhead>(
+            m_Snes, m_RunAheadFrames);
+    }
+
+    if (!m_StatePath.empty()) {
+        int ret = m_Snes->loadState(m_StatePath);
+        if (ret < 0) {
+            return ret;
+        }
+    }
+
+    return 0;
+}
+
+int FrontendHeadless::run()
+{
+    if (m_FrameCount <= 0) {
+        LOGE(TAG, "Invalid frame count %d", m_FrameCount);
+        return -EINVAL;
+    }
+
+    std::vector<double> frameMs;
+    frameMs.reserve(m_FrameCount);
+
+    int64_t cpuUs = 0;
+    int64_t ppuUs = 0;
+    int64_t apuUs = 0;
+
+    const auto startTp = Clock::now();
+
+    for (int i = 0; i < m_FrameCount; i++) {
+        const auto frameStartTp = Clock::now();
+        msfce::core::FrameTimings timings;
+
+        // Run-ahead timings include the hidden frames
+        if (m_RunAhead) {
+            m_RunAhead->renderSingleFrame();
+            timings = m_RunAhead->getFrameTimings();
+        } else {
+            m_Snes->renderSingleFrame(m_Render);
+            timings = m_Snes->getFrameTimings();
+        }
+
+        const std::chrono::duration<double, std::milli> frameDuration =
+            Clock::now() - frameStartTp;
+        frameMs.push_back(frameDuration.count());
+
+        cpuUs += timings.cpuUs;
+        ppuUs += timings.ppuUs;
+        apuUs += timings.apuUs;
+    }
+
+    const std::chrono::duration<double, std::milli> totalDuration =
+        Clock::now() - startTp;
+    const double totalMs = totalDuration.count();
+
+    std::sort(frameMs.begin(), frameMs.end());
+
+    const char* dsp =
+        m_Snes->getDspType() == msfce::core::DspType::fast ? "fast"
+                                                           : "accurate";
+
+    if (m_RunAhead) {
+        printf(
+            "Frames: %d (run-ahead %d, %s DSP)\n",
+            m_FrameCount,
+            m_RunAheadFrames,
+            dsp);
+    } else {
+        printf(
+            "Frames: %d (%s, %s DSP)\n",
+            m_FrameCount,
+            m_Render ? "render" : "no render",
+            dsp);
+    }
+    printf(
+        "Total: %.1f ms, %.1f frames/s\n",
+        totalMs,
+        m_FrameCount * 1000 / totalMs);
+    printf(
+        "ms/frame: min %.3f, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n",
+        frameMs.front(),
+        getPercentile(frameMs, 50),
+        getPercentile(frameMs, 90),
+        getPercentile(frameMs, 99),
+        frameMs.back());
+    printf(
+        "CPU: %.3f ms/frame (%.1f %%), PPU: %.3f ms/frame (%.1f %%), "
+        "APU: %.3f ms/frame (%.1f %%)\n",
+        cpuUs / 1000.0 / m_FrameCount,
+        cpuUs / 10.0 / totalMs,
+        ppuUs / 1000.0 / m_FrameCount,
+        ppuUs / 10.0 / totalMs,
+        apuUs / 1000.0 / m_FrameCount,
+        apuUs / 10.0 / totalMs);
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <msfce/core/runahead.h>
+
+#include "frontend.h"
+
+// Run frames as fast as possible without any device, then print timings
+class FrontendHeadless : public Frontend {
+public:
+    // Run-ahead frames are always rendered
+    FrontendHeadless(
+        int frameCount,
+        const std::string& statePath,
+        bool render,
+        int runAheadFrames);
+    ~FrontendHeadless() = default;
+
+    /// Frontend methods
+    int init(const std::shared_ptr<msfce::core::Snes>& snes) final;
+    int run() final;
+
+private:
+    const int m_FrameCount;
+    const std::string m_StatePath;
+    const bool m_Render;
+    const int m_RunAheadFrames;
+
+    std::shared_ptr<msfce::core::Snes> m_Snes;
+    std::unique_ptr<msfce::core::RunAhead> m_RunAhead;
+};
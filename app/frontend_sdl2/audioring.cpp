@@ -0,0 +1,111 @@
+#include <string.h>
+
+#include <algorithm>
+
+#include "audioring.h"
+
+AudioRing::AudioRing(size_t size)
+    : m_Buffer(size)
+    , m_MinFill(SIZE_MAX)
+{
+}
+
+size_t AudioRing::write(const uint8_t* data, size_t size)
+{
+    uint64_t writePos = m_WritePos.load(std::memory_order_relaxed);
+    uint64_t readPos = m_ReadPos.load(std::memory_order_acquire);
+
+    size_t freeSize = m_Buffer.size() - (writePos - readPos);
+    if (size > freeSize) {
+        m_Overruns.fetch_add(1, std::memory_order_relaxed);
+        size = freeSize;
+    }
+
+    size_t offset = writePos % m_Buffer.size();
+    size_t firstSize = std::min(size, m_Buffer.size() - offset);
+
+    memcpy(&m_Buffer[offset], data, firstSize);
+    memcpy(&m_Buffer[0], data + firstSize, size - firstSize);
+
+    m_WritePos.store(writePos + size, std::memory_order_release);
+    updateFillStats(writePos + size - readPos);
+
+    return size;
+}
+
+void AudioRing::read(uint8_t* data, size_t size)
+{
+    uint64_t readPos = m_ReadPos.load(std::memory_order_relaxed);
+    uint64_t writePos = m_WritePos.load(std::memory_order_acquire);
+
+    size_t fill = writePos - readPos;
+    updateFillStats(fill);
+
+    size_t readSize = size;
+    if (readSize > fill) {
+        m_Underruns.fetch_add(1, std::memory_order_relaxed);
+        readSize = fill;
+    }
+
+    size_t offset = readPos % m_Buffer.size();
+    size_t firstSize = std::min(readSize, m_Buffer.size() - offset);
+
+    memcpy(data, &m_Buffer[offset], firstSize);
+    memcpy(data + firstSize, &m_Buffer[0], readSize - firstSize);
+    memset(data + readSize, 0, size - readSize);
+
+    m_ReadPos.store(readPos + readSize, std::memory_order_release);
+}
+
+void AudioRing::flush()
+{
+    m_ReadPos.store(
+        m_WritePos.load(std::memory_order_acquire),
+        std::memory_order_release);
+}
+
+size_t AudioRing::getSize() const
+{
+    return m_Buffer.size();
+}
+
+size_t AudioRing::getFillLevel() const
+{
+    uint64_t readPos = m_ReadPos.load(std::memory_order_acquire);
+    uint64_t writePos = m_WritePos.load(std::memory_order_acquire);
+
+    // Read position may move between both loads, never past the write one
+    return writePos > readPos ? writePos - readPos : 0;
+}
+
+AudioRing::Stats AudioRing::getStats()
+{
+    Stats stats;
+
+    stats.minFill = m_MinFill.exchange(SIZE_MAX, std::memory_order_relaxed);
+    stats.maxFill = m_MaxFill.exchange(0, std::memory_order_relaxed);
+    stats.underruns = m_Underruns.load(std::memory_order_relaxed);
+    stats.overruns = m_Overruns.load(std::memory_order_relaxed);
+
+    if (stats.minFill == SIZE_MAX) {
+        stats.minFill = 0;
+    }
+
+    return stats;
+}
+
+void AudioRing::updateFillStats(size_t fill)
+{
+    // Both sides update the same values, retry if the other one was faster
+    size_t minFill = m_MinFill.load(std::memory_order_relaxed);
+    while (fill < minFill &&
+           !m_MinFill.compare_exchange_weak(
+               minFill, fill, std::memory_order_relaxed)) {
+    }
+
+    size_t maxFill = m_MaxFill.load(std::memory_order_relaxed);
+    while (fill > maxFill &&
+           !m_MaxFill.compare_exchange_weak(
+               maxFill, fill, std::memory_order_relaxed)) {
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <vector>
+
+// Lock-free byte ring between a single producer and a single consumer.
+// Data that doesn't fit is dropped (overrun), missing data is read as
+// silence (underrun).
+class AudioRing {
+public:
+    struct Stats {
+        size_t minFill = 0;
+        size_t maxFill = 0;
+
+        uint64_t underruns = 0;
+        uint64_t overruns = 0;
+    };
+
+public:
+    AudioRing(size_t size);
+
+    // Producer side, returns the written size
+    size_t write(const uint8_t* data, size_t size);
+
+    // Consumer side, always fills `size` bytes
+    void read(uint8_t* data, size_t size);
+
+    // Consumer side, drop all queued data
+    void flush();
+
+    size_t getSize() const;
+    size_t getFillLevel() const;
+
+    // Fill levels are reset on each call, counters are cumulative
+    Stats getStats();
+
+private:
+    void updateFillStats(size_t fill);
+
+private:
+    std::vector<uint8_t> m_Buffer;
+
+    // Positions only grow, each one is only written by its side
+    std::atomic<uint64_t> m_WritePos{0};
+    std::atomic<uint64_t> m_ReadPos{0};
+
+    std::atomic<size_t> m_MinFill;
+    std::atomic<size_t> m_MaxFill{0};
+    std::atomic<uint64_t> m_Underruns{0};
+    std::atomic<uint64_t> m_Overruns{0};
+};
@@ -1,6 +1,10 @@
 #include <assert.h>
+#include <inttypes.h>
+#include <string.h>
 
+#include <algorithm>
 #include <chrono>
+#include <iterator>
 #include <thread>
 
 #include <msfce/core/snes.h>
@@ -16,17 +20,84 @@ namespace {
 
 constexpr int kWindowInitialScale = 2;
 
+// Raw PPU colors, expanded by RendererGl shader
+constexpr auto kFrameFormat = msfce::core::PixelFormat::BGR555;
+
 constexpr auto kRenderPeriod = std::chrono::microseconds(16666);
 constexpr int kSpeedupFrameSkip = 3; // x4 (skip 3 frames)
 
+constexpr int kAudioDeviceRate = 48000;
+constexpr int kAudioDeviceChannels = 2;
+constexpr int kAudioDeviceSampleSize = kAudioDeviceChannels * sizeof(int16_t);
+
+// Queued audio kept by dynamic rate control
+constexpr int kAudioTargetLatencyMs = 50;
+
+// Max output rate change to converge to the target latency
+constexpr double kAudioMaxRateDelta = 0.005;
+
+constexpr auto kAudioStatsPeriod = std::chrono::seconds(5);
+
+// Controller buttons, in their bit order once latched
+// clang-format off
+constexpr bool msfce::core::Controller::*kControllerButtons[] = {
+    &msfce::core::Controller::up,
+    &msfce::core::Controller::down,
+    &msfce::core::Controller::left,
+    &msfce::core::Controller::right,
+    &msfce::core::Controller::start,
+    &msfce::core::Controller::select,
+    &msfce::core::Controller::l,
+    &msfce::core::Controller::r,
+    &msfce::core::Controller::y,
+    &msfce::core::Controller::x,
+    &msfce::core::Controller::b,
+    &msfce::core::Controller::a,
+};
+// clang-format on
+
+uint16_t packController(const msfce::core::Controller& controller)
+{
+    uint16_t value = 0;
+
+    for (size_t i = 0; i < std::size(kControllerButtons); i++) {
+        if (controller.*kControllerButtons[i]) {
+            value |= 1 << i;
+        }
+    }
+
+    return value;
+}
+
+msfce::core::Controller unpackController(uint16_t value)
+{
+    msfce::core::Controller controller;
+
+    for (size_t i = 0; i < std::size(kControllerButtons); i++) {
+        controller.*kControllerButtons[i] = value & (1 << i);
+    }
+
+    return controller;
+}
+
 } // anonymous namespace
 
-FrontendSdl2::FrontendSdl2() : Frontend(), msfce::core::Renderer()
+FrontendSdl2::FrontendSdl2(
+    size_t rewindSize,
+    int rewindInterval,
+    int runAheadFrames)
+    : Frontend()
+    , msfce::core::Renderer()
+    , m_RewindSize(rewindSize)
+    , m_RewindInterval(rewindInterval)
+    , m_RunAheadFrames(runAheadFrames)
 {
 }
 
 FrontendSdl2::~FrontendSdl2()
 {
+    assert(!m_EmulationThread.joinable());
+
     m_GlRenderer.reset();
     clearRecorder();
     SDL_Quit();
@@ -61,16 +132,36 @@ int FrontendSdl2::init(const std::shared_ptr<msfce::core::Snes>& snes)
     assert(m_GlContext);
 
     m_GlRenderer = std::make_unique<RendererGl>(m_SnesConfig);
-    m_GlRenderer->initContext();
+    int ret = m_GlRenderer->initContext();
+    assert(ret == 0);
     m_GlRenderer->setWindowSize(m_WindowWidth, m_WindowHeight);
 
+    // PPU draws raw colors in host buffers, followed by line brightness. The
+    // last one is copied to the texture before rendering.
+    m_FrameSize = m_GlRenderer->getFrameSize();
+    m_FramePixelsSize = m_SnesConfig.displayWidth *
+                        m_SnesConfig.displayHeight *
+                        msfce::core::getPixelSize(kFrameFormat);
+    assert(m_FramePixelsSize + m_SnesConfig.displayHeight == m_FrameSize);
+
+    m_FrameBuffers = std::make_unique<TripleBuffer>(m_FrameSize);
+    setFramebuffer();
+
+    if (m_RewindSize > 0) {
+        m_RewindBuffer = std::make_unique<msfce::core::RewindBuffer>(
+            m_Snes, m_RewindSize, m_RewindInterval);
+    }
+
+    m_RunAhead =
+        std::make_unique<msfce::core::RunAhead>(m_Snes, m_RunAheadFrames);
+
     // Init audio
     SDL_AudioSpec spec;
     SDL_memset(&spec, 0, sizeof(spec));
-    spec.freq = m_SnesConfig.audioSampleRate;
+    spec.freq = kAudioDeviceRate;
     spec.format = AUDIO_S16;
-    spec.channels = 2;
-    spec.samples = 512; // 16 ms
+    spec.channels = kAudioDeviceChannels;
+    spec.samples = 512; // 10 ms
 
     auto cb = [](void* userdata, Uint8* stream, int len) {
         FrontendSdl2* self = reinterpret_cast<FrontendSdl2*>(userdata);
@@ -80,7 +171,28 @@ int FrontendSdl2::init(const std::shared_ptr<msfce::core::Snes>& snes)
     spec.callback = cb;
     spec.userdata = this;
 
-    SDL_AudioDeviceID deviceId = SDL_OpenAudioDevice(NULL, 0, &spec, NULL, 0);
+    // Keep the native rate of the device, resampling is done before
+    // queueing samples
+    SDL_AudioSpec obtainedSpec;
+    SDL_memset(&obtainedSpec, 0, sizeof(obtainedSpec));
+    SDL_AudioDeviceID deviceId = SDL_OpenAudioDevice(
+        NULL, 0, &spec, &obtainedSpec, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
+    if (deviceId == 0) {
+        // Emulation still runs, samples are dropped
+        LOGE(TAG, "Failed to open audio device: %s", SDL_GetError());
+        return 0;
+    }
+
+    LOGI(TAG, "Audio device rate: %d Hz", obtainedSpec.freq);
+
+    m_Resampler = std::make_unique<Resampler>(
+        m_SnesConfig.audioSampleRate, obtainedSpec.freq);
+
+    m_AudioRing = std::make_unique<AudioRing>(
+        obtainedSpec.freq * kAudioDeviceSampleSize); // 1 s
+    m_AudioTargetFill = obtainedSpec.freq * kAudioDeviceSampleSize *
+        kAudioTargetLatencyMs / 1000;
+
     SDL_PauseAudioDevice(deviceId, 0);
 
     return 0;
@@ -90,6 +202,9 @@ int FrontendSdl2::run()
 {
     bool run = true;
 
+    // Emulation only waits for its own period, not for presentation
+    m_EmulationThread = std::thread(&FrontendSdl2::emulationThread, this);
+
     auto presentTp = std::chrono::high_resolution_clock::now() + kRenderPeriod;
 
     while (run) {
@@ -192,20 +307,12 @@ int FrontendSdl2::run()
             }
         }
 
-        checkRecorder();
-
-        if (m_Running) {
-            m_Snes->setController1(m_Controller1);
+        m_Controller1Latch = packController(m_Controller1);
 
-            if (m_SpeedUp) {
-                for (int i = 0; i < kSpeedupFrameSkip; i++) {
-                    m_Snes->renderSingleFrame(false);
-                }
-            }
-
-            // Render texture
-            m_TextureData = m_GlRenderer->bindBackbuffer();
-            m_Snes->renderSingleFrame();
+        // Upload the last emulated frame, if any since the previous one
+        if (m_FrameBuffers->update()) {
+            uint8_t* textureData = m_GlRenderer->bindBackbuffer();
+            memcpy(textureData, m_FrameBuffers->getFrontBuffer(), m_FrameSize);
             m_GlRenderer->unbindBackbuffer();
         }
 
@@ -217,20 +324,115 @@ int FrontendSdl2::run()
         presentTp += kRenderPeriod;
     }
 
+    m_Quit = true;
+    m_EmulationThread.join();
+
     return true;
 }
 
+void FrontendSdl2::runOnEmulationThread(std::function<void()> task)
+{
+    std::unique_lock<std::mutex> lock(m_TasksMutex);
+    m_Tasks.push_back(std::move(task));
+}
+
+void FrontendSdl2::runTasks()
+{
+    std::vector<std::function<void()>> tasks;
+
+    {
+        std::unique_lock<std::mutex> lock(m_TasksMutex);
+        std::swap(tasks, m_Tasks);
+    }
+
+    for (const auto& task : tasks) {
+        task();
+    }
+}
+
+void FrontendSdl2::emulationThread()
+{
+    auto frameTp = std::chrono::high_resolution_clock::now() + kRenderPeriod;
+
+    while (!m_Quit) {
+        runTasks();
+        checkRecorder();
+        logAudioStats();
+
+        emulateFrame();
+
+        std::this_thread::sleep_until(frameTp);
+        frameTp += kRenderPeriod;
+    }
+}
+
+void FrontendSdl2::emulateFrame()
+{
+    if (!m_Running) {
+        return;
+    }
+
+    m_Snes->setController1(unpackController(m_Controller1Latch));
+
+    if (m_Rewinding) {
+        // One snapshot back per frame, stay on the oldest one
+        if (m_RewindBuffer->stepBack() == 0) {
+            renderFrame();
+        }
+
+        return;
+    }
+
+    if (m_SpeedUp) {
+        for (int i = 0; i < kSpeedupFrameSkip; i++) {
+            m_Snes->renderSingleFrame(false);
+
+            if (m_RewindBuffer) {
+                m_RewindBuffer->onFrameEnded();
+            }
+        }
+    }
+
+    renderFrame();
+
+    if (m_RewindBuffer) {
+        m_RewindBuffer->onFrameEnded();
+    }
+}
+
+void FrontendSdl2::renderFrame()
+{
+    m_RunAhead->renderSingleFrame();
+
+    // Hand the frame to the render thread and draw the next one elsewhere
+    m_FrameBuffers->publish();
+    setFramebuffer();
+}
+
+void FrontendSdl2::setFramebuffer()
+{
+    msfce::core::Framebuffer framebuffer;
+    framebuffer.data = m_FrameBuffers->getBackBuffer();
+    framebuffer.format = kFrameFormat;
+    framebuffer.pitch = m_SnesConfig.displayWidth *
+                        msfce::core::getPixelSize(framebuffer.format);
+
+    m_Snes->setFramebuffer(framebuffer);
+}
+
 void FrontendSdl2::scanStarted()
 {
 }
 
-void FrontendSdl2::drawPixel(const msfce::core::Color& c)
+void FrontendSdl2::drawFrame(const msfce::core::FrameView& frame)
 {
-    m_TextureData[0] = c.r;
-    m_TextureData[1] = c.g;
-    m_TextureData[2] = c.b;
+    assert(frame.format == kFrameFormat);
 
-    m_TextureData += 3;
+    // Brightness is applied by the renderer
+    memcpy(
+        m_FrameBuffers->getBackBuffer() + m_FramePixelsSize,
+        frame.brightness,
+        frame.height);
 }
 
 void FrontendSdl2::scanEnded()
@@ -242,12 +444,14 @@ bool FrontendSdl2::handleShortcut(SDL_Scancode scancode, bool pressed)
     switch (scancode) {
     case SDL_SCANCODE_O:
         if (pressed) {
-            if (!m_Recorder) {
-                initRecorder();
-            }
+            runOnEmulationThread([this]() {
+                if (!m_Recorder) {
+                    initRecorder();
+                }
 
-            assert(m_Recorder);
-            m_Recorder->toggleVideoRecord();
+                assert(m_Recorder);
+                m_Recorder->toggleVideoRecord();
+            });
         }
 
         break;
@@ -283,29 +487,48 @@ bool FrontendSdl2::handleShortcut(SDL_Scancode scancode, bool pressed)
         }
         break;
 
+    case SDL_SCANCODE_BACKSPACE:
+        if (!m_RewindBuffer) {
+            break;
+        }
+
+        if (pressed) {
+            LOGI(TAG, "Rewind");
+        } else {
+            LOGI(TAG, "Rewind done");
+        }
+
+        m_Rewinding = pressed;
+        break;
+
     case SDL_SCANCODE_F2: {
         if (pressed) {
-            m_Snes->saveState(getSavestateName());
+            runOnEmulationThread(
+                [this]() { m_Snes->saveState(getSavestateName()); });
         }
         break;
     }
 
     case SDL_SCANCODE_F4: {
         if (pressed) {
-            m_AudioSamplesUsed = 0;
-            m_Snes->loadState(getSavestateName());
+            runOnEmulationThread([this]() {
+                m_AudioFlush = true;
+                m_Snes->loadState(getSavestateName());
+            });
         }
         break;
     }
 
     case SDL_SCANCODE_F8: {
         if (pressed) {
-            if (!m_Recorder) {
-                initRecorder();
-            }
+            runOnEmulationThread([this]() {
+                if (!m_Recorder) {
+                    initRecorder();
+                }
 
-            assert(m_Recorder);
-            m_Recorder->takeScreenshot();
+                assert(m_Recorder);
+                m_Recorder->takeScreenshot();
+            });
         }
         break;
     }
@@ -379,25 +602,93 @@ void FrontendSdl2::checkRecorder()
 
 void FrontendSdl2::playAudioSamples(const uint8_t* data, size_t sampleCount)
 {
-    std::unique_lock<std::mutex> lock(m_AudioSamplesMutex);
-
-    const size_t sampleSize = sampleCount * m_SnesConfig.audioSampleSize;
-
-    if (kAudioSamplesSize >= m_AudioSamplesUsed + sampleSize) {
-        memcpy(m_AudioSamples + m_AudioSamplesUsed, data, sampleSize);
-        m_AudioSamplesUsed += sampleSize;
+    // Frames played backwards would sound like glitches
+    if (!m_AudioRing || m_Rewinding) {
+        return;
     }
+
+    // Dynamic rate control: produce slightly more or less samples to stay
+    // around the target latency, absorbing the drift between emulation
+    // and device clocks
+    double fillDelta = 1.0 -
+        static_cast<double>(m_AudioRing->getFillLevel()) / m_AudioTargetFill;
+    fillDelta = std::clamp(fillDelta, -1.0, 1.0);
+    m_Resampler->setRateAdjust(1.0 + fillDelta * kAudioMaxRateDelta);
+
+    size_t outputMaxCount = m_Resampler->getMaxOutputCount(sampleCount);
+    m_ResamplerOutput.resize(outputMaxCount * kAudioDeviceChannels);
+
+    size_t outputCount = m_Resampler->process(
+        reinterpret_cast<const int16_t*>(data),
+        sampleCount,
+        m_ResamplerOutput.data(),
+        outputMaxCount);
+
+    m_AudioRing->write(
+        reinterpret_cast<const uint8_t*>(m_ResamplerOutput.data()),
+        outputCount * kAudioDeviceSampleSize);
 }
 
 void FrontendSdl2::onSdlPlayCb(Uint8* stream, int len)
 {
-    std::unique_lock<std::mutex> lock(m_AudioSamplesMutex);
+    // Samples queued before a state load don't belong to the new timeline
+    if (m_AudioFlush.exchange(false)) {
+        m_AudioRing->flush();
+        m_AudioPriming = true;
+    }
 
-    if ((int)m_AudioSamplesUsed >= len) {
-        memcpy(stream, m_AudioSamples, len);
-        memmove(m_AudioSamples, &m_AudioSamples[len], m_AudioSamplesUsed - len);
-        m_AudioSamplesUsed -= len;
-    } else {
+    // No samples are produced while paused or rewinding, draining the ring
+    // would only count underruns. Queued ones are kept for resume.
+    if (!m_Running || m_Rewinding) {
         memset(stream, 0, len);
+        m_AudioPriming = true;
+        return;
+    }
+
+    // Once dry, wait for the target latency to be queued again
+    if (m_AudioPriming) {
+        if (m_AudioRing->getFillLevel() < m_AudioTargetFill) {
+            memset(stream, 0, len);
+            return;
+        }
+
+        m_AudioPriming = false;
+    } else if (m_AudioRing->getFillLevel() < static_cast<size_t>(len)) {
+        m_AudioPriming = true;
     }
+
+    m_AudioRing->read(stream, len);
+}
+
+void FrontendSdl2::logAudioStats()
+{
+    if (!m_AudioRing) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < m_AudioStatsTp) {
+        return;
+    }
+
+    m_AudioStatsTp = now + kAudioStatsPeriod;
+
+    AudioRing::Stats stats = m_AudioRing->getStats();
+    if (stats.underruns != m_AudioStats.underruns ||
+        stats.overruns != m_AudioStats.overruns) {
+        LOGW(
+            TAG,
+            "Audio: %" PRIu64 " underruns, %" PRIu64 " overruns",
+            stats.underruns - m_AudioStats.underruns,
+            stats.overruns - m_AudioStats.overruns);
+    }
+
+    LOGD(
+        TAG,
+        "Audio: fill level %zu-%zu/%zu bytes",
+        stats.minFill,
+        stats.maxFill,
+        m_AudioRing->getSize());
+
+    m_AudioStats = stats;
 }
@@ -1,13 +1,24 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <epoxy/gl.h>
 #include <SDL.h>
 
+#include <msfce/core/rewindbuffer.h>
+#include <msfce/core/runahead.h>
+
+#include "audioring.h"
 #include "renderer_gl.h"
+#include "resampler.h"
 #include "frontend.h"
+#include "triplebuffer.h"
 
 namespace msfce::recorder {
 
@@ -19,7 +30,8 @@ class FrontendSdl2
     : public Frontend
     , public msfce::core::Renderer {
 public:
-    FrontendSdl2();
+    // Rewind is disabled if `rewindSize` is 0
+    FrontendSdl2(size_t rewindSize, int rewindInterval, int runAheadFrames);
     ~FrontendSdl2();
 
     /// Frontend methods
@@ -28,7 +40,7 @@ public:
 
     // msfce::core::Renderer methods
     void scanStarted() final;
-    void drawPixel(const msfce::core::Color& c) final;
+    void drawFrame(const msfce::core::FrameView& frame) final;
     void scanEnded() final;
 
     void playAudioSamples(const uint8_t* data, size_t sampleCount) final;
@@ -36,6 +48,15 @@ public:
 private:
     bool handleShortcut(SDL_Scancode scancode, bool pressed);
 
+    // Run on the emulation thread before its next frame
+    void runOnEmulationThread(std::function<void()> task);
+    void runTasks();
+
+    void emulationThread();
+    void emulateFrame();
+    void renderFrame();
+    void setFramebuffer();
+
     std::string getSavestateName() const;
 
     void onJoystickAdded(int index);
@@ -47,6 +68,7 @@ private:
 
 private:
     void onSdlPlayCb(Uint8* stream, int len);
+    void logAudioStats();
 
 private:
     SDL_Window* m_Window = nullptr;
@@ -56,23 +78,51 @@ private:
 
     SDL_GLContext m_GlContext = nullptr;
     std::unique_ptr<RendererGl> m_GlRenderer;
-    GLubyte* m_TextureData = nullptr;
+    size_t m_FrameSize = 0;
+    size_t m_FramePixelsSize = 0;
+
+    // PPU draws in the back buffer, presented from the front one
+    std::unique_ptr<TripleBuffer> m_FrameBuffers;
 
     SDL_Joystick* m_Joystick = nullptr;
 
     std::shared_ptr<msfce::core::Snes> m_Snes;
     msfce::core::SnesConfig m_SnesConfig;
+
+    // Updated by events, latched for the emulation thread once per loop
     msfce::core::Controller m_Controller1;
+    std::atomic<uint16_t> m_Controller1Latch{0};
+
+    // Emulation thread
+    std::thread m_EmulationThread;
+    std::atomic<bool> m_Quit{false};
+
+    std::mutex m_TasksMutex;
+    std::vector<std::function<void()>> m_Tasks;
 
     // Scheduling
-    bool m_Running = true;
-    bool m_SpeedUp = false;
-
-    // Audio
-    std::mutex m_AudioSamplesMutex;
-    static constexpr int kAudioSamplesSize = 32000 * 2 * 2; // 1 s
-    uint8_t m_AudioSamples[kAudioSamplesSize];
-    size_t m_AudioSamplesUsed = 0;
+    std::atomic<bool> m_Running{true};
+    std::atomic<bool> m_SpeedUp{false};
+
+    // Rewind
+    size_t m_RewindSize;
+    int m_RewindInterval;
+    std::unique_ptr<msfce::core::RewindBuffer> m_RewindBuffer;
+    std::atomic<bool> m_Rewinding{false};
+
+    // Run-ahead
+    int m_RunAheadFrames;
+    std::unique_ptr<msfce::core::RunAhead> m_RunAhead;
+
+    // Audio, resampled to the device rate
+    std::unique_ptr<Resampler> m_Resampler;
+    std::vector<int16_t> m_ResamplerOutput;
+    std::unique_ptr<AudioRing> m_AudioRing;
+    size_t m_AudioTargetFill = 0;
+    std::atomic<bool> m_AudioFlush{false};
+    bool m_AudioPriming = true;
+    AudioRing::Stats m_AudioStats;
+    std::chrono::steady_clock::time_point m_AudioStatsTp;
 
     // Recorder
     std::shared_ptr<msfce::recorder::Recorder> m_Recorder;
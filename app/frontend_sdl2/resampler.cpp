@@ -0,0 +1,159 @@
+#include <assert.h>
+#include <math.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
+#include "resampler.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Passband edge, relative to the Nyquist frequency of the lowest rate
+constexpr double kCutoff = 0.9;
+
+double sinc(double x)
+{
+    if (x == 0) {
+        return 1;
+    }
+
+    return sin(kPi * x) / (kPi * x);
+}
+
+double blackman(double x)
+{
+    // x in [0, 1]
+    return 0.42 - 0.5 * cos(2 * kPi * x) + 0.08 * cos(4 * kPi * x);
+}
+
+} // anonymous namespace
+
+Resampler::Resampler(int inputRate, int outputRate)
+    : m_Ratio(static_cast<double>(inputRate) / outputRate)
+    , m_Step(m_Ratio)
+    , m_Filter((kPhases + 1) * kTaps * kChannels)
+    , m_History(kTaps * kChannels)
+{
+    const double cutoff = kCutoff * std::min(1.0, 1 / m_Ratio);
+
+    for (int phase = 0; phase <= kPhases; phase++) {
+        float* taps = &m_Filter[phase * kTaps * kChannels];
+        double sum = 0;
+
+        for (int i = 0; i < kTaps; i++) {
+            // Distance to the output sample, between taps kTaps/2-1 and
+            // kTaps/2 for a phase between 0 and 1
+            double x =
+                i - (kTaps / 2 - 1) - static_cast<double>(phase) / kPhases;
+            double window = blackman((x + kTaps / 2) / kTaps);
+            double tap = cutoff * sinc(cutoff * x) * window;
+
+            taps[i * kChannels] = tap;
+            sum += tap;
+        }
+
+        // Unity gain
+        for (int i = 0; i < kTaps; i++) {
+            taps[i * kChannels] /= sum;
+            taps[i * kChannels + 1] = taps[i * kChannels];
+        }
+    }
+}
+
+void Resampler::setRateAdjust(double adjust)
+{
+    assert(adjust > 0);
+    m_Step = m_Ratio / adjust;
+}
+
+size_t Resampler::process(
+    const int16_t* input,
+    size_t inputCount,
+    int16_t* output,
+    size_t outputMaxCount)
+{
+    size_t historySize = m_History.size();
+
+    m_History.resize(historySize + inputCount * kChannels);
+    for (size_t i = 0; i < inputCount * kChannels; i++) {
+        m_History[historySize + i] = input[i];
+    }
+
+    const size_t available = m_History.size() / kChannels - kTaps;
+    size_t outputCount = 0;
+
+    while (outputCount < outputMaxCount && m_Pos < available) {
+        size_t pos = m_Pos;
+        double frac = (m_Pos - pos) * kPhases;
+        int phase = frac;
+        float mix = frac - phase;
+
+        float a[kChannels];
+        float b[kChannels];
+
+        const float* history = &m_History[(pos + 1) * kChannels];
+        filter(history, phase, a);
+        filter(history, phase + 1, b);
+
+        for (int c = 0; c < kChannels; c++) {
+            float sample = a[c] + (b[c] - a[c]) * mix;
+            sample = std::clamp(sample, -32768.0f, 32767.0f);
+            output[outputCount * kChannels + c] = lrintf(sample);
+        }
+
+        outputCount++;
+        m_Pos += m_Step;
+    }
+
+    // Keep unconsumed input and the history needed by the next samples
+    size_t consumed = std::min<size_t>(m_Pos, available);
+    m_History.erase(
+        m_History.begin(), m_History.begin() + consumed * kChannels);
+    m_Pos -= consumed;
+
+    return outputCount;
+}
+
+size_t Resampler::getMaxOutputCount(size_t inputCount) const
+{
+    return ceil((inputCount + 1) / m_Step);
+}
+
+void Resampler::filter(const float* history, int phase, float* out) const
+{
+    const float* taps = &m_Filter[phase * kTaps * kChannels];
+
+#if defined(__SSE2__)
+    // Two stereo samples per vector
+    __m128 acc = _mm_setzero_ps();
+
+    for (int i = 0; i < kTaps * kChannels; i += 4) {
+        __m128 s = _mm_loadu_ps(history + i);
+        __m128 t = _mm_loadu_ps(taps + i);
+        acc = _mm_add_ps(acc, _mm_mul_ps(s, t));
+    }
+
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+
+    float sums[4];
+    _mm_storeu_ps(sums, acc);
+    out[0] = sums[0];
+    out[1] = sums[1];
+#else
+    float sums[kChannels] = {};
+
+    for (int i = 0; i < kTaps; i++) {
+        for (int c = 0; c < kChannels; c++) {
+            sums[c] += history[i * kChannels + c] * taps[i * kChannels + c];
+        }
+    }
+
+    out[0] = sums[0];
+    out[1] = sums[1];
+#endif
+}
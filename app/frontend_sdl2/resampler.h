@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <vector>
+
+// Stereo S16 resampler using a polyphase windowed sinc filter. The ratio
+// can be slightly adjusted at any time to follow the consumer speed.
+class Resampler {
+public:
+    Resampler(int inputRate, int outputRate);
+
+    // Produce `adjust` times the nominal output sample count
+    void setRateAdjust(double adjust);
+
+    // Returns the produced sample count, at most `outputMaxCount`. Input
+    // samples are all consumed, unless output is full.
+    size_t process(
+        const int16_t* input,
+        size_t inputCount,
+        int16_t* output,
+        size_t outputMaxCount);
+
+    // Output samples produced for `inputCount` samples, rounded up
+    size_t getMaxOutputCount(size_t inputCount) const;
+
+private:
+    static constexpr int kTaps = 16;
+    static constexpr int kPhases = 64;
+
+    // Interleaved stereo
+    static constexpr int kChannels = 2;
+
+private:
+    void filter(const float* history, int phase, float* out) const;
+
+private:
+    double m_Ratio;
+    double m_Step;
+
+    // Taps of each phase, duplicated for both channels. One phase more
+    // to interpolate the last one.
+    std::vector<float> m_Filter;
+
+    // Pending input, starting with kTaps samples of history
+    std::vector<float> m_History;
+    double m_Pos = 0;
+};
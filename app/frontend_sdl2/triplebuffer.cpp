@@ -0,0 +1,37 @@
+#include "triplebuffer.h"
+
+TripleBuffer::TripleBuffer(size_t size)
+{
+    for (auto& buffer : m_Buffers) {
+        buffer.resize(size);
+    }
+}
+
+uint8_t* TripleBuffer::getBackBuffer()
+{
+    return m_Buffers[m_Back].data();
+}
+
+void TripleBuffer::publish()
+{
+    // Release the back buffer content, acquire the consumer's old one
+    int middle = m_Middle.exchange(m_Back | kDirty, std::memory_order_acq_rel);
+    m_Back = middle & kIndexMask;
+}
+
+bool TripleBuffer::update()
+{
+    if (!(m_Middle.load(std::memory_order_relaxed) & kDirty)) {
+        return false;
+    }
+
+    int middle = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+    m_Front = middle & kIndexMask;
+
+    return true;
+}
+
+const uint8_t* TripleBuffer::getFrontBuffer() const
+{
+    return m_Buffers[m_Front].data();
+}
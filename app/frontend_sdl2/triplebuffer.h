@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <vector>
+
+// Lock-free handover of frames from a single producer to a single consumer.
+// The producer always has a buffer to write, the consumer always has the
+// last complete one, the third one is exchanged between them.
+class TripleBuffer {
+public:
+    TripleBuffer(size_t size);
+
+    // Producer side
+    uint8_t* getBackBuffer();
+    void publish();
+
+    // Consumer side, returns true if a new frame became the front one
+    bool update();
+    const uint8_t* getFrontBuffer() const;
+
+private:
+    // Set on the middle index once published, until the consumer takes it
+    static constexpr int kDirty = 1 << 2;
+    static constexpr int kIndexMask = kDirty - 1;
+
+private:
+    std::vector<uint8_t> m_Buffers[3];
+
+    int m_Back = 0;
+    std::atomic<int> m_Middle{1};
+    int m_Front = 2;
+};
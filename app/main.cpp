@@ -1,8 +1,15 @@
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <getopt.h>
 
+#include <string>
+
 #include <msfce/core/log.h>
+#include <msfce/core/runahead.h>
 #include <msfce/core/snes.h>
+#include "frontend_headless/frontend_headless.h"
 #include "frontend_sdl2/frontend_sdl2.h"
 
 #define TAG "main"
@@ -10,6 +17,21 @@
 struct Params {
     bool help = false;
     bool verbose = false;
+    bool skipIdleLoops = false;
+    bool threadedApu = false;
+    msfce::core::DspType dsp = msfce::core::DspType::accurate;
+
+    // Rewind
+    int rewindSizeMb = 64;
+    int rewindInterval = 2;
+
+    int runAheadFrames = 0;
+
+    // Headless benchmark
+    bool headless = false;
+    int frames = 600;
+    std::string statePath;
+    bool noRender = false;
 };
 
 int parseArgs(int argc, char* argv[], Params* params)
@@ -21,10 +43,21 @@ int parseArgs(int argc, char* argv[], Params* params)
     const struct option argsOptions[] = {
         {"help", optional_argument, 0, 'h'},
         {"verbose", optional_argument, 0, 'v'},
+        {"idle-skip", optional_argument, 0, 'i'},
+        {"threaded-apu", optional_argument, 0, 't'},
+        {"dsp", required_argument, 0, 'd'},
+        {"rewind-size", required_argument, 0, 'r'},
+        {"rewind-interval", required_argument, 0, 'R'},
+        {"run-ahead", required_argument, 0, 'a'},
+        {"headless", optional_argument, 0, 'H'},
+        {"frames", required_argument, 0, 'f'},
+        {"state", required_argument, 0, 's'},
+        {"no-render", optional_argument, 0, 'n'},
         {0, 0, 0, 0}};
 
     while (true) {
-        value = getopt_long(argc, argv, "hv", argsOptions, &optionIndex);
+        value = getopt_long(
+            argc, argv, "hvitd:r:R:a:Hf:s:n", argsOptions, &optionIndex);
         if (value == -1 || value == '?')
             break;
 
@@ -37,6 +70,53 @@ int parseArgs(int argc, char* argv[], Params* params)
             params->verbose = true;
             break;
 
+        case 'i':
+            params->skipIdleLoops = true;
+            break;
+
+        case 't':
+            params->threadedApu = true;
+            break;
+
+        case 'd':
+            if (!strcmp(optarg, "accurate")) {
+                params->dsp = msfce::core::DspType::accurate;
+            } else if (!strcmp(optarg, "fast")) {
+                params->dsp = msfce::core::DspType::fast;
+            } else {
+                LOGE(TAG, "Unknown DSP '%s'", optarg);
+                return -EINVAL;
+            }
+            break;
+
+        case 'r':
+            params->rewindSizeMb = atoi(optarg);
+            break;
+
+        case 'R':
+            params->rewindInterval = atoi(optarg);
+            break;
+
+        case 'a':
+            params->runAheadFrames = atoi(optarg);
+            break;
+
+        case 'H':
+            params->headless = true;
+            break;
+
+        case 'f':
+            params->frames = atoi(optarg);
+            break;
+
+        case 's':
+            params->statePath = optarg;
+            break;
+
+        case 'n':
+            params->noRender = true;
+            break;
+
         default:
             break;
         }
@@ -47,7 +127,11 @@ int parseArgs(int argc, char* argv[], Params* params)
 
 void printHelp(int argc, char* argv[])
 {
-    printf("Usage: %s [-h] [-v] rom\n\n", argv[0]);
+    printf(
+        "Usage: %s [-h] [-v] [-i] [-t] [-d DSP] [-r SIZE] [-R FRAMES] "
+        "[-a FRAMES] "
+        "[-H [-f FRAMES] [-s STATE] [-n]] rom\n\n",
+        argv[0]);
 
     printf("positional arguments:\n");
     printf("  %-20s %s\n", "rom", "Rom to load");
@@ -56,6 +140,46 @@ void printHelp(int argc, char* argv[])
     printf("optional arguments:\n");
     printf("  %-20s %s\n", "-h, --help", "show this help message and exit");
     printf("  %-20s %s\n", "-v, --verbose", "add extra logs");
+    printf(
+        "  %-20s %s\n",
+        "-i, --idle-skip",
+        "fast-forward loops waiting for V-Blank or IRQ");
+    printf(
+        "  %-20s %s\n",
+        "-t, --threaded-apu",
+        "emulate the APU on its own thread");
+    printf(
+        "  %-20s %s\n",
+        "-d, --dsp DSP",
+        "accurate or fast, the latter isn't bit-exact (default: accurate)");
+    printf(
+        "  %-20s %s\n",
+        "-r, --rewind-size SIZE",
+        "rewind history in MB, 0 to disable (default: 64)");
+    printf(
+        "  %-20s %s\n",
+        "-R, --rewind-interval FRAMES",
+        "frames between two rewind snapshots (default: 2)");
+    printf(
+        "  %-20s %s\n",
+        "-a, --run-ahead FRAMES",
+        "frames to run ahead to hide input lag, up to 4 (default: 0)");
+    printf(
+        "  %-20s %s\n",
+        "-H, --headless",
+        "run frames without display nor pacing and print timings");
+    printf(
+        "  %-20s %s\n",
+        "-f, --frames FRAMES",
+        "number of frames to run in headless mode (default: 600)");
+    printf(
+        "  %-20s %s\n",
+        "-s, --state STATE",
+        "save state to load before running in headless mode");
+    printf(
+        "  %-20s %s\n",
+        "-n, --no-render",
+        "skip PPU rendering in headless mode");
 }
 
 int main(int argc, char* argv[])
@@ -64,7 +188,9 @@ int main(int argc, char* argv[])
     int ret;
 
     ret = parseArgs(argc, argv, &params);
-    if (ret < 0 || optind == argc) {
+    if (ret < 0 || optind == argc || params.rewindSizeMb < 0 ||
+        params.rewindInterval <= 0 || params.runAheadFrames < 0 ||
+        params.runAheadFrames > msfce::core::RunAhead::kMaxFrames) {
         printHelp(argc, argv);
         return 0;
     }
@@ -73,21 +199,48 @@ int main(int argc, char* argv[])
         logSetLevel(LOG_DEBUG);
     }
 
-    // Create frontend
-    auto frontend = std::make_shared<FrontendSdl2>();
-
     // Create and run SNES
     const char* romPath = argv[optind];
 
-    auto snes = msfce::core::Snes::create();
-    snes->addRenderer(frontend);
+    auto snes = msfce::core::Snes::create(params.dsp);
+    snes->setIdleLoopSkip(params.skipIdleLoops);
+    snes->setThreadedApu(params.threadedApu);
 
     ret = snes->plugCartidge(romPath);
     if (ret < 0) {
-        snes->removeRenderer(frontend);
         return 1;
     }
 
+    if (params.headless) {
+        if (!params.verbose) {
+            logSetLevel(LOG_WARN);
+        }
+
+        FrontendHeadless frontend(
+            params.frames,
+            params.statePath,
+            !params.noRender,
+            params.runAheadFrames);
+
+        snes->start();
+
+        ret = frontend.init(snes);
+        if (ret == 0) {
+            ret = frontend.run();
+        }
+
+        snes->stop();
+
+        return ret < 0 ? 1 : 0;
+    }
+
+    // Create frontend
+    auto frontend = std::make_shared<FrontendSdl2>(
+        static_cast<size_t>(params.rewindSizeMb) * 1024 * 1024,
+        params.rewindInterval,
+        params.runAheadFrames);
+    snes->addRenderer(frontend);
+
     snes->start();
 
     // Run frontend
@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <string.h>
 #include <time.h>
 
 #include <msfce/core/log.h>
@@ -41,6 +42,57 @@ std::string getDate()
 #endif
 }
 
+void convertLineToRgb24(
+    const msfce::core::FrameView& frame,
+    int y,
+    uint8_t* rgb)
+{
+    using msfce::core::PixelFormat;
+
+    const uint8_t* line = frame.data + y * frame.pitch;
+
+    if (frame.format == PixelFormat::RGB24) {
+        memcpy(rgb, line, frame.width * 3);
+        return;
+    }
+
+    auto scale5 = [](uint32_t c) -> uint8_t { return c * 255 / 0b11111; };
+    auto scale6 = [](uint32_t c) -> uint8_t { return c * 255 / 0b111111; };
+
+    for (int x = 0; x < frame.width; x++, rgb += 3) {
+        switch (frame.format) {
+        case PixelFormat::XRGB8888: {
+            uint32_t c = reinterpret_cast<const uint32_t*>(line)[x];
+            rgb[0] = c >> 16;
+            rgb[1] = c >> 8;
+            rgb[2] = c;
+            break;
+        }
+
+        case PixelFormat::RGB565: {
+            uint16_t c = reinterpret_cast<const uint16_t*>(line)[x];
+            rgb[0] = scale5(c >> 11);
+            rgb[1] = scale6((c >> 5) & 0b111111);
+            rgb[2] = scale5(c & 0b11111);
+            break;
+        }
+
+        case PixelFormat::BGR555: {
+            uint16_t c = reinterpret_cast<const uint16_t*>(line)[x];
+            int brightness = frame.brightness[y] + 1;
+            rgb[0] = scale5(c & 0b11111) * brightness / 16;
+            rgb[1] = scale5((c >> 5) & 0b11111) * brightness / 16;
+            rgb[2] = scale5((c >> 10) & 0b11111) * brightness / 16;
+            break;
+        }
+
+        default:
+            assert(false);
+            break;
+        }
+    }
+}
+
 } // anonymous namespace
 
 namespace msfce::recorder {
@@ -76,26 +128,28 @@ void Recorder::scanStarted()
     m_Started = true;
 
     m_BackBuffer = std::make_shared<Frame>(FrameType::video, m_ImgSize);
-    m_BackBufferWritter = m_BackBuffer->payload.data();
 
-    m_AudioFrame =
-        std::make_shared<Frame>(FrameType::audio, m_AudioFrameMaxSize);
+    // Samples of frames without video may already be there
+    if (!m_AudioFrame) {
+        m_AudioFrame =
+            std::make_shared<Frame>(FrameType::audio, m_AudioFrameMaxSize);
+    }
 }
 
-void Recorder::drawPixel(const msfce::core::Color& c)
+void Recorder::drawFrame(const msfce::core::FrameView& frame)
 {
     if (!m_Started) {
         return;
     }
 
     assert(m_BackBuffer);
-    assert(m_BackBufferWritter);
 
-    m_BackBufferWritter[0] = c.r;
-    m_BackBufferWritter[1] = c.g;
-    m_BackBufferWritter[2] = c.b;
+    uint8_t* rgb = m_BackBuffer->payload.data();
+    const int rgbStride = m_SnesConfig.displayWidth * kRgbSampleSize;
 
-    m_BackBufferWritter += 3;
+    for (int y = 0; y < frame.height; y++) {
+        convertLineToRgb24(frame, y, rgb + y * rgbStride);
+    }
 }
 
 void Recorder::scanEnded()
@@ -134,7 +188,6 @@ void Recorder::scanEnded()
     }
 
     m_BackBuffer = nullptr;
-    m_BackBufferWritter = nullptr;
 
     m_AudioFrame = nullptr;
 }
@@ -145,6 +198,11 @@ void Recorder::playAudioSamples(const uint8_t* data, size_t sampleCount)
         return;
     }
 
+    if (!m_AudioFrame) {
+        m_AudioFrame =
+            std::make_shared<Frame>(FrameType::audio, m_AudioFrameMaxSize);
+    }
+
     const size_t payloadRequiredSize =
         (m_AudioFrame->sampleCount + sampleCount) *
         m_SnesConfig.audioSampleSize;
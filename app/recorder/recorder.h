@@ -26,7 +26,7 @@ public:
 
     // Draw API
     void scanStarted() final;
-    void drawPixel(const msfce::core::Color& c) final;
+    void drawFrame(const msfce::core::FrameView& frame) final;
     void scanEnded() final;
 
     void playAudioSamples(const uint8_t* data, size_t sampleCount);
@@ -50,7 +50,6 @@ private:
 
     // Video
     std::shared_ptr<Frame> m_BackBuffer;
-    uint8_t* m_BackBufferWritter = nullptr;
     int m_VideoFrameReceived = 0;
 
     // Audio
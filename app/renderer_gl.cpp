@@ -1,3 +1,5 @@
+#include <errno.h>
+
 #include <string>
 
 #define GLM_ENABLE_EXPERIMENTAL
@@ -14,6 +16,11 @@ namespace {
 
 #define SIZEOF_ARRAY(x) (sizeof(x) / sizeof((x)[0]))
 
+// Offset alignment of each PBO slot
+constexpr size_t kPboAlignment = 256;
+
+constexpr GLuint64 kFenceTimeoutNs = 100 * 1000 * 1000;
+
 // clang-format off
 const char *vertexShader =
     "#version 130\n"
@@ -29,18 +36,27 @@ const char *vertexShader =
     "    TexCoord = vec2(aTexCoord.x, aTexCoord.y);"
     "}";
 
+// Same integer math as the PPU RGB24 output
 const char *fragmentShader =
     "#version 130\n"
     "out vec4 FragColor;"
 
-    "in vec3 ourColor;"
     "in vec2 TexCoord;"
 
-    "uniform sampler2D texture1;"
+    "uniform usampler2D screen;"
+    "uniform usampler2D brightness;"
 
     "void main()"
     "{"
-    "    FragColor = texture(texture1, TexCoord);"
+    "    ivec2 size = textureSize(screen, 0);"
+    "    ivec2 pos = min(ivec2(TexCoord * vec2(size)), size - 1);"
+
+    "    uint color = texelFetch(screen, pos, 0).r;"
+    "    uint level = texelFetch(brightness, ivec2(pos.y, 0), 0).r + 1u;"
+
+    "    uvec3 rgb = uvec3(color, color >> 5, color >> 10) & 31u;"
+    "    rgb = rgb * 255u / 31u * level / 16u;"
+    "    FragColor = vec4(vec3(rgb) / 255.0, 1.0);"
     "}";
 
 // clang-format on
@@ -112,6 +128,11 @@ int RendererGl::initContext()
     m_Shader = compileShader(vertexShader, fragmentShader);
     m_ScaleMatrixUniform = glGetUniformLocation(m_Shader, "scaleMatrix");
 
+    glUseProgram(m_Shader);
+    glUniform1i(glGetUniformLocation(m_Shader, "screen"), 0);
+    glUniform1i(glGetUniformLocation(m_Shader, "brightness"), 1);
+    glUseProgram(0);
+
     // Create VAO
     // clang-format off
     static const float vertices[] = {
@@ -151,7 +172,7 @@ int RendererGl::initContext()
         1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    // Create texture
+    // Create textures, integer ones so that the shader gets raw values
     glGenTextures(1, &m_Texture);
     glBindTexture(GL_TEXTURE_2D, m_Texture);
 
@@ -160,27 +181,74 @@ int RendererGl::initContext()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    m_TextureSize = m_SnesConfig.displayWidth * m_SnesConfig.displayHeight * 3;
-
     glTexImage2D(
         GL_TEXTURE_2D,
         0,
-        GL_RGB,
+        GL_R16UI,
         m_SnesConfig.displayWidth,
         m_SnesConfig.displayHeight,
         0,
-        GL_RGB,
+        GL_RED_INTEGER,
+        GL_UNSIGNED_SHORT,
+        nullptr);
+
+    // Brightness of each line
+    glGenTextures(1, &m_BrightnessTexture);
+    glBindTexture(GL_TEXTURE_2D, m_BrightnessTexture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage2D(
+        GL_TEXTURE_2D,
+        0,
+        GL_R8UI,
+        m_SnesConfig.displayHeight,
+        1,
+        0,
+        GL_RED_INTEGER,
         GL_UNSIGNED_BYTE,
         nullptr);
 
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    // Create PBO
+    m_PixelsSize = m_SnesConfig.displayWidth * m_SnesConfig.displayHeight *
+                   getPixelSize(msfce::core::PixelFormat::BGR555);
+    m_FrameSize = m_PixelsSize + m_SnesConfig.displayHeight;
+
+    // Create PBO, a persistently mapped ring if supported
+    m_PersistentPbo = epoxy_gl_version() >= 44 ||
+                      epoxy_has_gl_extension("GL_ARB_buffer_storage");
+
     glGenBuffers(1, &m_PBO);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PBO);
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, m_TextureSize, 0, GL_STREAM_DRAW);
+
+    if (m_PersistentPbo) {
+        const GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        m_PboSlotSize =
+            (m_FrameSize + kPboAlignment - 1) & ~(kPboAlignment - 1);
+        const size_t pboSize = m_PboSlotSize * kPboSlotCount;
+
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, pboSize, nullptr, flags);
+        m_PboData = static_cast<uint8_t*>(
+            glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, pboSize, flags));
+        if (!m_PboData) {
+            LOGE(TAG, "Failed to map PBO");
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            return -EIO;
+        }
+    } else {
+        m_PboSlotSize = m_FrameSize;
+        glBufferData(
+            GL_PIXEL_UNPACK_BUFFER, m_FrameSize, nullptr, GL_STREAM_DRAW);
+    }
+
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
+    LOGI(TAG, "Persistent PBO: %s", m_PersistentPbo ? "yes" : "no");
+
     return 0;
 }
 
@@ -227,23 +295,81 @@ void RendererGl::setViewport()
     glViewport(0, 0, m_WindowWidth, m_WindowHeight);
 }
 
+size_t RendererGl::getFrameSize() const
+{
+    return m_FrameSize;
+}
+
 uint8_t* RendererGl::bindBackbuffer()
 {
-    glBindTexture(GL_TEXTURE_2D, m_Texture);
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PBO);
+    if (!m_PersistentPbo) {
+        // Previous frame may still be read by the GPU, get a new storage
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PBO);
+
+        return static_cast<uint8_t*>(glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER,
+            0,
+            m_FrameSize,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    }
 
-    glTexSubImage2D(
-        GL_TEXTURE_2D, 0, 0, 0, 256, 224, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    // Slot was last uploaded kPboSlotCount frames ago, this rarely waits
+    GLsync& fence = m_PboFences[m_PboSlot];
+    if (fence) {
+        GLenum ret;
+
+        do {
+            ret = glClientWaitSync(
+                fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+        } while (ret == GL_TIMEOUT_EXPIRED);
 
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, m_TextureSize, 0, GL_STREAM_DRAW);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
 
-    return static_cast<uint8_t*>(
-        glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+    return m_PboData + m_PboSlot * m_PboSlotSize;
 }
 
 int RendererGl::unbindBackbuffer()
 {
-    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    size_t offset = 0;
+
+    if (m_PersistentPbo) {
+        offset = m_PboSlot * m_PboSlotSize;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PBO);
+    } else {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+
+    // Upload the frame that has just been written
+    glBindTexture(GL_TEXTURE_2D, m_Texture);
+    glTexSubImage2D(
+        GL_TEXTURE_2D,
+        0,
+        0,
+        0,
+        m_SnesConfig.displayWidth,
+        m_SnesConfig.displayHeight,
+        GL_RED_INTEGER,
+        GL_UNSIGNED_SHORT,
+        reinterpret_cast<const void*>(offset));
+
+    glBindTexture(GL_TEXTURE_2D, m_BrightnessTexture);
+    glTexSubImage2D(
+        GL_TEXTURE_2D,
+        0,
+        0,
+        0,
+        m_SnesConfig.displayHeight,
+        1,
+        GL_RED_INTEGER,
+        GL_UNSIGNED_BYTE,
+        reinterpret_cast<const void*>(offset + m_PixelsSize));
+
+    if (m_PersistentPbo) {
+        m_PboFences[m_PboSlot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_PboSlot = (m_PboSlot + 1) % kPboSlotCount;
+    }
 
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -261,6 +387,9 @@ void RendererGl::render()
         m_WindowSizeChanged = false;
     }
 
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, m_BrightnessTexture);
+    glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, m_Texture);
 
     glUseProgram(m_Shader);
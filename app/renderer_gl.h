@@ -4,6 +4,8 @@
 
 #include <msfce/core/snes.h>
 
+// Frames are BGR555 pixels followed by the brightness of each line, see
+// getFrameSize(). Colors are expanded and dimmed by the fragment shader.
 class RendererGl {
 public:
     RendererGl(const msfce::core::SnesConfig& snesConfig);
@@ -13,11 +15,19 @@ public:
 
     void setWindowSize(int windowWidth, int windowHeight);
 
+    size_t getFrameSize() const;
+
+    // Buffer to fill with the next frame, uploaded by unbindBackbuffer()
     uint8_t* bindBackbuffer();
     int unbindBackbuffer();
 
     void render();
 
+private:
+    // Upload buffers used in turn, so that the GPU can read a frame while
+    // the next ones are written
+    static constexpr int kPboSlotCount = 3;
+
 private:
     void setViewport();
 
@@ -32,8 +42,19 @@ private:
     GLint m_ScaleMatrixUniform = -1;
     GLuint m_VAO = 0;
     GLsizei m_VAO_ElemSize = 0;
+
+    // Frame layout
+    size_t m_PixelsSize = 0;
+    size_t m_FrameSize = 0;
+
+    // Without persistent mapping, a single PBO is orphaned for each frame
     GLuint m_PBO = 0;
-    int m_TextureSize = 0;
+    bool m_PersistentPbo = false;
+    uint8_t* m_PboData = nullptr;
+    size_t m_PboSlotSize = 0;
+    int m_PboSlot = 0;
+    GLsync m_PboFences[kPboSlotCount] = {};
+
     GLuint m_Texture = 0;
-    GLubyte* m_TextureData = nullptr;
+    GLuint m_BrightnessTexture = 0;
 };
@@ -11,14 +11,66 @@ struct Color {
     uint8_t b;
 };
 
+enum class PixelFormat {
+    // 32 bits native endian word, 0xFFRRGGBB
+    XRGB8888,
+    // 16 bits native endian word, RRRRRGGGGGGBBBBB
+    RGB565,
+    // 3 bytes, R, G then B
+    RGB24,
+    // 16 bits native endian word, 0BBBBBGGGGGRRRRR. PPU color before
+    // master brightness, which is given per line by FrameView
+    BGR555,
+};
+
+constexpr size_t getPixelSize(PixelFormat format)
+{
+    switch (format) {
+    case PixelFormat::XRGB8888:
+        return 4;
+
+    case PixelFormat::RGB565:
+    case PixelFormat::BGR555:
+        return 2;
+
+    case PixelFormat::RGB24:
+        return 3;
+
+    default:
+        return 0;
+    }
+}
+
+// Buffer the PPU draws into. It must hold SnesConfig::displayHeight lines
+// of `pitch` bytes.
+struct Framebuffer {
+    uint8_t* data = nullptr;
+    size_t pitch = 0;
+    PixelFormat format = PixelFormat::RGB24;
+};
+
+// Frame given to renderers once it has been drawn
+struct FrameView {
+    const uint8_t* data;
+    size_t pitch;
+    PixelFormat format;
+    int width;
+    int height;
+
+    // Master brightness (0-15) of each line
+    const uint8_t* brightness;
+};
+
 class Renderer {
 public:
     virtual ~Renderer() = default;
 
+    // Only called for frames rendering video
     virtual void scanStarted() = 0;
-    virtual void drawPixel(const Color& c) = 0;
+    virtual void drawFrame(const FrameView& frame) = 0;
     virtual void scanEnded() = 0;
 
+    // Only called for frames rendering audio, may happen outside a scan
     virtual void playAudioSamples(const uint8_t* data, size_t sampleCount) = 0;
 };
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace msfce::core {
+
+class Snes;
+
+// Snapshots taken every `interval` frames. Only the newest one is kept
+// whole, older ones are stored as compressed XOR deltas in a ring of
+// `maxSize` bytes, dropping the oldest when full.
+class RewindBuffer {
+public:
+    RewindBuffer(
+        const std::shared_ptr<Snes>& snes,
+        size_t maxSize,
+        int interval);
+
+    // Call after each emulated frame
+    void onFrameEnded();
+
+    // Restore the newest snapshot and drop it, -ENOENT once empty
+    int stepBack();
+
+    void clear();
+
+    size_t getSnapshotCount() const;
+    size_t getUsedSize() const;
+
+private:
+    struct Entry {
+        size_t offset;
+        size_t size;
+    };
+
+private:
+    void pushDelta(const uint8_t* data, size_t size);
+
+private:
+    std::shared_ptr<Snes> m_Snes;
+    int m_Interval;
+    int m_FrameCounter = 0;
+
+    std::vector<uint8_t> m_Current;
+    bool m_HasCurrent = false;
+
+    // Scratch buffers
+    std::vector<uint8_t> m_Snapshot;
+    std::vector<uint8_t> m_Delta;
+
+    std::vector<uint8_t> m_Ring;
+    std::deque<Entry> m_Entries;
+};
+
+} // namespace msfce::core
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include <msfce/core/snes.h>
+
+namespace msfce::core {
+
+// Hide the input lag of games by showing the frame `frames` ahead of the
+// emulated one. Each call emulates a frame, saves the state, runs hidden
+// frames with the same input and restores the state.
+class RunAhead {
+public:
+    static constexpr int kMaxFrames = 4;
+
+public:
+    // Disabled if `frames` is 0
+    RunAhead(const std::shared_ptr<Snes>& snes, int frames);
+
+    int renderSingleFrame();
+
+    // Sum of all frames emulated by the last renderSingleFrame() call
+    FrameTimings getFrameTimings() const;
+
+private:
+    int runFrame(bool renderPpu, bool renderAudio);
+
+private:
+    std::shared_ptr<Snes> m_Snes;
+    int m_Frames;
+
+    FrameTimings m_Timings = {};
+
+    std::vector<uint8_t> m_State;
+};
+
+} // namespace msfce::core
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <vector>
 
 #include <msfce/core/renderer.h>
 #include <msfce/core/controller.h>
@@ -17,9 +19,25 @@ struct SnesConfig {
     int audioSampleRate;
 };
 
+// Host time spent to emulate the last frame
+struct FrameTimings {
+    int64_t cpuUs;
+    int64_t ppuUs;
+    // SPC run at the end of the frame, runs triggered by port accesses are
+    // counted as CPU time
+    int64_t apuUs;
+};
+
+// S-DSP emulation. The fast one is less accurate but runs faster, its
+// save states can't be loaded with the accurate one and vice versa.
+enum class DspType {
+    accurate,
+    fast,
+};
+
 class Snes {
 public:
-    static std::shared_ptr<Snes> create();
+    static std::shared_ptr<Snes> create(DspType dsp = DspType::accurate);
 
 public:
     virtual ~Snes() = default;
@@ -34,13 +52,34 @@ public:
     virtual int stop() = 0;
 
     virtual SnesConfig getConfig() = 0;
+    virtual DspType getDspType() const = 0;
 
-    virtual int renderSingleFrame(bool renderPpu = true) = 0;
+    // PPU draws directly into `framebuffer`, that must stay valid until the
+    // next call. A null data pointer restores the internal RGB24 buffer.
+    virtual void setFramebuffer(const Framebuffer& framebuffer) = 0;
+
+    // Skipping video and audio makes a frame only update the state, as
+    // for run-ahead hidden frames
+    virtual int renderSingleFrame(
+        bool renderPpu = true,
+        bool renderAudio = true) = 0;
+    virtual FrameTimings getFrameTimings() = 0;
+
+    // Fast-forward loops polling RDNMI, TIMEUP or HVBJOY
+    virtual void setIdleLoopSkip(bool enable) = 0;
+
+    // Run the SPC on its own thread, must be called before start()
+    virtual void setThreadedApu(bool enable) = 0;
 
     virtual void setController1(const Controller& controller) = 0;
 
-    virtual void saveState(const std::string& path) = 0;
-    virtual void loadState(const std::string& path) = 0;
+    // Save states, taken between two frames. `buffer` capacity is reused
+    // so no allocation occurs once it has grown to the state size.
+    virtual void serialize(std::vector<uint8_t>& buffer) = 0;
+    virtual int unserialize(const uint8_t* data, size_t size) = 0;
+
+    virtual int saveState(const std::string& path) = 0;
+    virtual int loadState(const std::string& path) = 0;
 };
 
 } // namespace msfce::core
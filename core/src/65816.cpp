@@ -1,9 +1,11 @@
 #include <stdio.h>
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 #include "msfce/core/log.h"
 #include "membus.h"
 #include "registers.h"
+#include "scheduler.h"
 #include "timings.h"
 #include "65816.h"
 
@@ -15,6 +17,9 @@ constexpr bool kLogAllInstructions = false;
 constexpr bool kLogLastInstructions = false;
 constexpr size_t kInstructionsLogSize = 10;
 
+// Longest loop (in bytes) checked by the idle loop detection
+constexpr uint32_t kIdleLoopMaxSize = 16;
+
 constexpr uint32_t kPRegister_C = 0;
 constexpr uint32_t kPRegister_Z = 1;
 constexpr uint32_t kPRegister_I = 2;
@@ -44,6 +49,1890 @@ constexpr uint32_t clearBit(uint32_t value, uint8_t bit)
 
 namespace msfce::core {
 
+template<bool kM, bool kX>
+constexpr auto Cpu65816::getOpcodeList()
+    -> std::array<OpcodeDesc, kOpcodeCount>
+{
+    return {{
+    {
+        "ADC",
+        0x69,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADCImmediate<kM, kX>,
+    },
+    {
+        "ADC",
+        0x65,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x72,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x67,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x61,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x71,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x77,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x75,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x6D,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x6F,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x7F,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x7D,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x79,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x63,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "ADC",
+        0x73,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleADC<kM, kX>,
+    },
+    {
+        "AND",
+        0x29,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleANDImmediate<kM, kX>,
+    },
+    {
+        "AND",
+        0x25,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x32,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x27,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x35,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x21,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x31,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x37,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x2D,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x2F,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x3D,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x39,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x3F,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x23,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "AND",
+        0x33,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleAND<kM, kX>,
+    },
+    {
+        "ASL",
+        0x0A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleASL_A<kM, kX>,
+    },
+    {
+        "ASL",
+        0x06,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleASL<kM, kX>,
+    },
+    {
+        "ASL",
+        0x16,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleASL<kM, kX>,
+    },
+    {
+        "ASL",
+        0x0E,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleASL<kM, kX>,
+    },
+    {
+        "ASL",
+        0x1E,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleASL<kM, kX>,
+    },
+    {
+        "BEQ",
+        0xF0,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBEQ,
+    },
+    {
+        "BCC",
+        0x90,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBCC,
+    },
+    {
+        "BCS",
+        0xB0,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBCS,
+    },
+    {
+        "BIT",
+        0x89,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBITImmediate<kM, kX>,
+    },
+    {
+        "BIT",
+        0x24,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBIT<kM, kX>,
+    },
+    {
+        "BIT",
+        0x34,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBIT<kM, kX>,
+    },
+    {
+        "BIT",
+        0x2C,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBIT<kM, kX>,
+    },
+    {
+        "BIT",
+        0x3C,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleBIT<kM, kX>,
+    },
+    {
+        "BMI",
+        0x30,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBMI,
+    },
+    {
+        "BNE",
+        0xD0,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBNE,
+    },
+    {
+        "BPL",
+        0x10,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBPL,
+    },
+    {
+        "BRA",
+        0x80,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBRA,
+    },
+    {
+        "BRL",
+        0x82,
+        Cpu65816::AddressingMode::PcRelativeLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBRL,
+    },
+    {
+        "BRK",
+        0x00,
+        Cpu65816::AddressingMode::Immediate,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBRK,
+    },
+    {
+        "BVC",
+        0x50,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBVC,
+    },
+    {
+        "BVS",
+        0x70,
+        Cpu65816::AddressingMode::PcRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleBVS,
+    },
+    {
+        "CLC",
+        0x18,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCLC,
+    },
+    {
+        "CLD",
+        0xD8,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCLD,
+    },
+    {
+        "CLI",
+        0x58,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCLI,
+    },
+    {
+        "CLV",
+        0xB8,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCLV,
+    },
+    {
+        "CMP",
+        0xC9,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMPImmediate<kM, kX>,
+    },
+    {
+        "CMP",
+        0xC5,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xD2,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xC7,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xC1,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xD1,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xD5,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xD7,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xCD,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xCF,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xDD,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xD9,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xDF,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xC3,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "CMP",
+        0xD3,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCMP<kM, kX>,
+    },
+    {
+        "COP",
+        0x02,
+        Cpu65816::AddressingMode::Immediate,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCOP,
+    },
+    {
+        "CPX",
+        0xE0,
+        Cpu65816::AddressingMode::ImmediateIndex,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCPXImmediate<kM, kX>,
+    },
+    {
+        "CPX",
+        0xE4,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCPX<kM, kX>,
+    },
+    {
+        "CPX",
+        0xEC,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCPX<kM, kX>,
+    },
+    {
+        "CPY",
+        0xC0,
+        Cpu65816::AddressingMode::ImmediateIndex,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCPYImmediate<kM, kX>,
+    },
+    {
+        "CPY",
+        0xC4,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCPY<kM, kX>,
+    },
+    {
+        "CPY",
+        0xCC,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleCPY<kM, kX>,
+    },
+    {
+        "DEC",
+        0x3A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleDEC_A<kM, kX>,
+    },
+    {
+        "DEC",
+        0xC6,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleDEC<kM, kX>,
+    },
+    {
+        "DEC",
+        0xD6,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleDEC<kM, kX>,
+    },
+    {
+        "DEC",
+        0xCE,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleDEC<kM, kX>,
+    },
+    {
+        "DEC",
+        0xDE,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleDEC<kM, kX>,
+    },
+    {
+        "DEX",
+        0xCA,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleDEX<kM, kX>,
+    },
+    {
+        "DEY",
+        0x88,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleDEY<kM, kX>,
+    },
+    {
+        "EOR",
+        0x45,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x52,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x41,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x51,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x47,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x57,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x55,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x4D,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x4F,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x5F,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x5D,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x59,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x43,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x53,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEOR<kM, kX>,
+    },
+    {
+        "EOR",
+        0x49,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleEORImmediate<kM, kX>,
+    },
+    {
+        "INC",
+        0x1A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleINC_A<kM, kX>,
+    },
+    {
+        "INC",
+        0xE6,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleINC<kM, kX>,
+    },
+    {
+        "INC",
+        0xF6,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleINC<kM, kX>,
+    },
+    {
+        "INC",
+        0xEE,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleINC<kM, kX>,
+    },
+    {
+        "INC",
+        0xFE,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleINC<kM, kX>,
+    },
+    {
+        "INX",
+        0xE8,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleINX<kM, kX>,
+    },
+    {
+        "INY",
+        0xC8,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleINY<kM, kX>,
+    },
+    {
+        "JMP",
+        0x5C,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJMP,
+    },
+    {
+        "JMP",
+        0x6C,
+        Cpu65816::AddressingMode::AbsoluteIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJMP,
+    },
+    {
+        "JMP",
+        0x7C,
+        Cpu65816::AddressingMode::AbsoluteJMPIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJMP,
+    },
+    {
+        "JMP",
+        0xDC,
+        Cpu65816::AddressingMode::AbsoluteIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJMP,
+    },
+    {
+        "JMP",
+        0x4C,
+        Cpu65816::AddressingMode::AbsoluteJMP,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJMP,
+    },
+    {
+        "JSL",
+        0x22,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJSL,
+    },
+    {
+        "JSR",
+        0x20,
+        Cpu65816::AddressingMode::AbsoluteJMP,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJSR,
+    },
+    {
+        "JSR",
+        0xFC,
+        Cpu65816::AddressingMode::AbsoluteJMPIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleJSR,
+    },
+    {
+        "LDA",
+        0xA9,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDAImmediate<kM, kX>,
+    },
+    {
+        "LDA",
+        0xAD,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xAF,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xBD,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xB9,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xA5,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xB5,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xB2,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xA7,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xB7,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xA1,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xB1,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xBF,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xA3,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDA",
+        0xB3,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDA<kM, kX>,
+    },
+    {
+        "LDX",
+        0xA2,
+        Cpu65816::AddressingMode::ImmediateIndex,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDXImmediate<kM, kX>,
+    },
+    {
+        "LDX",
+        0xAE,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDX<kM, kX>,
+    },
+    {
+        "LDX",
+        0xBE,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleLDX<kM, kX>,
+    },
+    {
+        "LDX",
+        0xA6,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDX<kM, kX>,
+    },
+    {
+        "LDX",
+        0xB6,
+        Cpu65816::AddressingMode::DpIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDX<kM, kX>,
+    },
+    {
+        "LDY",
+        0xA0,
+        Cpu65816::AddressingMode::ImmediateIndex,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDYImmediate<kM, kX>,
+    },
+    {
+        "LDY",
+        0xA4,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDY<kM, kX>,
+    },
+    {
+        "LDY",
+        0xB4,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDY<kM, kX>,
+    },
+    {
+        "LDY",
+        0xAC,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLDY<kM, kX>,
+    },
+    {
+        "LDY",
+        0xBC,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleLDY<kM, kX>,
+    },
+    {
+        "LSR",
+        0x4A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLSR_A<kM, kX>,
+    },
+    {
+        "LSR",
+        0x46,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLSR<kM, kX>,
+    },
+    {
+        "LSR",
+        0x4E,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLSR<kM, kX>,
+    },
+    {
+        "LSR",
+        0x56,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLSR<kM, kX>,
+    },
+    {
+        "LSR",
+        0x5E,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleLSR<kM, kX>,
+    },
+    {
+        "MVN",
+        0x54,
+        Cpu65816::AddressingMode::BlockMove,
+        OpcodeFlag_Default & ~OpcodeFlag_AutoIncrementPC,
+        &Cpu65816::handleMVN,
+    },
+    {
+        "MVP",
+        0x44,
+        Cpu65816::AddressingMode::BlockMove,
+        OpcodeFlag_Default & ~OpcodeFlag_AutoIncrementPC,
+        &Cpu65816::handleMVP,
+    },
+    {
+        "NOP",
+        0xEA,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleNOP,
+    },
+    {
+        "ORA",
+        0x09,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORAImmediate<kM, kX>,
+    },
+    {
+        "ORA",
+        0x05,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x15,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x12,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x01,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x11,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x17,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x0D,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x0F,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x1F,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x19,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x07,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x1D,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x03,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "ORA",
+        0x13,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleORA<kM, kX>,
+    },
+    {
+        "PEA",
+        0xF4,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePEA,
+    },
+    {
+        "PEI",
+        0xD4,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePEI,
+    },
+    {
+        "PER",
+        0x62,
+        Cpu65816::AddressingMode::PcRelativeLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePER,
+    },
+    {
+        "PHA",
+        0x48,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePHA<kM, kX>,
+    },
+    {
+        "PHB",
+        0x8B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePHB,
+    },
+    {
+        "PHD",
+        0x0B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePHD,
+    },
+    {
+        "PHK",
+        0x4B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePHK,
+    },
+    {
+        "PHP",
+        0x08,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePHP,
+    },
+    {
+        "PHX",
+        0xDA,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePHX<kM, kX>,
+    },
+    {
+        "PHY",
+        0x5A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePHY<kM, kX>,
+    },
+    {
+        "PLA",
+        0x68,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePLA<kM, kX>,
+    },
+    {
+        "PLB",
+        0xAB,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePLB,
+    },
+    {
+        "PLD",
+        0x2B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePLD,
+    },
+    {
+        "PLP",
+        0x28,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePLP,
+    },
+    {
+        "PLX",
+        0xFA,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePLX<kM, kX>,
+    },
+    {
+        "PLY",
+        0x7A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handlePLY<kM, kX>,
+    },
+    {
+        "REP",
+        0xC2,
+        Cpu65816::AddressingMode::Immediate,
+        OpcodeFlag_Default,
+        &Cpu65816::handleREP,
+    },
+    {
+        "ROL",
+        0x2A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROL_A<kM, kX>,
+    },
+    {
+        "ROL",
+        0x26,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROL<kM, kX>,
+    },
+    {
+        "ROL",
+        0x36,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROL<kM, kX>,
+    },
+    {
+        "ROL",
+        0x2E,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROL<kM, kX>,
+    },
+    {
+        "ROL",
+        0x3E,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROL<kM, kX>,
+    },
+    {
+        "ROR",
+        0x6A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROR_A<kM, kX>,
+    },
+    {
+        "ROR",
+        0x6E,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROR<kM, kX>,
+    },
+    {
+        "ROR",
+        0x7E,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROR<kM, kX>,
+    },
+    {
+        "ROR",
+        0x66,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROR<kM, kX>,
+    },
+    {
+        "ROR",
+        0x76,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleROR<kM, kX>,
+    },
+    {
+        "RTI",
+        0x40,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleRTI,
+    },
+    {
+        "RTL",
+        0x6B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleRTL,
+    },
+    {
+        "RTS",
+        0x60,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleRTS,
+    },
+    {
+        "SBC",
+        0xE9,
+        Cpu65816::AddressingMode::ImmediateA,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBCImmediate<kM, kX>,
+    },
+    {
+        "SBC",
+        0xE5,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xF2,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xE7,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xF7,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xE1,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xF1,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xF5,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xED,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xFD,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xF9,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xEF,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xFF,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xE3,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SBC",
+        0xF3,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSBC<kM, kX>,
+    },
+    {
+        "SEC",
+        0x38,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSEC,
+    },
+    {
+        "SED",
+        0xF8,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSED,
+    },
+    {
+        "SEI",
+        0x78,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSEI,
+    },
+    {
+        "SEP",
+        0xE2,
+        Cpu65816::AddressingMode::Immediate,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSEP,
+    },
+    {
+        "STA",
+        0x8D,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x85,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x95,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x81,
+        Cpu65816::AddressingMode::DpIndirectIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x91,
+        Cpu65816::AddressingMode::DpIndexedIndirectY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x9D,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x99,
+        Cpu65816::AddressingMode::AbsoluteIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x8F,
+        Cpu65816::AddressingMode::AbsoluteLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x9F,
+        Cpu65816::AddressingMode::AbsoluteLongIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x92,
+        Cpu65816::AddressingMode::DpIndirect,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x87,
+        Cpu65816::AddressingMode::DpIndirectLong,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x97,
+        Cpu65816::AddressingMode::DpIndirectLongIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x83,
+        Cpu65816::AddressingMode::StackRelative,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STA",
+        0x93,
+        Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTA<kM, kX>,
+    },
+    {
+        "STX",
+        0x86,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTX<kM, kX>,
+    },
+    {
+        "STX",
+        0x96,
+        Cpu65816::AddressingMode::DpIndexedY,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTX<kM, kX>,
+    },
+    {
+        "STX",
+        0x8E,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTX<kM, kX>,
+    },
+    {
+        "STY",
+        0x84,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTY<kM, kX>,
+    },
+    {
+        "STY",
+        0x94,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTY<kM, kX>,
+    },
+    {
+        "STY",
+        0x8C,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTY<kM, kX>,
+    },
+    {
+        "STZ",
+        0x74,
+        Cpu65816::AddressingMode::DpIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTZ<kM, kX>,
+    },
+    {
+        "STZ",
+        0x64,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTZ<kM, kX>,
+    },
+    {
+        "STZ",
+        0x9C,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTZ<kM, kX>,
+    },
+    {
+        "STZ",
+        0x9E,
+        Cpu65816::AddressingMode::AbsoluteIndexedX,
+        OpcodeFlag_Default,
+        &Cpu65816::handleSTZ<kM, kX>,
+    },
+    {
+        "TAX",
+        0xAA,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTAX<kM, kX>,
+    },
+    {
+        "TAY",
+        0xA8,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTAY<kM, kX>,
+    },
+    {
+        "TCD",
+        0x5B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTCD,
+    },
+    {
+        "TCS",
+        0x1B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTCS,
+    },
+    {
+        "TDC",
+        0x7B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTDC,
+    },
+    {
+        "TRB",
+        0x14,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTRB<kM, kX>,
+    },
+    {
+        "TRB",
+        0x1C,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTRB<kM, kX>,
+    },
+    {
+        "TSB",
+        0x04,
+        Cpu65816::AddressingMode::Dp,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTSB<kM, kX>,
+    },
+    {
+        "TSB",
+        0x0C,
+        Cpu65816::AddressingMode::Absolute,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTSB<kM, kX>,
+    },
+    {
+        "TSC",
+        0x3B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTSC,
+    },
+    {
+        "TSX",
+        0xBA,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTSX<kM, kX>,
+    },
+    {
+        "TXA",
+        0x8A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTXA<kM, kX>,
+    },
+    {
+        "TXS",
+        0x9A,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTXS,
+    },
+    {
+        "TXY",
+        0x9B,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTXY<kM, kX>,
+    },
+    {
+        "TYA",
+        0x98,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTYA<kM, kX>,
+    },
+    {
+        "TYX",
+        0xBB,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleTYX<kM, kX>,
+    },
+    {
+        "XBA",
+        0xEB,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleXBA,
+    },
+    {
+        "XCE",
+        0xFB,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleXCE,
+    },
+    {
+        "WAI",
+        0xCB,
+        Cpu65816::AddressingMode::Implied,
+        OpcodeFlag_Default,
+        &Cpu65816::handleWAI,
+    },
+    }};
+}
+
+template<bool kM, bool kX>
+constexpr Cpu65816::AddressingModeHandler Cpu65816::getAddressingModeHandler(
+    AddressingMode mode)
+{
+    switch (mode) {
+    case AddressingMode::Implied:
+        return &Cpu65816::handleImplied;
+    case AddressingMode::Immediate:
+        return &Cpu65816::handleImmediate;
+    case AddressingMode::ImmediateA:
+        return &Cpu65816::handleImmediateA<kM, kX>;
+    case AddressingMode::ImmediateIndex:
+        return &Cpu65816::handleImmediateIndex<kM, kX>;
+    case AddressingMode::Absolute:
+        return &Cpu65816::handleAbsolute;
+    case AddressingMode::AbsoluteJMP:
+        return &Cpu65816::handleAbsoluteJMP;
+    case AddressingMode::AbsoluteJMPIndirectIndexedX:
+        return &Cpu65816::handleAbsoluteJMPIndirectIndexedX;
+    case AddressingMode::AbsoluteIndexedX:
+        return &Cpu65816::handleAbsoluteIndexedX<kM, kX>;
+    case AddressingMode::AbsoluteIndexedY:
+        return &Cpu65816::handleAbsoluteIndexedY<kM, kX>;
+    case AddressingMode::AbsoluteLong:
+        return &Cpu65816::handleAbsoluteLong;
+    case AddressingMode::AbsoluteIndirect:
+        return &Cpu65816::handleAbsoluteIndirect;
+    case AddressingMode::AbsoluteIndirectLong:
+        return &Cpu65816::handleAbsoluteIndirectLong;
+    case AddressingMode::AbsoluteLongIndexedX:
+        return &Cpu65816::handleAbsoluteLongIndexedX;
+    case AddressingMode::Dp:
+        return &Cpu65816::handleDp;
+    case AddressingMode::DpIndexedX:
+        return &Cpu65816::handleDpIndexedX;
+    case AddressingMode::DpIndexedY:
+        return &Cpu65816::handleDpIndexedY;
+    case AddressingMode::DpIndirect:
+        return &Cpu65816::handleDpIndirect;
+    case AddressingMode::DpIndirectIndexedX:
+        return &Cpu65816::handleDpIndirectIndexedX;
+    case AddressingMode::DpIndexedIndirectY:
+        return &Cpu65816::handleDpIndexedIndirectY<kM, kX>;
+    case AddressingMode::DpIndirectLong:
+        return &Cpu65816::handleDpIndirectLong;
+    case AddressingMode::DpIndirectLongIndexedY:
+        return &Cpu65816::handleDpIndirectLongIndexedY;
+    case AddressingMode::PcRelative:
+        return &Cpu65816::handlePcRelative;
+    case AddressingMode::PcRelativeLong:
+        return &Cpu65816::handlePcRelativeLong;
+    case AddressingMode::StackRelative:
+        return &Cpu65816::handleStackRelative;
+    case AddressingMode::StackRelativeIndirectIndexedY:
+        return &Cpu65816::handleStackRelativeIndirectIndexedY;
+    case AddressingMode::BlockMove:
+        return &Cpu65816::handleBlockMove;
+    default:
+        return nullptr;
+    }
+}
+
+template<bool kM, bool kX, size_t kIdx>
+void Cpu65816::executeOpcode(int* cycles)
+{
+    // Opcode description, addressing mode and handler are known at compile
+    // time, so everything gets inlined here
+    static constexpr OpcodeDesc s_OpcodeDesc = getOpcodeList<kM, kX>()[kIdx];
+    constexpr AddressingModeHandler addressingModeHandler =
+        getAddressingModeHandler<kM, kX>(s_OpcodeDesc.m_AddressingMode);
+    constexpr OpcodeHandler opcodeHandler = s_OpcodeDesc.m_OpcodeHandler;
+
+    if (s_OpcodeDesc.m_Flags & OpcodeFlag_AutoIncrementPC) {
+        m_Registers.PC++;
+    }
+
+    // Load data
+    uint32_t data = 0;
+    (this->*addressingModeHandler)(s_OpcodeDesc, &data, cycles);
+    m_OpcodeData = data;
+
+    // Execute instruction
+    (this->*opcodeHandler)(data, cycles);
+}
+
+template<bool kM, bool kX, size_t... kIdx>
+void Cpu65816::loadOpcodeTable(std::index_sequence<kIdx...>)
+{
+    constexpr auto opcodeList = getOpcodeList<kM, kX>();
+    Opcode* table = m_OpcodeTables[getOpcodeTableIdx(kM, kX)];
+
+    ((table[opcodeList[kIdx].m_Value] =
+          {opcodeList[kIdx].m_Name,
+           opcodeList[kIdx].m_AddressingMode,
+           &Cpu65816::executeOpcode<kM, kX, kIdx>}),
+     ...);
+}
+
 Cpu65816::Cpu65816(const std::shared_ptr<Membus> membus)
     : SchedulerTask(), m_Membus(membus)
 {
@@ -54,1838 +1943,24 @@ Cpu65816::Cpu65816(const std::shared_ptr<Membus> membus)
 
     m_Registers.PC = m_Membus->readU16(kRegIV_RESET);
 
-    // Load opcodes
-    static const OpcodeDesc s_OpcodeList[] = {
-        {
-            "ADC",
-            0x69,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADCImmediate,
-        },
-        {
-            "ADC",
-            0x65,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x72,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x67,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x61,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x71,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x77,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x75,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x6D,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x6F,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x7F,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x7D,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x79,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x63,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "ADC",
-            0x73,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleADC,
-        },
-        {
-            "AND",
-            0x29,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleANDImmediate,
-        },
-        {
-            "AND",
-            0x25,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x32,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x27,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x35,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x21,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x31,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x37,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x2D,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x2F,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x3D,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x39,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x3F,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x23,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "AND",
-            0x33,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleAND,
-        },
-        {
-            "ASL",
-            0x0A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleASL_A,
-        },
-        {
-            "ASL",
-            0x06,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleASL,
-        },
-        {
-            "ASL",
-            0x16,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleASL,
-        },
-        {
-            "ASL",
-            0x0E,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleASL,
-        },
-        {
-            "ASL",
-            0x1E,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleASL,
-        },
-        {
-            "BEQ",
-            0xF0,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBEQ,
-        },
-        {
-            "BCC",
-            0x90,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBCC,
-        },
-        {
-            "BCS",
-            0xB0,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBCS,
-        },
-        {
-            "BIT",
-            0x89,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBITImmediate,
-        },
-        {
-            "BIT",
-            0x24,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBIT,
-        },
-        {
-            "BIT",
-            0x34,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBIT,
-        },
-        {
-            "BIT",
-            0x2C,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBIT,
-        },
-        {
-            "BIT",
-            0x3C,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleBIT,
-        },
-        {
-            "BMI",
-            0x30,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBMI,
-        },
-        {
-            "BNE",
-            0xD0,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBNE,
-        },
-        {
-            "BPL",
-            0x10,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBPL,
-        },
-        {
-            "BRA",
-            0x80,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBRA,
-        },
-        {
-            "BRL",
-            0x82,
-            Cpu65816::AddressingMode::PcRelativeLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBRL,
-        },
-        {
-            "BRK",
-            0x00,
-            Cpu65816::AddressingMode::Immediate,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBRK,
-        },
-        {
-            "BVC",
-            0x50,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBVC,
-        },
-        {
-            "BVS",
-            0x70,
-            Cpu65816::AddressingMode::PcRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleBVS,
-        },
-        {
-            "CLC",
-            0x18,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCLC,
-        },
-        {
-            "CLD",
-            0xD8,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCLD,
-        },
-        {
-            "CLI",
-            0x58,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCLI,
-        },
-        {
-            "CLV",
-            0xB8,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCLV,
-        },
-        {
-            "CMP",
-            0xC9,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMPImmediate,
-        },
-        {
-            "CMP",
-            0xC5,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xD2,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xC7,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xC1,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xD1,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xD5,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xD7,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xCD,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xCF,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xDD,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xD9,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xDF,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xC3,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "CMP",
-            0xD3,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCMP,
-        },
-        {
-            "COP",
-            0x02,
-            Cpu65816::AddressingMode::Immediate,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCOP,
-        },
-        {
-            "CPX",
-            0xE0,
-            Cpu65816::AddressingMode::ImmediateIndex,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCPXImmediate,
-        },
-        {
-            "CPX",
-            0xE4,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCPX,
-        },
-        {
-            "CPX",
-            0xEC,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCPX,
-        },
-        {
-            "CPY",
-            0xC0,
-            Cpu65816::AddressingMode::ImmediateIndex,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCPYImmediate,
-        },
-        {
-            "CPY",
-            0xC4,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCPY,
-        },
-        {
-            "CPY",
-            0xCC,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleCPY,
-        },
-        {
-            "DEC",
-            0x3A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleDEC_A,
-        },
-        {
-            "DEC",
-            0xC6,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleDEC,
-        },
-        {
-            "DEC",
-            0xD6,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleDEC,
-        },
-        {
-            "DEC",
-            0xCE,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleDEC,
-        },
-        {
-            "DEC",
-            0xDE,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleDEC,
-        },
-        {
-            "DEX",
-            0xCA,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleDEX,
-        },
-        {
-            "DEY",
-            0x88,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleDEY,
-        },
-        {
-            "EOR",
-            0x45,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x52,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x41,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x51,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x47,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x57,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x55,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x4D,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x4F,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x5F,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x5D,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x59,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x43,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x53,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEOR,
-        },
-        {
-            "EOR",
-            0x49,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleEORImmediate,
-        },
-        {
-            "INC",
-            0x1A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleINC_A,
-        },
-        {
-            "INC",
-            0xE6,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleINC,
-        },
-        {
-            "INC",
-            0xF6,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleINC,
-        },
-        {
-            "INC",
-            0xEE,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleINC,
-        },
-        {
-            "INC",
-            0xFE,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleINC,
-        },
-        {
-            "INX",
-            0xE8,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleINX,
-        },
-        {
-            "INY",
-            0xC8,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleINY,
-        },
-        {
-            "JMP",
-            0x5C,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJMP,
-        },
-        {
-            "JMP",
-            0x6C,
-            Cpu65816::AddressingMode::AbsoluteIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJMP,
-        },
-        {
-            "JMP",
-            0x7C,
-            Cpu65816::AddressingMode::AbsoluteJMPIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJMP,
-        },
-        {
-            "JMP",
-            0xDC,
-            Cpu65816::AddressingMode::AbsoluteIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJMP,
-        },
-        {
-            "JMP",
-            0x4C,
-            Cpu65816::AddressingMode::AbsoluteJMP,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJMP,
-        },
-        {
-            "JSL",
-            0x22,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJSL,
-        },
-        {
-            "JSR",
-            0x20,
-            Cpu65816::AddressingMode::AbsoluteJMP,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJSR,
-        },
-        {
-            "JSR",
-            0xFC,
-            Cpu65816::AddressingMode::AbsoluteJMPIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleJSR,
-        },
-        {
-            "LDA",
-            0xA9,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDAImmediate,
-        },
-        {
-            "LDA",
-            0xAD,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xAF,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xBD,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xB9,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xA5,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xB5,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xB2,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xA7,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xB7,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xA1,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xB1,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xBF,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xA3,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDA",
-            0xB3,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDA,
-        },
-        {
-            "LDX",
-            0xA2,
-            Cpu65816::AddressingMode::ImmediateIndex,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDXImmediate,
-        },
-        {
-            "LDX",
-            0xAE,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDX,
-        },
-        {
-            "LDX",
-            0xBE,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleLDX,
-        },
-        {
-            "LDX",
-            0xA6,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDX,
-        },
-        {
-            "LDX",
-            0xB6,
-            Cpu65816::AddressingMode::DpIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDX,
-        },
-        {
-            "LDY",
-            0xA0,
-            Cpu65816::AddressingMode::ImmediateIndex,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDYImmediate,
-        },
-        {
-            "LDY",
-            0xA4,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDY,
-        },
-        {
-            "LDY",
-            0xB4,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDY,
-        },
-        {
-            "LDY",
-            0xAC,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLDY,
-        },
-        {
-            "LDY",
-            0xBC,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleLDY,
-        },
-        {
-            "LSR",
-            0x4A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLSR_A,
-        },
-        {
-            "LSR",
-            0x46,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLSR,
-        },
-        {
-            "LSR",
-            0x4E,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLSR,
-        },
-        {
-            "LSR",
-            0x56,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLSR,
-        },
-        {
-            "LSR",
-            0x5E,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleLSR,
-        },
-        {
-            "MVN",
-            0x54,
-            Cpu65816::AddressingMode::BlockMove,
-            OpcodeFlag_Default & ~OpcodeFlag_AutoIncrementPC,
-            &Cpu65816::handleMVN,
-        },
-        {
-            "MVP",
-            0x44,
-            Cpu65816::AddressingMode::BlockMove,
-            OpcodeFlag_Default & ~OpcodeFlag_AutoIncrementPC,
-            &Cpu65816::handleMVP,
-        },
-        {
-            "NOP",
-            0xEA,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleNOP,
-        },
-        {
-            "ORA",
-            0x09,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORAImmediate,
-        },
-        {
-            "ORA",
-            0x05,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x15,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x12,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x01,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x11,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x17,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x0D,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x0F,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x1F,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x19,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x07,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x1D,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x03,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "ORA",
-            0x13,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleORA,
-        },
-        {
-            "PEA",
-            0xF4,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePEA,
-        },
-        {
-            "PEI",
-            0xD4,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePEI,
-        },
-        {
-            "PER",
-            0x62,
-            Cpu65816::AddressingMode::PcRelativeLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePER,
-        },
-        {
-            "PHA",
-            0x48,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePHA,
-        },
-        {
-            "PHB",
-            0x8B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePHB,
-        },
-        {
-            "PHD",
-            0x0B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePHD,
-        },
-        {
-            "PHK",
-            0x4B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePHK,
-        },
-        {
-            "PHP",
-            0x08,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePHP,
-        },
-        {
-            "PHX",
-            0xDA,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePHX,
-        },
-        {
-            "PHY",
-            0x5A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePHY,
-        },
-        {
-            "PLA",
-            0x68,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePLA,
-        },
-        {
-            "PLB",
-            0xAB,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePLB,
-        },
-        {
-            "PLD",
-            0x2B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePLD,
-        },
-        {
-            "PLP",
-            0x28,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePLP,
-        },
-        {
-            "PLX",
-            0xFA,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePLX,
-        },
-        {
-            "PLY",
-            0x7A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handlePLY,
-        },
-        {
-            "REP",
-            0xC2,
-            Cpu65816::AddressingMode::Immediate,
-            OpcodeFlag_Default,
-            &Cpu65816::handleREP,
-        },
-        {
-            "ROL",
-            0x2A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROL_A,
-        },
-        {
-            "ROL",
-            0x26,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROL,
-        },
-        {
-            "ROL",
-            0x36,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROL,
-        },
-        {
-            "ROL",
-            0x2E,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROL,
-        },
-        {
-            "ROL",
-            0x3E,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROL,
-        },
-        {
-            "ROR",
-            0x6A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROR_A,
-        },
-        {
-            "ROR",
-            0x6E,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROR,
-        },
-        {
-            "ROR",
-            0x7E,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROR,
-        },
-        {
-            "ROR",
-            0x66,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROR,
-        },
-        {
-            "ROR",
-            0x76,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleROR,
-        },
-        {
-            "RTI",
-            0x40,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleRTI,
-        },
-        {
-            "RTL",
-            0x6B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleRTL,
-        },
-        {
-            "RTS",
-            0x60,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleRTS,
-        },
-        {
-            "SBC",
-            0xE9,
-            Cpu65816::AddressingMode::ImmediateA,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBCImmediate,
-        },
-        {
-            "SBC",
-            0xE5,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xF2,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xE7,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xF7,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xE1,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xF1,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xF5,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xED,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xFD,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xF9,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default | OpcodeFlag_CheckIndexCross,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xEF,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xFF,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xE3,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SBC",
-            0xF3,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSBC,
-        },
-        {
-            "SEC",
-            0x38,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSEC,
-        },
-        {
-            "SED",
-            0xF8,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSED,
-        },
-        {
-            "SEI",
-            0x78,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSEI,
-        },
-        {
-            "SEP",
-            0xE2,
-            Cpu65816::AddressingMode::Immediate,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSEP,
-        },
-        {
-            "STA",
-            0x8D,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x85,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x95,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x81,
-            Cpu65816::AddressingMode::DpIndirectIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x91,
-            Cpu65816::AddressingMode::DpIndexedIndirectY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x9D,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x99,
-            Cpu65816::AddressingMode::AbsoluteIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x8F,
-            Cpu65816::AddressingMode::AbsoluteLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x9F,
-            Cpu65816::AddressingMode::AbsoluteLongIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x92,
-            Cpu65816::AddressingMode::DpIndirect,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x87,
-            Cpu65816::AddressingMode::DpIndirectLong,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x97,
-            Cpu65816::AddressingMode::DpIndirectLongIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x83,
-            Cpu65816::AddressingMode::StackRelative,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STA",
-            0x93,
-            Cpu65816::AddressingMode::StackRelativeIndirectIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTA,
-        },
-        {
-            "STX",
-            0x86,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTX,
-        },
-        {
-            "STX",
-            0x96,
-            Cpu65816::AddressingMode::DpIndexedY,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTX,
-        },
-        {
-            "STX",
-            0x8E,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTX,
-        },
-        {
-            "STY",
-            0x84,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTY,
-        },
-        {
-            "STY",
-            0x94,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTY,
-        },
-        {
-            "STY",
-            0x8C,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTY,
-        },
-        {
-            "STZ",
-            0x74,
-            Cpu65816::AddressingMode::DpIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTZ,
-        },
-        {
-            "STZ",
-            0x64,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTZ,
-        },
-        {
-            "STZ",
-            0x9C,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTZ,
-        },
-        {
-            "STZ",
-            0x9E,
-            Cpu65816::AddressingMode::AbsoluteIndexedX,
-            OpcodeFlag_Default,
-            &Cpu65816::handleSTZ,
-        },
-        {
-            "TAX",
-            0xAA,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTAX,
-        },
-        {
-            "TAY",
-            0xA8,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTAY,
-        },
-        {
-            "TCD",
-            0x5B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTCD,
-        },
-        {
-            "TCS",
-            0x1B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTCS,
-        },
-        {
-            "TDC",
-            0x7B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTDC,
-        },
-        {
-            "TRB",
-            0x14,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTRB,
-        },
-        {
-            "TRB",
-            0x1C,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTRB,
-        },
-        {
-            "TSB",
-            0x04,
-            Cpu65816::AddressingMode::Dp,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTSB,
-        },
-        {
-            "TSB",
-            0x0C,
-            Cpu65816::AddressingMode::Absolute,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTSB,
-        },
-        {
-            "TSC",
-            0x3B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTSC,
-        },
-        {
-            "TSX",
-            0xBA,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTSX,
-        },
-        {
-            "TXA",
-            0x8A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTXA,
-        },
-        {
-            "TXS",
-            0x9A,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTXS,
-        },
-        {
-            "TXY",
-            0x9B,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTXY,
-        },
-        {
-            "TYA",
-            0x98,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTYA,
-        },
-        {
-            "TYX",
-            0xBB,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleTYX,
-        },
-        {
-            "XBA",
-            0xEB,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleXBA,
-        },
-        {
-            "XCE",
-            0xFB,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleXCE,
-        },
-        {
-            "WAI",
-            0xCB,
-            Cpu65816::AddressingMode::Implied,
-            OpcodeFlag_Default,
-            &Cpu65816::handleWAI,
-        },
-    };
+    // Load opcodes, one table per accumulator and index registers width
+    constexpr auto opcodeIndexes = std::make_index_sequence<kOpcodeCount>();
+    loadOpcodeTable<false, false>(opcodeIndexes);
+    loadOpcodeTable<false, true>(opcodeIndexes);
+    loadOpcodeTable<true, false>(opcodeIndexes);
+    loadOpcodeTable<true, true>(opcodeIndexes);
+    updateOpcodeTable();
 
-    for (size_t i = 0; i < SIZEOF_ARRAY(s_OpcodeList); i++) {
-        m_Opcodes[s_OpcodeList[i].m_Value] = s_OpcodeList[i];
+    for (size_t i = 0; i < SIZEOF_ARRAY(m_IdleLoopRoles); i++) {
+        m_IdleLoopRoles[i] = getIdleLoopRole(m_OpcodeTables[0][i]);
     }
 
-    LOGI(TAG, "%zu opcodes registered", SIZEOF_ARRAY(s_OpcodeList));
-
-    // Load adressing modes
-    static const struct {
-        AddressingMode mode;
-        AddressingModeHandler handler;
-    } s_AdressingModeList[] = {
-        {AddressingMode::Implied, &Cpu65816::handleImplied},
-        {AddressingMode::Immediate, &Cpu65816::handleImmediate},
-        {AddressingMode::ImmediateA, &Cpu65816::handleImmediateA},
-        {AddressingMode::ImmediateIndex, &Cpu65816::handleImmediateIndex},
-        {AddressingMode::Absolute, &Cpu65816::handleAbsolute},
-        {AddressingMode::AbsoluteJMP, &Cpu65816::handleAbsoluteJMP},
-        {AddressingMode::AbsoluteJMPIndirectIndexedX,
-         &Cpu65816::handleAbsoluteJMPIndirectIndexedX},
-        {AddressingMode::AbsoluteIndexedX, &Cpu65816::handleAbsoluteIndexedX},
-        {AddressingMode::AbsoluteIndexedY, &Cpu65816::handleAbsoluteIndexedY},
-        {AddressingMode::AbsoluteLong, &Cpu65816::handleAbsoluteLong},
-        {AddressingMode::AbsoluteIndirect, &Cpu65816::handleAbsoluteIndirect},
-        {AddressingMode::AbsoluteIndirectLong,
-         &Cpu65816::handleAbsoluteIndirectLong},
-        {AddressingMode::AbsoluteLongIndexedX,
-         &Cpu65816::handleAbsoluteLongIndexedX},
-        {AddressingMode::Dp, &Cpu65816::handleDp},
-        {AddressingMode::DpIndexedX, &Cpu65816::handleDpIndexedX},
-        {AddressingMode::DpIndexedY, &Cpu65816::handleDpIndexedY},
-        {AddressingMode::DpIndirect, &Cpu65816::handleDpIndirect},
-        {AddressingMode::DpIndirectIndexedX,
-         &Cpu65816::handleDpIndirectIndexedX},
-        {AddressingMode::DpIndexedIndirectY,
-         &Cpu65816::handleDpIndexedIndirectY},
-        {AddressingMode::DpIndirectLong, &Cpu65816::handleDpIndirectLong},
-        {AddressingMode::DpIndirectLongIndexedY,
-         &Cpu65816::handleDpIndirectLongIndexedY},
-        {AddressingMode::PcRelative, &Cpu65816::handlePcRelative},
-        {AddressingMode::PcRelativeLong, &Cpu65816::handlePcRelativeLong},
-        {AddressingMode::StackRelative, &Cpu65816::handleStackRelative},
-        {AddressingMode::StackRelativeIndirectIndexedY,
-         &Cpu65816::handleStackRelativeIndirectIndexedY},
-        {AddressingMode::BlockMove, &Cpu65816::handleBlockMove},
-    };
+    LOGI(TAG, "%zu opcodes registered", kOpcodeCount);
+}
 
-    for (size_t i = 0; i < SIZEOF_ARRAY(s_AdressingModeList); i++) {
-        const auto& mode = s_AdressingModeList[i];
-        m_AddressingModes[enumToInt(mode.mode)] = mode.handler;
-    }
+void Cpu65816::setScheduler(const std::shared_ptr<Scheduler>& scheduler)
+{
+    m_Scheduler = scheduler;
 }
 
 int Cpu65816::run()
@@ -1896,12 +1971,16 @@ int Cpu65816::run()
         return cycles;
     }
 
+    m_IdleLoop.m_Period = 0;
+
     // Check if NMI has been raised
     if (m_NMI) {
         handleNMI(&cycles);
         m_NMI = false;
+        resetIdleLoop();
     } else if (m_IRQ && !getBit(m_Registers.P, kPRegister_I)) {
         handleIRQ(&cycles);
+        resetIdleLoop();
     }
 
     // Debug stuff
@@ -1911,7 +1990,7 @@ int Cpu65816::run()
     uint8_t opcode = m_Membus->readU8(m_CurrentOpcodePC, &cycles);
     const auto& opcodeDesc = m_Opcodes[opcode];
 
-    if (!opcodeDesc.m_Name) {
+    if (!opcodeDesc.m_Executor) {
         LOGC(TAG, "Unknown instruction detected");
         LOGC(TAG, "Last %zu executed instructions", kInstructionsLogSize);
         printInstructionsLog();
@@ -1923,21 +2002,171 @@ int Cpu65816::run()
         assert(false);
     }
 
-    if (opcodeDesc.m_Flags & OpcodeFlag_AutoIncrementPC) {
-        m_Registers.PC++;
+    (this->*opcodeDesc.m_Executor)(&cycles);
+
+    if (m_IdleLoop.m_Enabled) {
+        updateIdleLoop(opcode, cycles);
     }
 
-    // Load data
-    uint32_t data = 0;
-    const auto addressingModeHandler =
-        m_AddressingModes[enumToInt(opcodeDesc.m_AddressingMode)];
-    (this->*addressingModeHandler)(opcodeDesc, &data, &cycles);
+    return cycles;
+}
 
-    // Execute instruction
-    assert(opcodeDesc.m_OpcodeHandler);
-    (this->*opcodeDesc.m_OpcodeHandler)(data, &cycles);
+constexpr int Cpu65816::getOpcodeTableIdx(bool accumulator8, bool index8)
+{
+    return (accumulator8 << 1) | index8;
+}
 
-    return cycles;
+void Cpu65816::updateOpcodeTable()
+{
+    m_Opcodes = m_OpcodeTables[getOpcodeTableIdx(
+        getBit(m_Registers.P, kPRegister_M),
+        getBit(m_Registers.P, kPRegister_X))];
+}
+
+void Cpu65816::setIdleLoopDetection(bool enable)
+{
+    m_IdleLoop.m_Enabled = enable;
+    resetIdleLoop();
+}
+
+void Cpu65816::resetIdleLoop()
+{
+    m_IdleLoop.m_Active = false;
+    m_IdleLoop.m_Period = 0;
+}
+
+int Cpu65816::getIdleLoopPeriod() const
+{
+    // A pending interrupt will take the CPU out of the loop
+    if (m_NMI || (m_IRQ && !getBit(m_Registers.P, kPRegister_I))) {
+        return 0;
+    }
+
+    return m_IdleLoop.m_Period;
+}
+
+Cpu65816::IdleLoopRole Cpu65816::getIdleLoopRole(const Opcode& opcode)
+{
+    static const char* const s_BranchList[] = {
+        "BCC", "BCS", "BEQ", "BMI", "BNE", "BPL", "BRA", "BVC", "BVS",
+    };
+
+    static const char* const s_ReadList[] = {
+        "AND", "BIT", "CMP", "CPX", "CPY", "EOR", "LDA", "LDX", "LDY", "ORA",
+    };
+
+    if (!opcode.m_Name) {
+        return IdleLoopRole::unsafe;
+    }
+
+    for (const auto& name : s_BranchList) {
+        if (!strcmp(opcode.m_Name, name)) {
+            return IdleLoopRole::branch;
+        }
+    }
+
+    for (const auto& name : s_ReadList) {
+        if (strcmp(opcode.m_Name, name)) {
+            continue;
+        }
+
+        switch (opcode.m_AddressingMode) {
+        case AddressingMode::ImmediateA:
+        case AddressingMode::ImmediateIndex:
+            return IdleLoopRole::registers;
+
+        case AddressingMode::Absolute:
+        case AddressingMode::AbsoluteLong:
+            return IdleLoopRole::read;
+
+        default:
+            return IdleLoopRole::unsafe;
+        }
+    }
+
+    if (!strcmp(opcode.m_Name, "NOP")) {
+        return IdleLoopRole::registers;
+    }
+
+    return IdleLoopRole::unsafe;
+}
+
+bool Cpu65816::isIdleLoopRegister(uint32_t addr)
+{
+    uint8_t bank = addr >> 16;
+    uint16_t offset = addr & 0xFFFF;
+
+    // Registers are only mapped in system banks
+    if (!(bank <= 0x3F || (0x80 <= bank && bank <= 0xBF))) {
+        return false;
+    }
+
+    return offset == kRegRDNMI || offset == kRegTIMEUP || offset == kRegHVBJOY;
+}
+
+bool Cpu65816::isSameRegisters(const Registers& a, const Registers& b)
+{
+    return a.A == b.A && a.X == b.X && a.Y == b.Y && a.S == b.S &&
+           a.DB == b.DB && a.D == b.D && a.PB == b.PB && a.PC == b.PC &&
+           a.P == b.P;
+}
+
+void Cpu65816::updateIdleLoop(uint8_t opcode, int cycles)
+{
+    switch (m_IdleLoopRoles[opcode]) {
+    case IdleLoopRole::unsafe:
+        resetIdleLoop();
+        return;
+
+    case IdleLoopRole::read:
+        if (!isIdleLoopRegister(m_OpcodeData)) {
+            resetIdleLoop();
+            return;
+        }
+
+        break;
+
+    case IdleLoopRole::registers:
+        break;
+
+    case IdleLoopRole::branch: {
+        uint32_t targetPC = (m_Registers.PB << 16) | m_Registers.PC;
+        if (targetPC >= m_CurrentOpcodePC ||
+            m_CurrentOpcodePC - targetPC > kIdleLoopMaxSize) {
+            // Not taken, or not a short backward branch
+            break;
+        }
+
+        // An iteration ending with the same registers than the previous one
+        // will be repeated until something else changes the system state
+        if (m_IdleLoop.m_Active && m_IdleLoop.m_StartPC == targetPC &&
+            m_IdleLoop.m_EndPC == m_CurrentOpcodePC &&
+            isSameRegisters(m_IdleLoop.m_Registers, m_Registers)) {
+            m_IdleLoop.m_Period = m_IdleLoop.m_Cycles + cycles;
+        }
+
+        // Start checking next iteration
+        m_IdleLoop.m_Active = true;
+        m_IdleLoop.m_StartPC = targetPC;
+        m_IdleLoop.m_EndPC = m_CurrentOpcodePC;
+        m_IdleLoop.m_Cycles = 0;
+        m_IdleLoop.m_Registers = m_Registers;
+        return;
+    }
+    }
+
+    if (!m_IdleLoop.m_Active) {
+        return;
+    }
+
+    // Stay in the loop
+    if (m_CurrentOpcodePC < m_IdleLoop.m_StartPC ||
+        m_CurrentOpcodePC > m_IdleLoop.m_EndPC) {
+        resetIdleLoop();
+        return;
+    }
+
+    m_IdleLoop.m_Cycles += cycles;
 }
 
 template<typename... Args>
@@ -2067,9 +2296,10 @@ void Cpu65816::setNZFlags(uint16_t value, uint16_t negativeMask)
     setZFlag(value);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleADC(uint32_t address, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     assert(!getBit(m_Registers.P, kPRegister_D));
 
@@ -2129,9 +2359,10 @@ void Cpu65816::handleADC(uint32_t address, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleADCImmediate(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     assert(!getBit(m_Registers.P, kPRegister_D));
 
@@ -2189,9 +2420,10 @@ void Cpu65816::handleADCImmediate(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleANDImmediate(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2204,9 +2436,10 @@ void Cpu65816::handleANDImmediate(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleAND(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2220,9 +2453,10 @@ void Cpu65816::handleAND(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleASL_A(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
 
     // 0: 16 bits, 1: 8 bits
@@ -2251,9 +2485,10 @@ void Cpu65816::handleASL_A(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleASL(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
     uint32_t finalC;
 
@@ -2312,9 +2547,10 @@ void Cpu65816::handleBEQ(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleBITImmediate(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2329,9 +2565,10 @@ void Cpu65816::handleBITImmediate(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleBIT(uint32_t address, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2455,10 +2692,11 @@ void Cpu65816::handleCLV(uint32_t data, int* cycles)
     m_Registers.P = clearBit(m_Registers.P, kPRegister_V);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleCMPImmediate(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     int32_t result;
 
     // 0: 16 bits, 1: 8 bits
@@ -2474,10 +2712,11 @@ void Cpu65816::handleCMPImmediate(uint32_t data, int* cycles)
     setCFlag(result);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleCMP(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     int32_t result;
 
     // 0: 16 bits, 1: 8 bits
@@ -2501,10 +2740,11 @@ void Cpu65816::handleCOP(uint32_t data, int* cycles)
     m_Registers.P = clearBit(m_Registers.P, kPRegister_D);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleCPX(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
     int32_t result;
 
     // 0: 16 bits, 1: 8 bits
@@ -2520,10 +2760,11 @@ void Cpu65816::handleCPX(uint32_t data, int* cycles)
     setCFlag(result);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleCPXImmediate(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
     int32_t result;
 
     // 0: 16 bits, 1: 8 bits
@@ -2539,10 +2780,11 @@ void Cpu65816::handleCPXImmediate(uint32_t data, int* cycles)
     setCFlag(result);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleCPY(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
     int32_t result;
 
     // 0: 16 bits, 1: 8 bits
@@ -2558,10 +2800,11 @@ void Cpu65816::handleCPY(uint32_t data, int* cycles)
     setCFlag(result);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleCPYImmediate(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
     int32_t result;
 
     // 0: 16 bits, 1: 8 bits
@@ -2577,9 +2820,10 @@ void Cpu65816::handleCPYImmediate(uint32_t data, int* cycles)
     setCFlag(result);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleDEC_A(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2591,10 +2835,11 @@ void Cpu65816::handleDEC_A(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleDEC(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2614,9 +2859,10 @@ void Cpu65816::handleDEC(uint32_t data, int* cycles)
     *cycles += kTimingCpuOneCycle;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleDEX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2629,9 +2875,10 @@ void Cpu65816::handleDEX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleDEY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2644,9 +2891,10 @@ void Cpu65816::handleDEY(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleEOR(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2660,9 +2908,10 @@ void Cpu65816::handleEOR(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleEORImmediate(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2676,9 +2925,10 @@ void Cpu65816::handleEORImmediate(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleINC_A(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2690,10 +2940,11 @@ void Cpu65816::handleINC_A(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleINC(uint32_t data, int* cycles)
 {
     uint16_t negativeMask;
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2713,9 +2964,10 @@ void Cpu65816::handleINC(uint32_t data, int* cycles)
     *cycles += kTimingCpuOneCycle;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleINX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2727,9 +2979,10 @@ void Cpu65816::handleINX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleINY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2768,9 +3021,10 @@ void Cpu65816::handleJSL(uint32_t data, int* cycles)
     m_Registers.PC = data & 0xFFFF;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLDAImmediate(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2783,9 +3037,10 @@ void Cpu65816::handleLDAImmediate(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLDA(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2799,9 +3054,10 @@ void Cpu65816::handleLDA(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLDXImmediate(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2813,9 +3069,10 @@ void Cpu65816::handleLDXImmediate(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLDX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2827,9 +3084,10 @@ void Cpu65816::handleLDX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLDYImmediate(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2841,9 +3099,10 @@ void Cpu65816::handleLDYImmediate(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLDY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -2855,9 +3114,10 @@ void Cpu65816::handleLDY(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLSR_A(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
 
     // 0: 16 bits, 1: 8 bits
@@ -2886,9 +3146,10 @@ void Cpu65816::handleLSR_A(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleLSR(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
 
     // 0: 16 bits, 1: 8 bits
@@ -2961,9 +3222,10 @@ void Cpu65816::handleNOP(uint32_t data, int* cycles)
 {
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleORA(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -2977,9 +3239,10 @@ void Cpu65816::handleORA(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleORAImmediate(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3011,9 +3274,10 @@ void Cpu65816::handlePER(uint32_t data, int* cycles)
     m_Registers.S -= 2;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handlePHA(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3049,9 +3313,10 @@ void Cpu65816::handlePHP(uint32_t data, int* cycles)
     m_Registers.S--;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handlePHX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3063,9 +3328,10 @@ void Cpu65816::handlePHX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handlePHY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3077,9 +3343,10 @@ void Cpu65816::handlePHY(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handlePLA(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3119,11 +3386,14 @@ void Cpu65816::handlePLP(uint32_t data, int* cycles)
         m_Registers.X &= 0xFF;
         m_Registers.Y &= 0xFF;
     }
+
+    updateOpcodeTable();
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handlePLX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3137,9 +3407,10 @@ void Cpu65816::handlePLX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handlePLY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3156,11 +3427,14 @@ void Cpu65816::handlePLY(uint32_t data, int* cycles)
 void Cpu65816::handleREP(uint32_t data, int* cycles)
 {
     m_Registers.P &= ~data;
+
+    updateOpcodeTable();
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleROL_A(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
 
     // 0: 16 bits, 1: 8 bits
@@ -3189,9 +3463,10 @@ void Cpu65816::handleROL_A(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleROL(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
 
     // 0: 16 bits, 1: 8 bits
@@ -3224,9 +3499,10 @@ void Cpu65816::handleROL(uint32_t data, int* cycles)
     *cycles += kTimingCpuOneCycle;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleROR_A(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
     uint32_t finalC;
 
@@ -3256,9 +3532,10 @@ void Cpu65816::handleROR_A(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleROR(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
     uint32_t C = getBit(m_Registers.P, kPRegister_C);
     uint32_t finalC;
 
@@ -3312,6 +3589,8 @@ void Cpu65816::handleRTI(uint32_t data, int* cycles)
         m_Registers.Y &= 0xFF;
     }
 
+    updateOpcodeTable();
+
     *cycles += kTimingCpuOneCycle * 2;
 }
 
@@ -3337,9 +3616,10 @@ void Cpu65816::handleRTS(uint32_t data, int* cycles)
     *cycles += kTimingCpuOneCycle * 3;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleSBCImmediate(uint32_t rawData, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     assert(!getBit(m_Registers.P, kPRegister_D));
 
@@ -3399,9 +3679,10 @@ void Cpu65816::handleSBCImmediate(uint32_t rawData, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleSBC(uint32_t address, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     assert(!getBit(m_Registers.P, kPRegister_D));
 
@@ -3484,11 +3765,14 @@ void Cpu65816::handleSEP(uint32_t data, int* cycles)
         m_Registers.X &= 0xFF;
         m_Registers.Y &= 0xFF;
     }
+
+    updateOpcodeTable();
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleSTA(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3498,9 +3782,10 @@ void Cpu65816::handleSTA(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleSTX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3510,9 +3795,10 @@ void Cpu65816::handleSTX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleSTY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3522,9 +3808,10 @@ void Cpu65816::handleSTY(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleSTZ(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3534,9 +3821,10 @@ void Cpu65816::handleSTZ(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTAX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3549,9 +3837,10 @@ void Cpu65816::handleTAX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTAY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3583,9 +3872,10 @@ void Cpu65816::handleTDC(uint32_t data, int* cycles)
     setNZFlags(m_Registers.A, 0x8000);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTRB(uint32_t address, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3617,9 +3907,10 @@ void Cpu65816::handleTRB(uint32_t address, int* cycles)
     *cycles += kTimingCpuOneCycle;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTSB(uint32_t address, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3657,9 +3948,10 @@ void Cpu65816::handleTSC(uint32_t data, int* cycles)
     setNZFlags(m_Registers.A, 0x8000);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTSX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3672,9 +3964,10 @@ void Cpu65816::handleTSX(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTXA(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3692,9 +3985,10 @@ void Cpu65816::handleTXS(uint32_t data, int* cycles)
     m_Registers.S = m_Registers.X;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTXY(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3707,9 +4001,10 @@ void Cpu65816::handleTXY(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTYA(uint32_t data, int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3722,9 +4017,10 @@ void Cpu65816::handleTYA(uint32_t data, int* cycles)
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleTYX(uint32_t data, int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3765,6 +4061,8 @@ void Cpu65816::handleXCE(uint32_t data, int* cycles)
     } else {
         m_Registers.P = clearBit(m_Registers.P, kPRegister_C);
     }
+
+    updateOpcodeTable();
 }
 
 void Cpu65816::handleWAI(uint32_t data, int* cycles)
@@ -3775,13 +4073,23 @@ void Cpu65816::handleWAI(uint32_t data, int* cycles)
 void Cpu65816::setNMI()
 {
     m_NMI = true;
-    m_WaitInterrupt = false;
+
+    if (m_WaitInterrupt) {
+        // CPU is sleeping, resume it on next cycle
+        m_WaitInterrupt = false;
+        m_Scheduler->resumeTask(this, 1);
+    }
 }
 
 void Cpu65816::setIRQ(bool value)
 {
     m_IRQ = value;
-    m_WaitInterrupt = false;
+
+    if (m_WaitInterrupt) {
+        // CPU is sleeping, resume it on next cycle
+        m_WaitInterrupt = false;
+        m_Scheduler->resumeTask(this, 1);
+    }
 }
 
 void Cpu65816::handleImplied(
@@ -3802,12 +4110,13 @@ void Cpu65816::handleImmediate(
     logInstruction("%s #$%02X", opcodeDesc.m_Name, *data);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleImmediateA(
     const OpcodeDesc& opcodeDesc,
     uint32_t* data,
     int* cycles)
 {
-    auto accumulatorSize = getBit(m_Registers.P, kPRegister_M);
+    constexpr auto accumulatorSize = kM;
 
     // 0: 16 bits, 1: 8 bits
     if (accumulatorSize) {
@@ -3825,12 +4134,13 @@ void Cpu65816::handleImmediateA(
     }
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleImmediateIndex(
     const OpcodeDesc& opcodeDesc,
     uint32_t* data,
     int* cycles)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (indexSize) {
@@ -3899,6 +4209,7 @@ void Cpu65816::handleAbsoluteJMPIndirectIndexedX(
     logInstruction("%s ($%04X,X) [%06X]", opcodeDesc.m_Name, rawData, *data);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleAbsoluteIndexedX(
     const OpcodeDesc& opcodeDesc,
     uint32_t* data,
@@ -3914,12 +4225,13 @@ void Cpu65816::handleAbsoluteIndexedX(
     addCyclesIndexed(cycles);
 
     if (opcodeDesc.m_Flags & OpcodeFlag_CheckIndexCross) {
-        addCyclesIndexCross(cycles, address, *data);
+        addCyclesIndexCross<kM, kX>(cycles, address, *data);
     }
 
     logInstruction("%s $%04X,X [%06X]", opcodeDesc.m_Name, rawData, *data);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleAbsoluteIndexedY(
     const OpcodeDesc& opcodeDesc,
     uint32_t* data,
@@ -3935,7 +4247,7 @@ void Cpu65816::handleAbsoluteIndexedY(
     addCyclesIndexed(cycles);
 
     if (opcodeDesc.m_Flags & OpcodeFlag_CheckIndexCross) {
-        addCyclesIndexCross(cycles, address, *data);
+        addCyclesIndexCross<kM, kX>(cycles, address, *data);
     }
 
     logInstruction("%s $%04X,Y [%06X]", opcodeDesc.m_Name, rawData, *data);
@@ -4085,6 +4397,7 @@ void Cpu65816::handleDpIndirectIndexedX(
     logInstruction("%s ($%02X,X) [%06X] ", opcodeDesc.m_Name, rawData, *data);
 }
 
+template<bool kM, bool kX>
 void Cpu65816::handleDpIndexedIndirectY(
     const OpcodeDesc& opcodeDesc,
     uint32_t* data,
@@ -4103,7 +4416,7 @@ void Cpu65816::handleDpIndexedIndirectY(
     addCyclesDp(cycles);
 
     if (opcodeDesc.m_Flags & OpcodeFlag_CheckIndexCross) {
-        addCyclesIndexCross(cycles, address, *data);
+        addCyclesIndexCross<kM, kX>(cycles, address, *data);
     }
 
     logInstruction("%s ($%02X),Y [%06X] ", opcodeDesc.m_Name, rawData, *data);
@@ -4240,12 +4553,13 @@ void Cpu65816::addCyclesIndexed(int* cycles)
     *cycles += kTimingCpuOneCycle;
 }
 
+template<bool kM, bool kX>
 void Cpu65816::addCyclesIndexCross(
     int* cycles,
     uint32_t addr,
     uint32_t shiftedAddr)
 {
-    auto indexSize = getBit(m_Registers.P, kPRegister_X);
+    constexpr auto indexSize = kX;
 
     // 0: 16 bits, 1: 8 bits
     if (!indexSize || addr >> 8 != shiftedAddr) {
@@ -4253,22 +4567,28 @@ void Cpu65816::addCyclesIndexCross(
     }
 }
 
-void Cpu65816::dumpToFile(FILE* f)
+void Cpu65816::serialize(Serializer* s)
 {
-    SchedulerTask::dumpToFile(f);
+    SchedulerTask::serialize(s);
 
-    fwrite(&m_Registers, sizeof(m_Registers), 1, f);
-    fwrite(&m_NMI, sizeof(m_NMI), 1, f);
-    fwrite(&m_IRQ, sizeof(m_IRQ), 1, f);
+    s->write(&m_Registers, sizeof(m_Registers));
+    s->write(&m_NMI, sizeof(m_NMI));
+    s->write(&m_IRQ, sizeof(m_IRQ));
 }
 
-void Cpu65816::loadFromFile(FILE* f)
+void Cpu65816::unserialize(Deserializer* d)
 {
-    SchedulerTask::loadFromFile(f);
+    SchedulerTask::unserialize(d);
+
+    d->read(&m_Registers, sizeof(m_Registers));
+    d->read(&m_NMI, sizeof(m_NMI));
+    d->read(&m_IRQ, sizeof(m_IRQ));
+
+    updateOpcodeTable();
+    resetIdleLoop();
 
-    fread(&m_Registers, sizeof(m_Registers), 1, f);
-    fread(&m_NMI, sizeof(m_NMI), 1, f);
-    fread(&m_IRQ, sizeof(m_IRQ), 1, f);
+    // Wait state isn't saved, but only a waiting CPU is sleeping
+    m_WaitInterrupt = isSleeping();
 }
 
 } // namespace msfce::core
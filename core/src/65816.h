@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <list>
 #include <memory>
 #include <string>
+#include <utility>
 
 #include "utils.h"
 #include "schedulertask.h"
@@ -11,19 +13,29 @@
 namespace msfce::core {
 
 class Membus;
+class Scheduler;
 
 class Cpu65816 : public SchedulerTask {
 public:
     Cpu65816(const std::shared_ptr<Membus> membus);
     ~Cpu65816() = default;
 
+    void setScheduler(const std::shared_ptr<Scheduler>& scheduler);
+
     int run() override;
 
     void setNMI();
     void setIRQ(bool value);
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    void setIdleLoopDetection(bool enable);
+    void resetIdleLoop();
+
+    // Cycles of an iteration of the idle loop the CPU is running, 0 if the
+    // last instruction didn't complete an idle iteration
+    int getIdleLoopPeriod() const;
+
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
 
 private:
     template<typename... Args>
@@ -40,16 +52,24 @@ private:
     void setCFlag(int32_t value);
     void setNZFlags(uint16_t value, uint16_t negativeMask);
 
+    template<bool kM, bool kX>
     void handleADC(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleADCImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleANDImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleAND(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleASL_A(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleASL(uint32_t data, int* cycles);
     void handleBCC(uint32_t data, int* cycles);
     void handleBCS(uint32_t data, int* cycles);
     void handleBEQ(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleBITImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleBIT(uint32_t data, int* cycles);
     void handleBMI(uint32_t data, int* cycles);
     void handleBRA(uint32_t data, int* cycles);
@@ -63,86 +83,137 @@ private:
     void handleCLD(uint32_t data, int* cycles);
     void handleCLI(uint32_t data, int* cycles);
     void handleCLV(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleCMP(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleCMPImmediate(uint32_t data, int* cycles);
     void handleCOP(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleCPX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleCPXImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleCPY(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleCPYImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleDEC_A(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleDEC(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleDEX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleDEY(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleEOR(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleEORImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleINC_A(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleINC(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleINX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleINY(uint32_t data, int* cycles);
     void handleJMP(uint32_t data, int* cycles);
     void handleJSR(uint32_t data, int* cycles);
     void handleJSL(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLDAImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLDA(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLDXImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLDX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLDYImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLDY(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLSR_A(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleLSR(uint32_t data, int* cycles);
     void handleMVN(uint32_t data, int* cycles);
     void handleMVP(uint32_t data, int* cycles);
     void handleNOP(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleORA(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleORAImmediate(uint32_t data, int* cycles);
     void handlePEA(uint32_t data, int* cycles);
     void handlePEI(uint32_t data, int* cycles);
     void handlePER(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handlePHA(uint32_t data, int* cycles);
     void handlePHB(uint32_t data, int* cycles);
     void handlePHD(uint32_t data, int* cycles);
     void handlePHK(uint32_t data, int* cycles);
     void handlePHP(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handlePHX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handlePHY(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handlePLA(uint32_t data, int* cycles);
     void handlePLB(uint32_t data, int* cycles);
     void handlePLD(uint32_t data, int* cycles);
     void handlePLP(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handlePLX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handlePLY(uint32_t data, int* cycles);
     void handleREP(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleROL_A(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleROL(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleROR_A(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleROR(uint32_t data, int* cycles);
     void handleRTI(uint32_t data, int* cycles);
     void handleRTL(uint32_t data, int* cycles);
     void handleRTS(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleSBCImmediate(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleSBC(uint32_t data, int* cycles);
     void handleSEC(uint32_t data, int* cycles);
     void handleSED(uint32_t data, int* cycles);
     void handleSEI(uint32_t data, int* cycles);
     void handleSEP(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleSTA(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleSTX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleSTY(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleSTZ(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTAX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTAY(uint32_t data, int* cycles);
     void handleTCD(uint32_t data, int* cycles);
     void handleTCS(uint32_t data, int* cycles);
     void handleTDC(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTRB(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTSB(uint32_t data, int* cycles);
     void handleTSC(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTSX(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTXA(uint32_t data, int* cycles);
     void handleTXS(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTXY(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTYA(uint32_t data, int* cycles);
+    template<bool kM, bool kX>
     void handleTYX(uint32_t data, int* cycles);
     void handleXBA(uint32_t data, int* cycles);
     void handleXCE(uint32_t data, int* cycles);
@@ -219,6 +290,67 @@ private:
         uint32_t* data,
         int* cycles);
 
+    typedef void (Cpu65816::*OpcodeExecutor)(int* cycles);
+
+    struct Opcode {
+        const char* m_Name = nullptr;
+        AddressingMode m_AddressingMode = AddressingMode::Count;
+        OpcodeExecutor m_Executor = nullptr;
+    };
+
+    // How an instruction affects idle loop detection
+    enum class IdleLoopRole : uint8_t {
+        // Anything with side effects
+        unsafe,
+        // Only changes registers
+        registers,
+        // Reads its operand from memory
+        read,
+        // Conditional branch, may close the loop
+        branch,
+    };
+
+    struct IdleLoop {
+        bool m_Enabled = false;
+
+        // Loop being checked, from the branch target to the branch
+        bool m_Active = false;
+        uint32_t m_StartPC = 0;
+        uint32_t m_EndPC = 0;
+        int m_Cycles = 0;
+        Registers m_Registers;
+
+        int m_Period = 0;
+    };
+
+    static constexpr size_t kOpcodeCount = 254;
+
+    // One table for each M/X flags combination
+    static constexpr int kOpcodeTableCount = 4;
+
+private:
+    template<bool kM, bool kX>
+    static constexpr auto getOpcodeList()
+        -> std::array<OpcodeDesc, kOpcodeCount>;
+
+    template<bool kM, bool kX>
+    static constexpr AddressingModeHandler getAddressingModeHandler(
+        AddressingMode mode);
+
+    template<bool kM, bool kX, size_t kIdx>
+    void executeOpcode(int* cycles);
+
+    template<bool kM, bool kX, size_t... kIdx>
+    void loadOpcodeTable(std::index_sequence<kIdx...>);
+
+    static constexpr int getOpcodeTableIdx(bool accumulator8, bool index8);
+    void updateOpcodeTable();
+
+    static IdleLoopRole getIdleLoopRole(const Opcode& opcode);
+    static bool isIdleLoopRegister(uint32_t addr);
+    static bool isSameRegisters(const Registers& a, const Registers& b);
+    void updateIdleLoop(uint8_t opcode, int cycles);
+
 private:
     void handleImplied(
         const OpcodeDesc& opcodeDesc,
@@ -230,11 +362,13 @@ private:
         uint32_t* data,
         int* cycles);
 
+    template<bool kM, bool kX>
     void handleImmediateA(
         const OpcodeDesc& opcodeDesc,
         uint32_t* data,
         int* cycles);
 
+    template<bool kM, bool kX>
     void handleImmediateIndex(
         const OpcodeDesc& opcodeDesc,
         uint32_t* data,
@@ -255,11 +389,13 @@ private:
         uint32_t* data,
         int* cycles);
 
+    template<bool kM, bool kX>
     void handleAbsoluteIndexedX(
         const OpcodeDesc& opcodeDesc,
         uint32_t* data,
         int* cycles);
 
+    template<bool kM, bool kX>
     void handleAbsoluteIndexedY(
         const OpcodeDesc& opcodeDesc,
         uint32_t* data,
@@ -307,6 +443,7 @@ private:
         uint32_t* data,
         int* cycles);
 
+    template<bool kM, bool kX>
     void handleDpIndexedIndirectY(
         const OpcodeDesc& opcodeDesc,
         uint32_t* data,
@@ -349,13 +486,16 @@ private:
 
     void addCyclesDp(int* cycles);
     void addCyclesIndexed(int* cycles);
+    template<bool kM, bool kX>
     void addCyclesIndexCross(int* cycles, uint32_t addr, uint32_t shiftedAddr);
 
 private:
     std::shared_ptr<Membus> m_Membus;
 
-    OpcodeDesc m_Opcodes[0x100];
-    AddressingModeHandler m_AddressingModes[kAddressingMode];
+    std::shared_ptr<Scheduler> m_Scheduler;
+
+    Opcode m_OpcodeTables[kOpcodeTableCount][0x100];
+    const Opcode* m_Opcodes = nullptr;
     Registers m_Registers;
 
     uint32_t m_CurrentOpcodePC = 0;
@@ -364,6 +504,12 @@ private:
     bool m_IRQ = false;
     bool m_WaitInterrupt = false;
 
+    // Data computed by the addressing mode of the last instruction
+    uint32_t m_OpcodeData = 0;
+
+    IdleLoop m_IdleLoop;
+    IdleLoopRole m_IdleLoopRoles[0x100];
+
     using InstructionLogBuilder = std::function<std::string()>;
     std::list<InstructionLogBuilder> m_InstructionsLog;
 };
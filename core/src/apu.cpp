@@ -1,4 +1,5 @@
 #include <assert.h>
+#include <string.h>
 
 #include "msfce/core/log.h"
 #include "registers.h"
@@ -19,111 +20,244 @@ const uint8_t kIplRom[64] = {0xcd, 0xef, 0xbd, 0xe8, 0x00, 0xc6, 0x1d, 0xd0,
 
 const int kIplRomSize = SIZEOF_ARRAY(kIplRom);
 
-// FIXME: NTSC ratio
-constexpr float kClockRatio = 1024000.0f / 21477000.0f;
+// Port reads are frequent, avoid sleeping for each one
+constexpr int kWaitSpinCount = 1000;
+
+// SPC clocks per master clocks, NTSC
+constexpr uint64_t kSpcClockRate = 1024000;
+constexpr uint64_t kMasterClockRate = 21477000;
 
 } // anonymous namespace
 
 namespace msfce::core {
 
-Apu::Apu(const uint64_t& masterClock, RenderSampleCb renderSampleCb)
+Apu::Apu(
+    const uint64_t& masterClock,
+    RenderSampleCb renderSampleCb,
+    DspType dsp,
+    bool threaded)
     : MemComponent(MemComponentType::apu)
     , SchedulerTask()
     , m_RenderSampleCb(renderSampleCb)
     , m_MasterClock(masterClock)
+    , m_Threaded(threaded)
 {
     // Init SPC
-    m_SPC.init();
-    m_SPC.init_rom(kIplRom);
-    m_SPC.reset();
+    m_SPC = SpcBackend::create(dsp);
+    m_SPC->init(kIplRom);
 
     // Plug output buffer
-    m_SamplesSize = kSampleSize * kSampleRate / 30; // 30 ms
+    m_SamplesSize = kSampleSize * kSampleRate / 20; // 50 ms, > 1 frame
     m_Samples = new uint8_t[m_SamplesSize];
 
-    m_SPC.set_output(reinterpret_cast<short*>(m_Samples), m_SamplesSize);
+    setOutput();
+
+    if (m_Threaded) {
+        m_Thread = std::thread(&Apu::threadEntry, this);
+    }
 }
 
 Apu::~Apu()
 {
+    if (m_Thread.joinable()) {
+        pushCommand({Command::Type::stop, 0, 0, 0});
+        m_Thread.join();
+    }
+
     delete[] m_Samples;
 }
 
 uint8_t Apu::readU8(uint32_t addr)
 {
-    uint64_t t = kClockRatio * (m_MasterClock - m_Clock);
-    return m_SPC.read_port(t, addr & 3);
+    int port = addr & 3;
+
+    if (m_Threaded) {
+        pushCommand({Command::Type::read, getSpcTime(), port, 0});
+        waitCommands();
+        return m_ReadValue;
+    }
+
+    // SPC runs up to the access
+    return m_SPC->readPort(getSpcTime(), port);
 }
 
 void Apu::writeU8(uint32_t addr, uint8_t value)
 {
-    uint64_t t = kClockRatio * (m_MasterClock - m_Clock);
-    m_SPC.write_port(t, addr & 3, value);
+    int port = addr & 3;
+
+    if (m_Threaded) {
+        pushCommand({Command::Type::write, getSpcTime(), port, value});
+        return;
+    }
+
+    m_SPC->writePort(getSpcTime(), port, value);
 }
 
-void Apu::dumpToFile(FILE* f)
+void Apu::serialize(Serializer* s)
 {
-    SchedulerTask::dumpToFile(f);
+    waitCommands();
+
+    SchedulerTask::serialize(s);
 
-    // Dump SPC state
-    uint8_t* spcState = new uint8_t[SNES_SPC::state_size];
+    s->write(&m_Clock, sizeof(m_Clock));
+    s->write(&m_ClockRemainder, sizeof(m_ClockRemainder));
 
+    // Stream SPC state, io is the serializer itself
     auto stateCb = [](unsigned char** io, void* state, size_t size) {
-        memcpy(*io, state, size);
-        (*io) += size;
+        reinterpret_cast<Serializer*>(io)->write(state, size);
     };
 
-    void* io = spcState;
-    m_SPC.copy_state(reinterpret_cast<unsigned char**>(&io), stateCb);
-
-    // Write states to file
-    fwrite(&m_Clock, sizeof(m_Clock), 1, f);
-    fwrite(spcState, SNES_SPC::state_size, 1, f);
-
-    delete[] spcState;
+    m_SPC->copyState(reinterpret_cast<unsigned char**>(s), stateCb);
 }
 
-void Apu::loadFromFile(FILE* f)
+void Apu::unserialize(Deserializer* d)
 {
-    SchedulerTask::loadFromFile(f);
+    waitCommands();
 
-    uint8_t* spcState = new uint8_t[SNES_SPC::state_size];
+    SchedulerTask::unserialize(d);
 
-    memset(m_Samples, 0, m_SamplesSize);
-    m_SPC.set_output(reinterpret_cast<short*>(m_Samples), m_SamplesSize);
+    d->read(&m_Clock, sizeof(m_Clock));
+    d->read(&m_ClockRemainder, sizeof(m_ClockRemainder));
 
-    // Load states
-    fread(&m_Clock, sizeof(m_Clock), 1, f);
-    fread(spcState, SNES_SPC::state_size, 1, f);
-
-    // Restore state to SPC
+    // Restore SPC state, io is the deserializer itself
     auto stateCb = [](unsigned char** io, void* state, size_t size) {
-        memcpy(state, *io, size);
-        (*io) += size;
+        reinterpret_cast<Deserializer*>(io)->read(state, size);
     };
 
-    void* io = spcState;
-    m_SPC.copy_state(reinterpret_cast<unsigned char**>(&io), stateCb);
+    m_SPC->copyState(reinterpret_cast<unsigned char**>(d), stateCb);
 
-    delete[] spcState;
+    // Pending samples are copied back at the beginning of the buffer
+    memset(m_Samples, 0, m_SamplesSize);
+    setOutput();
 }
 
 int Apu::run()
 {
-    // Complete frame
-    uint64_t t = kClockRatio * (m_MasterClock - m_Clock);
+    // Complete the SPC frame, the remainder is kept for the next one
+    uint64_t clocks =
+        (m_MasterClock - m_Clock) * kSpcClockRate + m_ClockRemainder;
     m_Clock = m_MasterClock;
-    m_SPC.end_frame(t);
+    m_ClockRemainder = clocks % kMasterClockRate;
+
+    int endTime = clocks / kMasterClockRate;
+
+    if (m_Threaded) {
+        // Samples are sent from this thread
+        pushCommand({Command::Type::endFrame, endTime, 0, 0});
+        waitCommands();
+    } else {
+        m_SPC->endFrame(endTime);
+    }
 
     // Record samples
-    const int sampleCount = m_SPC.sample_count();
+    const int sampleCount = m_SPC->getSampleCount();
     if (sampleCount > 0) {
-        // SNES_SPC seems to give a invalid sample count
-        m_RenderSampleCb(m_Samples, sampleCount / 2);
-        m_SPC.set_output(reinterpret_cast<short*>(m_Samples), m_SamplesSize);
+        // Sample count is given per channel
+        m_RenderSampleCb(m_Samples, sampleCount / kChannels);
+        setOutput();
     }
 
     return 0;
 }
 
+void Apu::catchUp()
+{
+    if (m_Threaded) {
+        pushCommand({Command::Type::runUntil, getSpcTime(), 0, 0});
+    }
+}
+
+int Apu::getSpcTime() const
+{
+    uint64_t clocks =
+        (m_MasterClock - m_Clock) * kSpcClockRate + m_ClockRemainder;
+    return clocks / kMasterClockRate;
+}
+
+void Apu::setOutput()
+{
+    m_SPC->setOutput(
+        reinterpret_cast<short*>(m_Samples), m_SamplesSize / sizeof(short));
+}
+
+void Apu::pushCommand(const Command& command)
+{
+    bool wasEmpty;
+
+    {
+        std::unique_lock<std::mutex> lock(m_Mtx);
+        wasEmpty = m_Commands.empty();
+        m_Commands.push_back(command);
+    }
+
+    m_PushedCount++;
+
+    // Thread only sleeps on an empty queue
+    if (wasEmpty) {
+        m_CommandCv.notify_one();
+    }
+}
+
+void Apu::waitCommands()
+{
+    for (int i = 0; i < kWaitSpinCount; i++) {
+        if (m_DoneCount.load(std::memory_order_acquire) == m_PushedCount) {
+            return;
+        }
+
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(m_Mtx);
+    m_DoneCv.wait(lock, [this]() { return m_DoneCount == m_PushedCount; });
+}
+
+void Apu::threadEntry()
+{
+    std::deque<Command> commands;
+
+    while (true) {
+        // Take all pending commands at once
+        {
+            std::unique_lock<std::mutex> lock(m_Mtx);
+            m_CommandCv.wait(lock, [this]() { return !m_Commands.empty(); });
+
+            commands.swap(m_Commands);
+        }
+
+        for (const Command& command : commands) {
+            switch (command.type) {
+            case Command::Type::read:
+                m_ReadValue = m_SPC->readPort(command.time, command.port);
+                break;
+
+            case Command::Type::write:
+                m_SPC->writePort(command.time, command.port, command.value);
+                break;
+
+            case Command::Type::runUntil:
+                // Reading a port has no side effect
+                m_SPC->readPort(command.time, 0);
+                break;
+
+            case Command::Type::endFrame:
+                m_SPC->endFrame(command.time);
+                break;
+
+            case Command::Type::stop:
+                return;
+            }
+        }
+
+        // Emulation thread only waits for the whole queue to be done
+        {
+            std::unique_lock<std::mutex> lock(m_Mtx);
+            m_DoneCount.fetch_add(commands.size(), std::memory_order_release);
+        }
+
+        commands.clear();
+        m_DoneCv.notify_one();
+    }
+}
+
 } // namespace msfce::core
@@ -2,16 +2,17 @@
 
 #include <stdint.h>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
-
-#include <snes_spc/SNES_SPC.h>
+#include <thread>
 
 #include "memcomponent.h"
 #include "schedulertask.h"
-
-struct SNES_SPC;
+#include "spcbackend.h"
 
 namespace msfce::core {
 
@@ -27,7 +28,12 @@ public:
     static constexpr int kChannels = 2;
 
 public:
-    Apu(const uint64_t& masterClock, RenderSampleCb renderSampleCb);
+    // In threaded mode, SPC runs on its own thread. Port writes are queued,
+    // port reads wait for the SPC to reach them.
+    Apu(const uint64_t& masterClock,
+        RenderSampleCb renderSampleCb,
+        DspType dsp = DspType::accurate,
+        bool threaded = false);
     ~Apu();
 
     // MemComponent methods
@@ -37,18 +43,66 @@ public:
     // SchedulerTask methods
     int run() override;
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    // Let the SPC thread run up to now, no-op inline
+    void catchUp();
+
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
+
+private:
+    struct Command {
+        enum class Type {
+            read,
+            write,
+            runUntil,
+            endFrame,
+            stop,
+        };
+
+        Type type;
+        int time;
+        int port;
+        uint8_t value;
+    };
+
+private:
+    // SPC clocks since the beginning of its frame
+    int getSpcTime() const;
+
+    void setOutput();
+
+    void pushCommand(const Command& command);
+    void waitCommands();
+    void threadEntry();
 
 private:
     RenderSampleCb m_RenderSampleCb;
 
     const uint64_t& m_MasterClock;
+
+    // Master clock at the beginning of the SPC frame. The remainder is the
+    // SPC clock fraction left by the previous frame, scaled by the master
+    // clock rate.
     uint64_t m_Clock = 0;
+    uint64_t m_ClockRemainder = 0;
 
-    SNES_SPC m_SPC;
+    std::unique_ptr<SpcBackend> m_SPC;
     uint8_t* m_Samples = nullptr;
     size_t m_SamplesSize = 0;
+
+    // Threaded mode, SPC is only accessed by the thread while commands
+    // are pending
+    bool m_Threaded;
+    std::thread m_Thread;
+
+    std::mutex m_Mtx;
+    std::condition_variable m_CommandCv;
+    std::condition_variable m_DoneCv;
+    std::deque<Command> m_Commands;
+
+    uint64_t m_PushedCount = 0;
+    std::atomic<uint64_t> m_DoneCount{0};
+    uint8_t m_ReadValue = 0;
 };
 
 } // namespace msfce::core
@@ -128,20 +128,20 @@ uint16_t ControllerPorts::packController(const Controller& controller)
     return value;
 }
 
-void ControllerPorts::dumpToFile(FILE* f)
+void ControllerPorts::serialize(Serializer* s)
 {
-    fwrite(&m_Controller1_State, sizeof(m_Controller1_State), 1, f);
-    fwrite(&m_Joypad1Register, sizeof(m_Joypad1Register), 1, f);
-    fwrite(&m_Controller1_Strobe, sizeof(m_Controller1_Strobe), 1, f);
-    fwrite(&m_Controller1_ReadReg, sizeof(m_Controller1_ReadReg), 1, f);
+    s->write(&m_Controller1_State, sizeof(m_Controller1_State));
+    s->write(&m_Joypad1Register, sizeof(m_Joypad1Register));
+    s->write(&m_Controller1_Strobe, sizeof(m_Controller1_Strobe));
+    s->write(&m_Controller1_ReadReg, sizeof(m_Controller1_ReadReg));
 }
 
-void ControllerPorts::loadFromFile(FILE* f)
+void ControllerPorts::unserialize(Deserializer* d)
 {
-    fread(&m_Controller1_State, sizeof(m_Controller1_State), 1, f);
-    fread(&m_Joypad1Register, sizeof(m_Joypad1Register), 1, f);
-    fread(&m_Controller1_Strobe, sizeof(m_Controller1_Strobe), 1, f);
-    fread(&m_Controller1_ReadReg, sizeof(m_Controller1_ReadReg), 1, f);
+    d->read(&m_Controller1_State, sizeof(m_Controller1_State));
+    d->read(&m_Joypad1Register, sizeof(m_Joypad1Register));
+    d->read(&m_Controller1_Strobe, sizeof(m_Controller1_Strobe));
+    d->read(&m_Controller1_ReadReg, sizeof(m_Controller1_ReadReg));
 }
 
 } // namespace msfce::core
@@ -19,8 +19,8 @@ public:
 
     void readController();
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
 
 private:
     static uint16_t packController(const Controller& controller);
@@ -69,36 +69,18 @@ void Dma::writeU8(uint32_t addr, uint8_t value)
 
 int Dma::run()
 {
-    if (!m_ActiveDmaChannels) {
-        return 0;
-    }
-
-    if (m_DmaRunningCtx.id != kUnknownChannelId) {
-        if (m_DmaRunningCtx.m_Registers->m_DMAByteCounter) {
-            int cycles = 0;
-
-            dmaChannelContinue(&cycles);
-
-            return cycles;
-        } else {
-            m_ActiveDmaChannels &= ~(1 << m_DmaRunningCtx.id);
-
-            m_DmaRunningCtx.id = kUnknownChannelId;
-            m_DmaRunningCtx.m_Registers = nullptr;
-        }
-    }
-
-    // Look for the next channel to run
+    // Look for the next channel to run. The whole transfer is done at
+    // start, the channel then holds the bus for the time it would take.
     for (int i = 0; i < kChannelCount; i++) {
         if (m_ActiveDmaChannels & (1 << i)) {
             int cycles = 0;
 
             LOGD(TAG, "Start DMA channel %d", i);
 
-            m_DmaRunningCtx.id = i;
-            m_DmaRunningCtx.m_Registers = &m_DmaChannels[i];
+            m_ActiveDmaChannels &= ~(1 << i);
 
             dmaChannelStart(i, &m_DmaChannels[i], &cycles);
+            dmaChannelTransfer(i, &m_DmaChannels[i], &cycles);
 
             return cycles;
         }
@@ -150,16 +132,13 @@ void Dma::dmaChannelStart(int id, DmaChannel* channel, int* cycles)
     channel->m_DMAByteCounter = channelCfg[kRegDmaDASL] |
                                 (channelCfg[kRegDmaDASH] << 8);
 
-    // Setup m_RunningCtx
-    m_DmaRunningCtx.m_bBaseBusAddress = 0x2100 | channel->m_BBusAddress;
-
     LOGD(
         TAG,
         "\tDirection: %d",
         static_cast<int>(channel->m_Params.m_Direction));
     LOGD(TAG, "\tABusStep: %d", static_cast<int>(channel->m_ABusStep));
     LOGD(TAG, "\tMode: %d", static_cast<int>(channel->m_Params.m_Mode));
-    LOGD(TAG, "\tB-Bus address: 0x%04X", m_DmaRunningCtx.m_bBaseBusAddress);
+    LOGD(TAG, "\tB-Bus address: 0x%04X", 0x2100 | channel->m_BBusAddress);
     LOGD(TAG, "\tA-Bus address: 0x%06X", channel->m_ABusAddress);
     LOGD(TAG, "\tBytes: 0x%04X", channel->m_DMAByteCounter);
 
@@ -167,198 +146,119 @@ void Dma::dmaChannelStart(int id, DmaChannel* channel, int* cycles)
         channel->m_DMAByteCounter = 0x10000;
     }
 
-    switch (channel->m_Params.m_Direction) {
-    case Direction::aToB:
-        m_DmaRunningCtx.m_SrcAddress = channel->m_ABusAddress;
-        m_DmaRunningCtx.m_aBusAddress = &m_DmaRunningCtx.m_SrcAddress;
-        m_DmaRunningCtx.m_DestAddress = m_DmaRunningCtx.m_bBaseBusAddress;
-        m_DmaRunningCtx.m_bBusAddress = &m_DmaRunningCtx.m_DestAddress;
-        break;
-
-    case Direction::bToA:
-        m_DmaRunningCtx.m_SrcAddress = m_DmaRunningCtx.m_bBaseBusAddress;
-        m_DmaRunningCtx.m_bBusAddress = &m_DmaRunningCtx.m_SrcAddress;
-        m_DmaRunningCtx.m_DestAddress = channel->m_ABusAddress;
-        m_DmaRunningCtx.m_aBusAddress = &m_DmaRunningCtx.m_DestAddress;
-        break;
-
-    default:
-        m_DmaRunningCtx.m_aBusAddress = nullptr;
-        m_DmaRunningCtx.m_bBusAddress = nullptr;
-        assert(false);
-        break;
-    }
-
-    m_DmaRunningCtx.id = id;
-    m_DmaRunningCtx.m_Registers = channel;
-
     *cycles += kTimingDmaStart;
 }
 
-void Dma::dmaChannelContinue(int* cycles)
+void Dma::dmaChannelTransfer(int id, DmaChannel* channel, int* cycles)
 {
-    const int channelId = m_DmaRunningCtx.id;
-    auto channel = m_DmaRunningCtx.m_Registers;
-
-    switch (channel->m_Params.m_Mode) {
-    case 0:
-        m_Membus->writeU8(
-            m_DmaRunningCtx.m_DestAddress,
-            m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-        incrementABusAddress(channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-        channel->m_DMAByteCounter--;
-
-        *cycles += kTimingDmaAccess;
-        break;
-
-    case 1:
-        if (channel->m_DMAByteCounter >= 2) {
-            m_Membus->writeU8(
-                m_DmaRunningCtx.m_DestAddress,
-                m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-            incrementABusAddress(
-                channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-            (*m_DmaRunningCtx.m_bBusAddress)++;
-            *cycles += kTimingDmaAccess;
-
-            m_Membus->writeU8(
-                m_DmaRunningCtx.m_DestAddress,
-                m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-            incrementABusAddress(
-                channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-            *m_DmaRunningCtx.m_bBusAddress = m_DmaRunningCtx.m_bBaseBusAddress;
-            *cycles += kTimingDmaAccess;
-
-            channel->m_DMAByteCounter -= 2;
-        } else {
-            m_Membus->writeU8(
-                m_DmaRunningCtx.m_DestAddress,
-                m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-            incrementABusAddress(
-                channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-            *cycles += kTimingDmaAccess;
-
-            channel->m_DMAByteCounter = 0;
-        }
+    // B-Bus registers written (or read) by each unit, relative to BBAD
+    struct BBusPattern {
+        uint8_t m_Offsets[4];
+        size_t m_Count;
+    };
+
+    static const BBusPattern kBBusPatterns[] = {
+        {{0}, 1},
+        {{0, 1}, 2},
+        {{0, 0}, 2},
+        {{0, 0, 1, 1}, 4},
+        {{0, 1, 2, 3}, 4},
+        {{0, 1, 0, 1}, 4},
+        {{0, 0}, 2},
+        {{0, 0, 1, 1}, 4},
+    };
+
+    const BBusPattern& pattern = kBBusPatterns[channel->m_Params.m_Mode];
+    const uint32_t bBusAddress = 0x2100 | channel->m_BBusAddress;
+    const size_t size = channel->m_DMAByteCounter;
+    assert(size <= kMaxTransferSize);
+
+    int step;
+    switch (channel->m_ABusStep) {
+    case ABusStep::increment:
+        step = 1;
         break;
 
-    case 2:
-    case 6:
-        if (channel->m_DMAByteCounter >= 2) {
-            m_Membus->writeU8(
-                m_DmaRunningCtx.m_DestAddress,
-                m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-            incrementABusAddress(
-                channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-            *cycles += kTimingDmaAccess;
-
-            m_Membus->writeU8(
-                m_DmaRunningCtx.m_DestAddress,
-                m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-            incrementABusAddress(
-                channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-            *cycles += kTimingDmaAccess;
-
-            channel->m_DMAByteCounter -= 2;
-        } else {
-            m_Membus->writeU8(
-                m_DmaRunningCtx.m_DestAddress,
-                m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-            incrementABusAddress(
-                channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-            *cycles += kTimingDmaAccess;
-
-            channel->m_DMAByteCounter = 0;
-        }
+    case ABusStep::decrement:
+        step = -1;
         break;
 
-    case 4:
-        for (int i = 0; i < 4; i++) {
-            m_Membus->writeU8(
-                m_DmaRunningCtx.m_DestAddress,
-                m_Membus->readU8(m_DmaRunningCtx.m_SrcAddress));
-
-            incrementABusAddress(
-                channelId, channel, m_DmaRunningCtx.m_aBusAddress);
-            (*m_DmaRunningCtx.m_bBusAddress)++;
-
-            *cycles += kTimingDmaAccess;
-            channel->m_DMAByteCounter--;
-        }
-
-        *m_DmaRunningCtx.m_bBusAddress = m_DmaRunningCtx.m_bBaseBusAddress;
+    case ABusStep::fixed:
+        step = 0;
         break;
 
     default:
-        LOGC(TAG, "Unimplemented mode %d", channel->m_Params.m_Mode);
+        LOGC(
+            TAG,
+            "Unimplemented ABusStep %d",
+            static_cast<int>(channel->m_ABusStep));
         assert(false);
-        break;
+        return;
     }
 
-    uint8_t* channelCfg = &m_ChannelRegisters[channelId * kChannelCfgLen];
-    channelCfg[kRegDmaDASL] = channel->m_DMAByteCounter & 0xFF;
-    channelCfg[kRegDmaDASH] = (channel->m_DMAByteCounter & 0xFF00) >> 8;
-}
-
-void Dma::incrementABusAddress(
-    int id,
-    DmaChannel* channel,
-    uint32_t* aBusAddress)
-{
-    switch (channel->m_ABusStep) {
-    case ABusStep::increment:
-        (*aBusAddress) = (*aBusAddress & 0xFF0000) |
-                         ((*aBusAddress + 1) & 0xFFFF);
-        channel->m_ABusAddress = (channel->m_ABusAddress & 0xFF0000) |
-                                 ((channel->m_ABusAddress + 1) & 0xFFFF);
+    switch (channel->m_Params.m_Direction) {
+    case Direction::aToB:
+        m_Membus->readBlock(
+            channel->m_ABusAddress, step, m_TransferBuffer, size);
+        m_Membus->writeRegisterBlock(
+            bBusAddress,
+            pattern.m_Offsets,
+            pattern.m_Count,
+            m_TransferBuffer,
+            size);
         break;
 
-    case ABusStep::decrement:
-        (*aBusAddress) = (*aBusAddress & 0xFF0000) |
-                         ((*aBusAddress - 1) & 0xFFFF);
-        channel->m_ABusAddress = (channel->m_ABusAddress & 0xFF0000) |
-                                 ((channel->m_ABusAddress - 1) & 0xFFFF);
-        break;
+    case Direction::bToA:
+        for (size_t i = 0; i < size; i++) {
+            m_TransferBuffer[i] = m_Membus->readU8(
+                bBusAddress + pattern.m_Offsets[i % pattern.m_Count]);
+        }
 
-    case ABusStep::fixed:
+        m_Membus->writeBlock(
+            channel->m_ABusAddress, step, m_TransferBuffer, size);
         break;
 
     default:
-        LOGC(
-            TAG,
-            "Unimplemented ABusStep %d",
-            static_cast<int>(channel->m_ABusStep));
         assert(false);
         break;
     }
 
+    // Leave registers like at the end of a byte per byte transfer
+    channel->m_ABusAddress = (channel->m_ABusAddress & 0xFF0000) |
+                             ((channel->m_ABusAddress + step * size) & 0xFFFF);
+    channel->m_DMAByteCounter = 0;
+
     uint8_t* channelCfg = &m_ChannelRegisters[id * kChannelCfgLen];
     channelCfg[kRegDmaA1TL] = channel->m_ABusAddress & 0xFF;
     channelCfg[kRegDmaA1TH] = (channel->m_ABusAddress & 0xFF00) >> 8;
+    channelCfg[kRegDmaDASL] = 0;
+    channelCfg[kRegDmaDASH] = 0;
+
+    *cycles += size * kTimingDmaAccess;
 }
 
-void Dma::dumpToFile(FILE* f)
+void Dma::serialize(Serializer* s)
 {
-    SchedulerTask::dumpToFile(f);
-
-    fwrite(&m_Vblank, sizeof(m_Vblank), 1, f);
-    fwrite(&m_DmaChannels, sizeof(m_DmaChannels), 1, f);
-    fwrite(&m_HdmaChannels, sizeof(m_HdmaChannels), 1, f);
-    fwrite(&m_ChannelRegisters, sizeof(m_ChannelRegisters), 1, f);
-    fwrite(&m_ActiveDmaChannels, sizeof(m_ActiveDmaChannels), 1, f);
-    fwrite(&m_ActiveHdmaChannels, sizeof(m_ActiveHdmaChannels), 1, f);
+    SchedulerTask::serialize(s);
+
+    s->write(&m_Vblank, sizeof(m_Vblank));
+    s->write(&m_DmaChannels, sizeof(m_DmaChannels));
+    s->write(&m_HdmaChannels, sizeof(m_HdmaChannels));
+    s->write(&m_ChannelRegisters, sizeof(m_ChannelRegisters));
+    s->write(&m_ActiveDmaChannels, sizeof(m_ActiveDmaChannels));
+    s->write(&m_ActiveHdmaChannels, sizeof(m_ActiveHdmaChannels));
 }
 
-void Dma::loadFromFile(FILE* f)
+void Dma::unserialize(Deserializer* d)
 {
-    SchedulerTask::loadFromFile(f);
-
-    fread(&m_Vblank, sizeof(m_Vblank), 1, f);
-    fread(&m_DmaChannels, sizeof(m_DmaChannels), 1, f);
-    fread(&m_HdmaChannels, sizeof(m_HdmaChannels), 1, f);
-    fread(&m_ChannelRegisters, sizeof(m_ChannelRegisters), 1, f);
-    fread(&m_ActiveDmaChannels, sizeof(m_ActiveDmaChannels), 1, f);
-    fread(&m_ActiveHdmaChannels, sizeof(m_ActiveHdmaChannels), 1, f);
+    SchedulerTask::unserialize(d);
+
+    d->read(&m_Vblank, sizeof(m_Vblank));
+    d->read(&m_DmaChannels, sizeof(m_DmaChannels));
+    d->read(&m_HdmaChannels, sizeof(m_HdmaChannels));
+    d->read(&m_ChannelRegisters, sizeof(m_ChannelRegisters));
+    d->read(&m_ActiveDmaChannels, sizeof(m_ActiveDmaChannels));
+    d->read(&m_ActiveHdmaChannels, sizeof(m_ActiveHdmaChannels));
 }
 
 void Dma::onScanStarted()
@@ -24,8 +24,8 @@ public:
     uint8_t readU8(uint32_t addr) override;
     void writeU8(uint32_t addr, uint8_t value) override;
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
 
     int run() override;
 
@@ -68,19 +68,6 @@ private:
         uint32_t m_DMAByteCounter;
     };
 
-    static constexpr int kUnknownChannelId = -1;
-
-    struct DmaRunningCtx {
-        int id = kUnknownChannelId;
-        DmaChannel* m_Registers = nullptr;
-
-        uint32_t m_bBaseBusAddress;
-        uint32_t m_SrcAddress;
-        uint32_t m_DestAddress;
-        uint32_t* m_aBusAddress;
-        uint32_t* m_bBusAddress;
-    };
-
     struct HdmaChannel {
         bool m_Running;
 
@@ -99,12 +86,7 @@ private:
 
 private:
     void dmaChannelStart(int id, DmaChannel* channel, int* cycles);
-    void dmaChannelContinue(int* cycles);
-
-    void incrementABusAddress(
-        int id,
-        DmaChannel* channel,
-        uint32_t* aBusAddress);
+    void dmaChannelTransfer(int id, DmaChannel* channel, int* cycles);
 
 private:
     std::shared_ptr<Scheduler> m_Scheduler;
@@ -119,7 +101,8 @@ private:
     uint8_t m_ActiveHdmaChannels = 0;
     uint8_t m_ActiveDmaChannels = 0;
 
-    DmaRunningCtx m_DmaRunningCtx;
+    static constexpr size_t kMaxTransferSize = 0x10000;
+    uint8_t m_TransferBuffer[kMaxTransferSize];
 };
 
 } // namespace msfce::core
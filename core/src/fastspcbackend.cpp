@@ -0,0 +1,14 @@
+// Selects Fast_SNES_SPC, don't include the accurate SNES_SPC.h in this file
+#define SPC_FAST_DSP 1
+#include <snes_spc/SNES_SPC.h>
+
+#include "spcbackendimpl.h"
+
+namespace msfce::core {
+
+std::unique_ptr<SpcBackend> createFastSpcBackend()
+{
+    return std::make_unique<SpcBackendImpl<SNES_SPC>>();
+}
+
+} // namespace msfce::core
@@ -93,24 +93,24 @@ void Maths::writeU8(uint32_t addr, uint8_t value)
     }
 }
 
-void Maths::dumpToFile(FILE* f)
+void Maths::serialize(Serializer* s)
 {
-    fwrite(&m_Multiplicand, sizeof(m_Multiplicand), 1, f);
-    fwrite(&m_Multiplier, sizeof(m_Multiplier), 1, f);
-    fwrite(&m_Dividend, sizeof(m_Dividend), 1, f);
-    fwrite(&m_Divisor, sizeof(m_Divisor), 1, f);
-    fwrite(&m_Quotient, sizeof(m_Quotient), 1, f);
-    fwrite(&m_RemainderProduct, sizeof(m_RemainderProduct), 1, f);
+    s->write(&m_Multiplicand, sizeof(m_Multiplicand));
+    s->write(&m_Multiplier, sizeof(m_Multiplier));
+    s->write(&m_Dividend, sizeof(m_Dividend));
+    s->write(&m_Divisor, sizeof(m_Divisor));
+    s->write(&m_Quotient, sizeof(m_Quotient));
+    s->write(&m_RemainderProduct, sizeof(m_RemainderProduct));
 }
 
-void Maths::loadFromFile(FILE* f)
+void Maths::unserialize(Deserializer* d)
 {
-    fread(&m_Multiplicand, sizeof(m_Multiplicand), 1, f);
-    fread(&m_Multiplier, sizeof(m_Multiplier), 1, f);
-    fread(&m_Dividend, sizeof(m_Dividend), 1, f);
-    fread(&m_Divisor, sizeof(m_Divisor), 1, f);
-    fread(&m_Quotient, sizeof(m_Quotient), 1, f);
-    fread(&m_RemainderProduct, sizeof(m_RemainderProduct), 1, f);
+    d->read(&m_Multiplicand, sizeof(m_Multiplicand));
+    d->read(&m_Multiplier, sizeof(m_Multiplier));
+    d->read(&m_Dividend, sizeof(m_Dividend));
+    d->read(&m_Divisor, sizeof(m_Divisor));
+    d->read(&m_Quotient, sizeof(m_Quotient));
+    d->read(&m_RemainderProduct, sizeof(m_RemainderProduct));
 }
 
 } // namespace msfce::core
@@ -15,8 +15,8 @@ public:
     uint8_t readU8(uint32_t addr) override;
     void writeU8(uint32_t addr, uint8_t value) override;
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
 
 private:
     uint16_t m_Multiplicand = 0;
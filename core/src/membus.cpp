@@ -1,4 +1,6 @@
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 #include "msfce/core/log.h"
 #include "registers.h"
 #include "timings.h"
@@ -12,6 +14,11 @@ constexpr uint32_t kComponentAccessR = (1 << 0);
 constexpr uint32_t kComponentAccessW = (1 << 1);
 constexpr uint32_t kComponentAccessRW = kComponentAccessR | kComponentAccessW;
 
+uint32_t stepAddress(uint32_t addr, int step, size_t count)
+{
+    return (addr & 0xFF0000) | ((addr + step * count) & 0xFFFF);
+}
+
 } // anonymous namespace
 
 namespace msfce::core {
@@ -180,13 +187,9 @@ void Membus::initHighRom()
     };
 }
 
-Membus::ComponentHandler* Membus::getComponentFromAddr(
+const Membus::MemoryRange* Membus::getRangeFromAddr(
     uint32_t addr,
-    MemComponentType* type,
-    uint8_t* outBankId,
-    uint16_t* outOffset,
-    int* cycles,
-    uint32_t access)
+    uint8_t* outTargetBank)
 {
     const MemoryRange* range = nullptr;
 
@@ -216,6 +219,24 @@ Membus::ComponentHandler* Membus::getComponentFromAddr(
         }
     }
 
+    *outTargetBank = targetBank;
+
+    return range;
+}
+
+Membus::ComponentHandler* Membus::getComponentFromAddr(
+    uint32_t addr,
+    MemComponentType* type,
+    uint8_t* outBankId,
+    uint16_t* outOffset,
+    int* cycles,
+    uint32_t access)
+{
+    uint8_t bankId = addr >> 16;
+    uint16_t offset = addr & 0xFFFF;
+    uint8_t targetBank;
+
+    const MemoryRange* range = getRangeFromAddr(addr, &targetBank);
     if (!range) {
         return nullptr;
     } else if (!(range->access & access)) {
@@ -243,9 +264,57 @@ int Membus::getRomTiming(uint8_t bank)
     return m_FastRom ? kTimingRomFastAccess : kTimingRomSlowAccess;
 }
 
+void Membus::mapPages(ComponentHandler* component, MemComponentType type)
+{
+    for (int pageIdx = 0; pageIdx < kPageCount; pageIdx++) {
+        uint32_t addr = pageIdx << kPageShift;
+        uint16_t offset = addr & 0xFFFF;
+        uint8_t targetBank;
+
+        // Page must be fully covered by a range of this component
+        const MemoryRange* range = getRangeFromAddr(addr, &targetBank);
+        if (!range || range->type != type || range->offsetStart > offset ||
+            range->offsetEnd < offset + kPageMask) {
+            continue;
+        }
+
+        // Address conversion must be linear inside the page
+        uint32_t finalAddr;
+        if (component->addrConverter) {
+            finalAddr = component->addrConverter(targetBank, offset);
+
+            uint32_t lastAddr =
+                component->addrConverter(targetBank, offset + kPageMask);
+            if (lastAddr - finalAddr != kPageMask) {
+                continue;
+            }
+        } else {
+            finalAddr = (targetBank << 16) | offset;
+        }
+
+        uint8_t* ptr = component->ptr->getHostPointer(finalAddr, kPageSize);
+        if (!ptr) {
+            continue;
+        }
+
+        Page* page = &m_Pages[pageIdx];
+        page->read = (range->access & kComponentAccessR) ? ptr : nullptr;
+        page->write = (range->access & kComponentAccessW) ? ptr : nullptr;
+
+        if (range->type == MemComponentType::rom) {
+            page->cycles = getRomTiming(addr >> 16);
+        } else {
+            page->cycles = range->cycles;
+        }
+    }
+}
+
 int Membus::plugComponent(const std::shared_ptr<MemComponent>& component)
 {
-    m_Components[enumToInt(component->getType())].ptr = component;
+    ComponentHandler* handler = &m_Components[enumToInt(component->getType())];
+    handler->ptr = component;
+
+    mapPages(handler, component->getType());
 
     return 0;
 }
@@ -258,6 +327,15 @@ uint8_t Membus::readU8(uint32_t addr, int* cycles)
     uint16_t offset;
     uint32_t finalAddr;
 
+    const Page& page = m_Pages[(addr & 0xFFFFFF) >> kPageShift];
+    if (page.read) {
+        if (cycles) {
+            *cycles += page.cycles;
+        }
+
+        return page.read[addr & kPageMask];
+    }
+
     component = getComponentFromAddr(
         addr, &type, &bank, &offset, cycles, kComponentAccessR);
     if (!component) {
@@ -299,6 +377,16 @@ void Membus::writeU8(uint32_t addr, uint8_t value, int* cycles)
     uint16_t offset;
     uint32_t finalAddr;
 
+    const Page& page = m_Pages[(addr & 0xFFFFFF) >> kPageShift];
+    if (page.write) {
+        if (cycles) {
+            *cycles += page.cycles;
+        }
+
+        page.write[addr & kPageMask] = value;
+        return;
+    }
+
     component = getComponentFromAddr(
         addr, &type, &bank, &offset, cycles, kComponentAccessW);
     if (!component) {
@@ -328,6 +416,119 @@ void Membus::writeU16(uint32_t addr, uint16_t value, int* cycles)
     writeU8(addr + 1, value >> 8, cycles);
 }
 
+void Membus::readBlock(uint32_t addr, int step, uint8_t* data, size_t size)
+{
+    while (size) {
+        const Page& page = m_Pages[(addr & 0xFFFFFF) >> kPageShift];
+        uint32_t pageOffset = addr & kPageMask;
+        size_t count;
+
+        if (!page.read) {
+            *data = readU8(addr);
+            count = 1;
+        } else if (step > 0) {
+            count = std::min<size_t>(size, kPageSize - pageOffset);
+            memcpy(data, &page.read[pageOffset], count);
+        } else if (step < 0) {
+            count = std::min<size_t>(size, pageOffset + 1);
+            for (size_t i = 0; i < count; i++) {
+                data[i] = page.read[pageOffset - i];
+            }
+        } else {
+            count = size;
+            memset(data, page.read[pageOffset], count);
+        }
+
+        addr = stepAddress(addr, step, count);
+        data += count;
+        size -= count;
+    }
+}
+
+void Membus::writeBlock(
+    uint32_t addr,
+    int step,
+    const uint8_t* data,
+    size_t size)
+{
+    while (size) {
+        const Page& page = m_Pages[(addr & 0xFFFFFF) >> kPageShift];
+        uint32_t pageOffset = addr & kPageMask;
+        size_t count;
+
+        if (!page.write) {
+            writeU8(addr, *data);
+            count = 1;
+        } else if (step > 0) {
+            count = std::min<size_t>(size, kPageSize - pageOffset);
+            memcpy(&page.write[pageOffset], data, count);
+        } else if (step < 0) {
+            count = std::min<size_t>(size, pageOffset + 1);
+            for (size_t i = 0; i < count; i++) {
+                page.write[pageOffset - i] = data[i];
+            }
+        } else {
+            // Only the last write is visible
+            count = size;
+            page.write[pageOffset] = data[count - 1];
+        }
+
+        addr = stepAddress(addr, step, count);
+        data += count;
+        size -= count;
+    }
+}
+
+void Membus::writeRegisterBlock(
+    uint32_t addr,
+    const uint8_t* offsets,
+    size_t offsetCount,
+    const uint8_t* data,
+    size_t size)
+{
+    ComponentHandler* component = nullptr;
+    uint32_t finalAddr = 0;
+
+    // All registers have to be handled by the same component, at the same
+    // relative addresses, to be forwarded at once
+    for (size_t i = 0; i < offsetCount; i++) {
+        MemComponentType type;
+        uint8_t bank;
+        uint16_t offset;
+        uint32_t regAddr = addr + offsets[i];
+
+        ComponentHandler* regComponent = getComponentFromAddr(
+            regAddr, &type, &bank, &offset, nullptr, kComponentAccessW);
+        if (!regComponent || type == MemComponentType::membus ||
+            !regComponent->ptr || !regComponent->addrConverter) {
+            component = nullptr;
+            break;
+        }
+
+        uint32_t regFinalAddr = regComponent->addrConverter(bank, offset);
+        if (i == 0) {
+            component = regComponent;
+            finalAddr = regFinalAddr - offsets[i];
+        } else if (
+            regComponent != component ||
+            regFinalAddr != finalAddr + offsets[i]) {
+            component = nullptr;
+            break;
+        }
+    }
+
+    if (!component) {
+        for (size_t i = 0; i < size; i++) {
+            writeU8(addr + offsets[i % offsetCount], data[i]);
+        }
+
+        return;
+    }
+
+    component->ptr->writeRegisterBlock(
+        finalAddr, offsets, offsetCount, data, size);
+}
+
 uint8_t Membus::internalReadU8(uint32_t addr)
 {
     switch (addr) {
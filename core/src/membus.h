@@ -28,6 +28,19 @@ public:
     void writeU8(uint32_t addr, uint8_t value, int* cycles = nullptr);
     void writeU16(uint32_t addr, uint16_t value, int* cycles = nullptr);
 
+    // Block accesses for DMA. Address is moved by `step` (-1, 0 or 1) after
+    // each byte and wraps inside its bank.
+    void readBlock(uint32_t addr, int step, uint8_t* data, size_t size);
+    void writeBlock(uint32_t addr, int step, const uint8_t* data, size_t size);
+
+    // See MemComponent::writeRegisterBlock()
+    void writeRegisterBlock(
+        uint32_t addr,
+        const uint8_t* offsets,
+        size_t offsetCount,
+        const uint8_t* data,
+        size_t size);
+
 private:
     enum class BankType {
         invalid,
@@ -76,10 +89,24 @@ private:
         std::function<uint32_t(uint8_t bank, uint16_t offset)> addrConverter;
     };
 
+    // Page backed by a plain buffer, accessed without the component
+    struct Page {
+        uint8_t* read = nullptr;
+        uint8_t* write = nullptr;
+        int cycles = 0;
+    };
+
+    static constexpr int kPageShift = 12;
+    static constexpr uint32_t kPageSize = 1 << kPageShift;
+    static constexpr uint32_t kPageMask = kPageSize - 1;
+    static constexpr int kPageCount = 1 << (24 - kPageShift);
+
 private:
     void initLowRom();
     void initHighRom();
 
+    const MemoryRange* getRangeFromAddr(uint32_t addr, uint8_t* targetBank);
+
     ComponentHandler* getComponentFromAddr(
         uint32_t addr,
         MemComponentType* type,
@@ -90,6 +117,8 @@ private:
 
     int getRomTiming(uint8_t bank);
 
+    void mapPages(ComponentHandler* component, MemComponentType type);
+
     uint8_t internalReadU8(uint32_t addr);
     void internalWriteU8(uint32_t addr, uint8_t value);
 
@@ -100,7 +129,10 @@ private:
     ComponentHandler m_Components[kComponentTypeCount];
 
     // LUT for system area (often accessed)
-    const MemoryRange* m_SystemArea[0x8000];
+    const MemoryRange* m_SystemArea[0x8000] = {};
+
+    // Direct access to WRAM, ROM and SRAM, MMIO pages are left empty
+    Page m_Pages[kPageCount];
 
     static const MemoryMap s_LowRomMap;
     static const MemoryMap s_HighRomMap;
@@ -11,6 +11,23 @@ MemComponentType MemComponent::getType() const
     return m_Type;
 }
 
+uint8_t* MemComponent::getHostPointer(uint32_t address, size_t size)
+{
+    return nullptr;
+}
+
+void MemComponent::writeRegisterBlock(
+    uint32_t address,
+    const uint8_t* offsets,
+    size_t offsetCount,
+    const uint8_t* data,
+    size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        writeU8(address + offsets[i % offsetCount], data[i]);
+    }
+}
+
 BufferMemComponent::BufferMemComponent(MemComponentType type, size_t size)
     : MemComponent(type), m_Size(size)
 {
@@ -34,6 +51,16 @@ void BufferMemComponent::writeU8(uint32_t address, uint8_t value)
     m_Data[address % m_Size] = value;
 }
 
+uint8_t* BufferMemComponent::getHostPointer(uint32_t address, size_t size)
+{
+    size_t offset = address % m_Size;
+    if (offset + size > m_Size) {
+        return nullptr;
+    }
+
+    return &m_Data[offset];
+}
+
 void BufferMemComponent::dumpToFile(FILE* f)
 {
     fwrite(m_Data.data(), m_Data.size(), 1, f);
@@ -44,4 +71,14 @@ void BufferMemComponent::loadFromFile(FILE* f)
     fread(m_Data.data(), m_Data.size(), 1, f);
 }
 
+void BufferMemComponent::serialize(Serializer* s)
+{
+    s->write(m_Data.data(), m_Data.size());
+}
+
+void BufferMemComponent::unserialize(Deserializer* d)
+{
+    d->read(m_Data.data(), m_Data.size());
+}
+
 } // namespace msfce::core
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <vector>
 
+#include "serializer.h"
 #include "utils.h"
 
 namespace msfce::core {
@@ -37,6 +38,19 @@ public:
     virtual uint8_t readU8(uint32_t address) = 0;
     virtual void writeU8(uint32_t address, uint8_t value) = 0;
 
+    // Get a pointer to `size` contiguous bytes starting at `address`.
+    // Returns nullptr if the component isn't backed by a plain buffer.
+    virtual uint8_t* getHostPointer(uint32_t address, size_t size);
+
+    // Write `size` bytes of `data`, byte i going to the register
+    // `address + offsets[i % offsetCount]`. Used by DMA to feed I/O ports.
+    virtual void writeRegisterBlock(
+        uint32_t address,
+        const uint8_t* offsets,
+        size_t offsetCount,
+        const uint8_t* data,
+        size_t size);
+
 private:
     MemComponentType m_Type;
 };
@@ -49,9 +63,14 @@ public:
     uint8_t readU8(uint32_t address) override;
     void writeU8(uint32_t address, uint8_t value) override;
 
+    uint8_t* getHostPointer(uint32_t address, size_t size) override;
+
     void dumpToFile(FILE* f);
     void loadFromFile(FILE* f);
 
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
+
 private:
     std::vector<uint8_t> m_Data;
     size_t m_Size;
@@ -1,7 +1,16 @@
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#endif
+
 #include "msfce/core/log.h"
 #include "registers.h"
+#include "scheduler.h"
 #include "timings.h"
 #include "utils.h"
 #include "ppu.h"
@@ -27,6 +36,24 @@ constexpr int kPpuObjBpp = 4;
 constexpr int kPpuObjTileSize = 8 * kPpuObjBpp; // 8x8 4bpp
 constexpr int kPpuObjPaletteOffset = 128;
 
+// Sprites and sprite tiles fetched per line
+constexpr int kPpuObjLineCount = 32;
+constexpr int kPpuObjLineTileCount = 34;
+
+// Mode 7 map is 128x128 tiles, tiles are 64 VRAM words
+constexpr int kPpuMode7TilemapWidth = 128;
+constexpr int kPpuMode7MapSize = kPpuMode7TilemapWidth * 8;
+constexpr int kPpuMode7TileSize = 64 * 2;
+
+// Screens are resolved by blocks of pixels
+constexpr int kRenderBlockSize = 16;
+
+// Mode 7 offsets and center are signed 13 bits values
+constexpr int signExtend13(int16_t v)
+{
+    return static_cast<int16_t>(v << 3) >> 3;
+}
+
 constexpr uint16_t convert1kWorkStep(uint16_t v)
 {
     return v << 11;
@@ -223,6 +250,20 @@ uint32_t tilemapMapper64x64(uint16_t tilemapBase, int x, int y)
     return tilemapBase + idx * kPpuTilemapSize;
 }
 
+template <int kTilemapSize>
+uint32_t mapTilemap(uint16_t tilemapBase, int x, int y)
+{
+    if constexpr (kTilemapSize == 0) {
+        return tilemapMapper32x32(tilemapBase, x, y);
+    } else if constexpr (kTilemapSize == 1) {
+        return tilemapMapper64x32(tilemapBase, x, y);
+    } else if constexpr (kTilemapSize == 2) {
+        return tilemapMapper32x64(tilemapBase, x, y);
+    } else {
+        return tilemapMapper64x64(tilemapBase, x, y);
+    }
+}
+
 // Set of functions to read the color of a pixel within a tile
 uint32_t tileReadColor2bpp(
     const uint8_t* tileData,
@@ -403,6 +444,89 @@ uint16_t translateVramAddress(uint16_t address, uint8_t translate)
     }
 }
 
+#if defined(__SSE2__)
+template <typename T>
+__m128i loadBlock(const T* data)
+{
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+template <typename T>
+void storeBlock(T* data, __m128i value)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data), value);
+}
+
+// Pick `a` where `mask` bits are set, `b` otherwise
+__m128i selectBlock(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+template <int kShift>
+__m128i applyColorMathFrag(
+    __m128i main,
+    __m128i sub,
+    bool subtract,
+    bool half)
+{
+    const __m128i maxFrag = _mm_set1_epi16(0b11111);
+
+    __m128i mainFrag = _mm_and_si128(_mm_srli_epi16(main, kShift), maxFrag);
+    __m128i subFrag = _mm_and_si128(_mm_srli_epi16(sub, kShift), maxFrag);
+    __m128i frag;
+
+    if (subtract) {
+        frag = _mm_subs_epu16(mainFrag, subFrag);
+    } else {
+        frag = _mm_add_epi16(mainFrag, subFrag);
+    }
+
+    if (half) {
+        frag = _mm_srli_epi16(frag, 1);
+    }
+
+    return _mm_slli_epi16(_mm_min_epi16(frag, maxFrag), kShift);
+}
+
+// Add or subtract 8 BGR555 colors, halve the results if requested
+__m128i applyColorMath(__m128i main, __m128i sub, bool subtract, bool half)
+{
+    return _mm_or_si128(
+        _mm_or_si128(
+            applyColorMathFrag<0>(main, sub, subtract, half),
+            applyColorMathFrag<5>(main, sub, subtract, half)),
+        applyColorMathFrag<10>(main, sub, subtract, half));
+}
+#else
+// Add or subtract two BGR555 colors, halve the result if requested
+uint16_t applyColorMath(uint16_t main, uint16_t sub, bool subtract, bool half)
+{
+    constexpr int kMaxFrag = 0b11111;
+    uint16_t c = 0;
+
+    for (int shift = 0; shift <= 10; shift += 5) {
+        int mainFrag = (main >> shift) & kMaxFrag;
+        int subFrag = (sub >> shift) & kMaxFrag;
+        int frag;
+
+        if (subtract) {
+            frag = std::max(mainFrag - subFrag, 0);
+        } else {
+            frag = mainFrag + subFrag;
+        }
+
+        if (half) {
+            frag /= 2;
+        }
+
+        c |= std::min(frag, kMaxFrag) << shift;
+    }
+
+    return c;
+}
+#endif
+
 } // anonymous namespace
 
 namespace msfce::core {
@@ -476,17 +600,32 @@ const Ppu::LayerPriority Ppu::s_LayerPriorityMode7[] = {
 };
 
 Ppu::Ppu(
+    const uint64_t& masterClock,
     ScanStartedCb scanStartedCb,
-    ScanStartedCb scanEndedCb,
-    RenderCb renderCb)
+    ScanStartedCb scanEndedCb)
     : MemComponent(MemComponentType::ppu)
     , SchedulerTask()
+    , m_MasterClock(masterClock)
     , m_ScanStartedCb(scanStartedCb)
     , m_ScanEndedCb(scanEndedCb)
-    , m_RenderCb(renderCb)
 {
 }
 
+void Ppu::setScheduler(const std::shared_ptr<Scheduler>& scheduler)
+{
+    m_Scheduler = scheduler;
+}
+
+void Ppu::setFramebuffer(const Framebuffer& framebuffer)
+{
+    m_Framebuffer = framebuffer;
+}
+
+const uint8_t* Ppu::getLineBrightness() const
+{
+    return m_LineBrightness;
+}
+
 void Ppu::dump() const
 {
     FILE* f;
@@ -523,6 +662,7 @@ uint8_t Ppu::readU8(uint32_t addr)
         return m_Ppu1OpenBus = (m_MPY >> 16) & 0xFF;
 
     case kRegSLHV:
+        catchUp();
         m_HPos = m_RenderX;
         m_VPos = m_RenderY;
         return 0;
@@ -659,6 +799,9 @@ uint8_t Ppu::readU8(uint32_t addr)
 
 void Ppu::writeU8(uint32_t addr, uint8_t value)
 {
+    // Dots before this write must be drawn with the previous state
+    catchUp();
+
     switch (addr) {
     case kRegINIDISP: {
         bool forcedBlanking = value & (1 << 7);
@@ -704,27 +847,13 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
         break;
     }
 
-    case kRegVMDATAL: {
-        uint16_t address =
-            translateVramAddress(m_VramAddress, m_VramAddressTranslate);
-        m_Vram[address] = value;
-
-        if (!m_VramIncrementHigh) {
-            incrementVramAddress();
-        }
+    case kRegVMDATAL:
+        writeVramData(false, value);
         break;
-    }
-
-    case kRegVMDATAH: {
-        uint16_t address =
-            translateVramAddress(m_VramAddress, m_VramAddressTranslate);
-        m_Vram[address + 1] = value;
 
-        if (m_VramIncrementHigh) {
-            incrementVramAddress();
-        }
+    case kRegVMDATAH:
+        writeVramData(true, value);
         break;
-    }
 
     // CGRAM registers
     case kRegCGADD:
@@ -734,15 +863,7 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
         break;
 
     case kRegCGDATA:
-        if (m_CgramLsbSet) {
-            m_Cgram[m_CgdataAddress] = ((value & 0x7F) << 8) | m_CgramLsb;
-
-            m_CgdataAddress++;
-            m_CgramLsbSet = false;
-        } else {
-            m_CgramLsb = value;
-            m_CgramLsbSet = true;
-        }
+        writeCgramData(value);
         break;
 
     // OAM registers
@@ -751,6 +872,10 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
 
         m_ObjGapSize = convert4kWorkStep((value >> 3) & 0b11);
         m_ObjBase = convert8kWorkStep(value & 0b111);
+
+        for (auto& obj : m_Objs) {
+            obj.m_Dirty = true;
+        }
         break;
 
     case kRegOAMADDL:
@@ -771,29 +896,9 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
         m_OamFlip = 0;
         break;
 
-    case kRegOAMDATA: {
-        if (!m_OamFlip) {
-            m_OamWriteRegister = (m_OamWriteRegister & 0xFF00) | value;
-        }
-
-        if (m_OamAddress & 0x100) {
-            int address = ((m_OamAddress & 0x10F) << 1) + (m_OamFlip & 1);
-            m_Oam[address] = value;
-        } else if (m_OamFlip) {
-            m_OamWriteRegister = (value << 8) | (m_OamWriteRegister & 0xFF);
-
-            int address = m_OamAddress << 1;
-            m_Oam[address] = m_OamWriteRegister & 0xFF;
-            m_Oam[address + 1] = m_OamWriteRegister >> 8;
-        }
-
-        m_OamFlip ^= 1;
-        if (!m_OamFlip) {
-            m_OamAddress++;
-            m_OamAddress &= 0x1FF;
-        }
+    case kRegOAMDATA:
+        writeOamData(value);
         break;
-    }
 
     // Background
     case kRegBGMODE: {
@@ -905,18 +1010,22 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
 
     case kRegWH0:
         m_Window1Config.m_Left = value;
+        m_WindowMasksDirty = true;
         break;
 
     case kRegWH1:
         m_Window1Config.m_Right = value;
+        m_WindowMasksDirty = true;
         break;
 
     case kRegWH2:
         m_Window2Config.m_Left = value;
+        m_WindowMasksDirty = true;
         break;
 
     case kRegWH3:
         m_Window2Config.m_Right = value;
+        m_WindowMasksDirty = true;
         break;
 
     case kRegW12SEL: {
@@ -930,6 +1039,8 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
             getWindowConfig((value >> 4) & 0b11);
         m_Window2Config.m_BackgroundConfig[1] =
             getWindowConfig((value >> 6) & 0b11);
+
+        m_WindowMasksDirty = true;
         break;
     }
 
@@ -944,6 +1055,8 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
             getWindowConfig((value >> 4) & 0b11);
         m_Window2Config.m_BackgroundConfig[3] =
             getWindowConfig((value >> 6) & 0b11);
+
+        m_WindowMasksDirty = true;
         break;
 
     case kRegWOBJSEL:
@@ -954,6 +1067,8 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
         // Math
         m_Window1Config.m_MathConfig = getWindowConfig((value >> 4) & 0b11);
         m_Window2Config.m_MathConfig = getWindowConfig((value >> 6) & 0b11);
+
+        m_WindowMasksDirty = true;
         break;
 
     case kRegWBGLOG:
@@ -962,11 +1077,14 @@ void Ppu::writeU8(uint32_t addr, uint8_t value)
                 static_cast<WindowLogic>((value >> (2 * i)) & 0b11);
         }
 
+        m_WindowMasksDirty = true;
         break;
 
     case kRegWOBJLOG:
         m_WindowLogicObj = static_cast<WindowLogic>(value & 0b11);
         m_WindowLogicMath = static_cast<WindowLogic>((value >> 2) & 0b11);
+
+        m_WindowMasksDirty = true;
         break;
 
     case kRegTMW:
@@ -1141,11 +1259,174 @@ void Ppu::setDrawConfig(DrawConfig config)
 
 void Ppu::setHVIRQConfig(HVIRQConfig config, uint16_t H, uint16_t V)
 {
+    catchUp();
+
     m_HVIRQ.m_Config = config;
 
     // FIXME: NTSC setting
     m_HVIRQ.m_H = std::min(H, static_cast<uint16_t>(339));
     m_HVIRQ.m_V = std::min(V, static_cast<uint16_t>(261));
+
+    // IRQ dot may have moved, update next wake up
+    if (m_Scheduler) {
+        m_Scheduler->resumeTask(this, getNextEventCycle() - m_MasterClock);
+    }
+}
+
+void Ppu::writeRegisterBlock(
+    uint32_t address,
+    const uint8_t* offsets,
+    size_t offsetCount,
+    const uint8_t* data,
+    size_t size)
+{
+    // Only data ports are handled here, other registers may have side
+    // effects on the scheduling
+    for (size_t i = 0; i < offsetCount; i++) {
+        switch (address + offsets[i]) {
+        case kRegVMDATAL:
+        case kRegVMDATAH:
+        case kRegCGDATA:
+        case kRegOAMDATA:
+            break;
+
+        default:
+            MemComponent::writeRegisterBlock(
+                address, offsets, offsetCount, data, size);
+            return;
+        }
+    }
+
+    // Dots before this write must be drawn with the previous state
+    catchUp();
+
+    for (size_t i = 0; i < size; i++) {
+        switch (address + offsets[i % offsetCount]) {
+        case kRegVMDATAL:
+            writeVramData(false, data[i]);
+            break;
+
+        case kRegVMDATAH:
+            writeVramData(true, data[i]);
+            break;
+
+        case kRegCGDATA:
+            writeCgramData(data[i]);
+            break;
+
+        case kRegOAMDATA:
+            writeOamData(data[i]);
+            break;
+
+        default:
+            assert(false);
+            break;
+        }
+    }
+}
+
+void Ppu::writeVramData(bool high, uint8_t value)
+{
+    uint16_t address =
+        translateVramAddress(m_VramAddress, m_VramAddressTranslate);
+    m_Vram[address + high] = value;
+    invalidateTileCaches(address + high);
+
+    if (m_VramIncrementHigh == high) {
+        incrementVramAddress();
+    }
+}
+
+void Ppu::writeCgramData(uint8_t value)
+{
+    if (m_CgramLsbSet) {
+        m_Cgram[m_CgdataAddress] = ((value & 0x7F) << 8) | m_CgramLsb;
+
+        m_CgdataAddress++;
+        m_CgramLsbSet = false;
+    } else {
+        m_CgramLsb = value;
+        m_CgramLsbSet = true;
+    }
+}
+
+void Ppu::writeOamData(uint8_t value)
+{
+    if (!m_OamFlip) {
+        m_OamWriteRegister = (m_OamWriteRegister & 0xFF00) | value;
+    }
+
+    if (m_OamAddress & 0x100) {
+        int address = ((m_OamAddress & 0x10F) << 1) + (m_OamFlip & 1);
+        m_Oam[address] = value;
+        invalidateObjs(address);
+    } else if (m_OamFlip) {
+        m_OamWriteRegister = (value << 8) | (m_OamWriteRegister & 0xFF);
+
+        int address = m_OamAddress << 1;
+        m_Oam[address] = m_OamWriteRegister & 0xFF;
+        m_Oam[address + 1] = m_OamWriteRegister >> 8;
+        invalidateObjs(address);
+    }
+
+    m_OamFlip ^= 1;
+    if (!m_OamFlip) {
+        m_OamAddress++;
+        m_OamAddress &= 0x1FF;
+    }
+}
+
+void Ppu::invalidateObjs(uint16_t oamAddress)
+{
+    if (oamAddress < 512) {
+        // Attributes are 4 bytes long
+        m_Objs[oamAddress / 4].m_Dirty = true;
+    } else {
+        // Each extra byte holds 2 bits of 4 sprites
+        int firstObj = (oamAddress - 512) * 4;
+        for (int i = firstObj; i < firstObj + 4; i++) {
+            m_Objs[i].m_Dirty = true;
+        }
+    }
+}
+
+void Ppu::invalidateTileCaches(uint16_t address)
+{
+    m_TileCache2bpp.invalidate(address);
+    m_TileCache4bpp.invalidate(address);
+    m_TileCache8bpp.invalidate(address);
+}
+
+template <int kBpp>
+const uint8_t* Ppu::getTileRow(uint16_t tileAddress, int row)
+{
+    if constexpr (kBpp == 2) {
+        return m_TileCache2bpp.getRow(m_Vram, tileAddress, row);
+    } else if constexpr (kBpp == 4) {
+        return m_TileCache4bpp.getRow(m_Vram, tileAddress, row);
+    } else {
+        static_assert(kBpp == 8);
+        return m_TileCache8bpp.getRow(m_Vram, tileAddress, row);
+    }
+}
+
+const uint8_t* Ppu::getTileRow(int bpp, uint16_t tileAddress, int row)
+{
+    switch (bpp) {
+    case 2:
+        return getTileRow<2>(tileAddress, row);
+
+    case 4:
+        return getTileRow<4>(tileAddress, row);
+
+    case 8:
+        return getTileRow<8>(tileAddress, row);
+
+    default:
+        LOGE(TAG, "Unsupported %d bpp", bpp);
+        assert(false);
+        return getTileRow<2>(tileAddress, row);
+    }
 }
 
 void Ppu::incrementVramAddress()
@@ -1187,12 +1468,72 @@ Ppu::TilemapMapper Ppu::getTilemapMapper(uint16_t tilemapSize) const
     return map[tilemapSize];
 }
 
-void Ppu::updateTileData(const Background* bg, RendererBgInfo* renderBg)
+template <int kBpp, int kTileSize, int kTilemapSize>
+Ppu::BgRenderer Ppu::makeBgRenderer()
+{
+    return {
+        &Ppu::fetchBgTile<kBpp, kTileSize, kTilemapSize>,
+        &Ppu::renderBgLine<kBpp, kTileSize, kTilemapSize, false>,
+        &Ppu::renderBgLine<kBpp, kTileSize, kTilemapSize, true>,
+    };
+}
+
+template <int kBpp, int kTileSize>
+Ppu::BgRenderer Ppu::getBgRenderer(uint16_t tilemapSize)
+{
+    static const BgRenderer map[] = {
+        makeBgRenderer<kBpp, kTileSize, 0>(),
+        makeBgRenderer<kBpp, kTileSize, 1>(),
+        makeBgRenderer<kBpp, kTileSize, 2>(),
+        makeBgRenderer<kBpp, kTileSize, 3>(),
+    };
+
+    static_assert(SIZEOF_ARRAY(map) == 4);
+    assert(tilemapSize < SIZEOF_ARRAY(map));
+
+    return map[tilemapSize];
+}
+
+Ppu::BgRenderer Ppu::getBgRenderer(
+    int tileBpp,
+    uint16_t tileSize,
+    uint16_t tilemapSize)
+{
+    assert(tileSize <= 1);
+
+    switch (tileBpp) {
+    case 2:
+        return tileSize ? getBgRenderer<2, 1>(tilemapSize)
+                        : getBgRenderer<2, 0>(tilemapSize);
+
+    case 4:
+        return tileSize ? getBgRenderer<4, 1>(tilemapSize)
+                        : getBgRenderer<4, 0>(tilemapSize);
+
+    case 8:
+        return tileSize ? getBgRenderer<8, 1>(tilemapSize)
+                        : getBgRenderer<8, 0>(tilemapSize);
+
+    default:
+        LOGC(TAG, "Unsupported %d bpp", tileBpp);
+        assert(false);
+        return getBgRenderer<2, 0>(tilemapSize);
+    }
+}
+
+template <int kBpp, int kTileSize, int kTilemapSize>
+void Ppu::fetchBgTile(RendererBgInfo* renderBg)
 {
+    // Tiles are square, see getTileDimension()
+    constexpr int kTileWidthPixel = (kTileSize + 1) * kPpuBaseTileWidth;
+    constexpr int kTileHeightPixel = (kTileSize + 1) * kPpuBaseTileHeight;
+
+    const Background* bg = renderBg->background;
+
     // Get tileinfo from tilemap
     // First we need to make a projection inside the submap
     // (The working tilemap is always a 32x32 one)
-    uint32_t tilemapBase = renderBg->tilemapMapper(
+    uint32_t tilemapBase = mapTilemap<kTilemapSize>(
         bg->m_TilemapBase, renderBg->tilemapX, renderBg->tilemapY);
 
     int subtilemapX = renderBg->tilemapX % kPpuTilemapWidth;
@@ -1210,6 +1551,14 @@ void Ppu::updateTileData(const Background* bg, RendererBgInfo* renderBg)
     renderBg->palette = (tileInfo >> 10) & 0b111;
     renderBg->tileIndex = tileInfo & 0b1111111111;
 
+    // 8 bpp tiles use the whole CGRAM
+    if (kBpp == 8) {
+        renderBg->colorBase = renderBg->cgramOffset;
+    } else {
+        renderBg->colorBase =
+            renderBg->cgramOffset + renderBg->palette * (1 << kBpp);
+    }
+
     // Get the real pixel coordinates
     // Use the flip status to point to the correct subtile
     // Then compute the subtile coordinate to be able to compute
@@ -1218,12 +1567,12 @@ void Ppu::updateTileData(const Background* bg, RendererBgInfo* renderBg)
     if (!renderBg->horizontalFlip) {
         realPixelX = renderBg->tilePixelX;
     } else {
-        realPixelX = renderBg->tileWidthPixel - renderBg->tilePixelX - 1;
+        realPixelX = kTileWidthPixel - renderBg->tilePixelX - 1;
     }
 
     int realPixelY;
     if (renderBg->verticalFlip) {
-        realPixelY = renderBg->tileHeightPixel - renderBg->tilePixelY - 1;
+        realPixelY = kTileHeightPixel - renderBg->tilePixelY - 1;
     } else {
         realPixelY = renderBg->tilePixelY;
     }
@@ -1233,401 +1582,187 @@ void Ppu::updateTileData(const Background* bg, RendererBgInfo* renderBg)
 
     renderBg->subtilePixelX = realPixelX % kPpuBaseTileWidth;
     renderBg->subtilePixelY = realPixelY % kPpuBaseTileHeight;
+
+    fetchBgSubtile<kBpp>(renderBg);
 }
 
-void Ppu::updateSubtileData(const Background* bg, RendererBgInfo* renderBg)
+template <int kBpp>
+void Ppu::fetchBgSubtile(RendererBgInfo* renderBg)
 {
+    // Tiles are always 8x8, 16x16 tiles are a composition of 8x8 tiles
+    constexpr int kTileSize = kBpp * 8;
+
     // The second row of tiles is located 0x10 tiles after
     int tileBaseAddr =
-        bg->m_TileBase + renderBg->tileSize * renderBg->tileIndex;
-    int tileAddr = tileBaseAddr + renderBg->subtileX * renderBg->tileSize +
-                   renderBg->subtileY * 0x10 * renderBg->tileSize;
+        renderBg->background->m_TileBase + kTileSize * renderBg->tileIndex;
+    int tileAddr = tileBaseAddr + renderBg->subtileX * kTileSize +
+                   renderBg->subtileY * 0x10 * kTileSize;
     tileAddr &= 0xFFFF;
 
-    // Point to the current tile lane
-    const uint8_t* tileData = m_Vram + tileAddr;
-
-    if (renderBg->tileBpp == 2) {
-        // 0-1 bits are stored in a 8 words chunk, in the first plane
-        renderBg->tileDataPlane0 = tileData + renderBg->subtilePixelY * 2;
-        renderBg->tileDataPlane1 = nullptr;
-    } else if (renderBg->tileBpp == 4) {
-        // 0-1 bits are stored in a 8 words chunk, in the first plane
-        renderBg->tileDataPlane0 = tileData + renderBg->subtilePixelY * 2;
-        // 2-3 bits are stored in the second plane
-        renderBg->tileDataPlane1 =
-            renderBg->tileDataPlane0 + renderBg->tileSize / 2;
-    } else if (renderBg->tileBpp == 8) {
-        // 0-1 bits are stored in a 8 words chunk, in the first plane
-        renderBg->tileDataPlane0 = tileData + renderBg->subtilePixelY * 2;
-        // 2-3 bits are stored in the second plane
-        renderBg->tileDataPlane1 = renderBg->tileDataPlane0 + 0x10;
-        // 4-5 bits are stored in the third plane
-        renderBg->tileDataPlane2 = renderBg->tileDataPlane1 + 0x10;
-        // 6-7 bits are stored in the forth plane
-        renderBg->tileDataPlane3 = renderBg->tileDataPlane2 + 0x10;
-    } else {
-        LOGE(TAG, "Unsupported %d bpp", renderBg->tileBpp);
-        assert(false);
-    }
+    renderBg->tileRow = getTileRow<kBpp>(tileAddr, renderBg->subtilePixelY);
 }
 
-bool Ppu::getScreenCurrentPixel(
-    int x,
-    int y,
-    const ScreenConfig& screenConfig,
-    uint32_t* color,
-    BgColorProp* colorProp)
+// Dots must not go past the end of the current subtile
+template <int kBpp, int kTileSize, int kTilemapSize>
+void Ppu::moveBgDots(RendererBgInfo* renderBg, int dots)
 {
-    for (size_t prioIdx = 0;
-         m_RenderLayerPriority[prioIdx].m_Layer != Layer::none;
-         prioIdx++) {
-        const auto& layer = m_RenderLayerPriority[prioIdx];
-
-        if (layer.m_Layer == Layer::background) {
-            RendererBgInfo* renderBg = &m_RenderBgInfo[layer.m_BgIdx];
-            bool colorValid = getBackgroundCurrentPixel(
-                x, screenConfig, renderBg, layer.m_Priority, color);
-
-            if (colorValid) {
-                if (colorProp) {
-                    colorProp->m_Layer = Layer::background;
-                    colorProp->m_BgIdx = layer.m_BgIdx;
-                }
+    // See getTileDimension() and getTilemapDimension()
+    constexpr int kTileWidth = kTileSize + 1;
+    constexpr int kTilemapWidth = kTilemapSize & 1 ? 64 : 32;
 
-                return true;
-            }
-        } else if (layer.m_Layer == Layer::sprite) {
-            int palette;
-            bool colorValid = getSpriteCurrentPixel(
-                x, y, screenConfig, layer.m_Priority, color, &palette);
-
-            if (colorValid) {
-                if (colorProp) {
-                    colorProp->m_Layer = Layer::sprite;
-                    colorProp->m_Palette = palette;
-                }
+    renderBg->tilePixelX =
+        (renderBg->tilePixelX + dots) % (kTileWidth * kPpuBaseTileWidth);
 
-                return true;
-            }
+    // There is only things to do when we've reached to end of the
+    // current subtile
+    if (!renderBg->horizontalFlip) {
+        renderBg->subtilePixelX += dots;
+        if (renderBg->subtilePixelX < kPpuBaseTileWidth) {
+            return;
         }
-    }
 
-    return false;
-}
+        renderBg->subtilePixelX = 0;
+        renderBg->subtileX++;
 
-bool Ppu::getBackgroundCurrentPixel(
-    int x,
-    const ScreenConfig& screenConfig,
-    const RendererBgInfo* renderBg,
-    int priority,
-    uint32_t* color)
-{
-    auto background = renderBg->background;
+        if (renderBg->subtileX < kTileWidth) {
+            fetchBgSubtile<kBpp>(renderBg);
+            return;
+        }
+    } else {
+        renderBg->subtilePixelX -= dots;
+        if (renderBg->subtilePixelX >= 0) {
+            return;
+        }
 
-    if (renderBg->priority != priority) {
-        return false;
-    }
+        renderBg->subtilePixelX = kPpuBaseTileWidth - 1;
+        renderBg->subtileX--;
 
-    // Check if background is enabled
-    if (!screenConfig.m_BgEnabled[renderBg->bgIdx]) {
-        return false;
+        if (renderBg->subtileX >= 0) {
+            fetchBgSubtile<kBpp>(renderBg);
+            return;
+        }
     }
 
-    // Check if background is inside window
-    bool pixelInWindow = false;
-
-    if (screenConfig.m_Window_BgDisable[renderBg->bgIdx]) {
-        pixelInWindow = applyWindowLogic(
-            x,
-            m_Window1Config.m_BackgroundConfig[renderBg->bgIdx],
-            m_Window2Config.m_BackgroundConfig[renderBg->bgIdx],
-            m_WindowLogicBackground[renderBg->bgIdx]);
-    }
+    renderBg->tilemapX = (renderBg->tilemapX + 1) % kTilemapWidth;
+    fetchBgTile<kBpp, kTileSize, kTilemapSize>(renderBg);
+}
 
-    if (pixelInWindow) {
-        return false;
+void Ppu::setHVIRQ(int x, int y)
+{
+    if (m_HVIRQ.m_Config == HVIRQConfig::Disable) {
+        return;
     }
 
-    // Get pixel and draw it
-    uint32_t tilePixelColor;
-
-    int realPixelX = kPpuBaseTileWidth - renderBg->subtilePixelX - 1;
-
-    tilePixelColor = (renderBg->tileDataPlane0[0] >> realPixelX) & 1;
-    tilePixelColor |= ((renderBg->tileDataPlane0[1] >> realPixelX) & 1) << 1;
-
-    if (renderBg->tileBpp == 4) {
-        if (!renderBg->tileDataPlane1) {
-            LOGW(TAG, "%s(): renderBg->tileDataPlane1 == nullptr", __func__);
-            return false;
+    switch (m_HVIRQ.m_Config) {
+    case HVIRQConfig::H:
+        if (x == m_HVIRQ.m_H) {
+            m_Events |= Event_HV_IRQ;
         }
 
-        assert(renderBg->tileDataPlane1);
-        tilePixelColor |= ((renderBg->tileDataPlane1[0] >> realPixelX) & 1)
-                          << 2;
-        tilePixelColor |= ((renderBg->tileDataPlane1[1] >> realPixelX) & 1)
-                          << 3;
-    } else if (renderBg->tileBpp == 8) {
-        if (!renderBg->tileDataPlane1) {
-            LOGW(TAG, "%s(): renderBg->tileDataPlane1 == nullptr", __func__);
-            return false;
-        }
+        break;
 
-        if (!renderBg->tileDataPlane2) {
-            LOGW(TAG, "%s(): renderBg->tileDataPlane2 == nullptr", __func__);
-            return false;
+    case HVIRQConfig::V:
+        if (x == 0 && y == m_HVIRQ.m_V) {
+            m_Events |= Event_HV_IRQ;
         }
 
-        if (!renderBg->tileDataPlane3) {
-            LOGW(TAG, "%s(): renderBg->tileDataPlane3 == nullptr", __func__);
-            return false;
-        }
+        break;
 
-        assert(renderBg->tileDataPlane1);
-        tilePixelColor |= ((renderBg->tileDataPlane1[0] >> realPixelX) & 1)
-                          << 2;
-        tilePixelColor |= ((renderBg->tileDataPlane1[1] >> realPixelX) & 1)
-                          << 3;
+    case HVIRQConfig::HV:
+        if (x == m_HVIRQ.m_H && y == m_HVIRQ.m_V) {
+            m_Events |= Event_HV_IRQ;
+        }
 
-        assert(renderBg->tileDataPlane2);
-        tilePixelColor |= ((renderBg->tileDataPlane2[0] >> realPixelX) & 1)
-                          << 4;
-        tilePixelColor |= ((renderBg->tileDataPlane2[1] >> realPixelX) & 1)
-                          << 5;
+        break;
 
-        assert(renderBg->tileDataPlane3);
-        tilePixelColor |= ((renderBg->tileDataPlane3[0] >> realPixelX) & 1)
-                          << 6;
-        tilePixelColor |= ((renderBg->tileDataPlane3[1] >> realPixelX) & 1)
-                          << 7;
-    }
-
-    if (tilePixelColor == 0) {
-        return false;
+    default:
+        break;
     }
-
-    *color = getColorFromCgram(
-        renderBg->bgIdx, renderBg->tileBpp, renderBg->palette, tilePixelColor);
-
-    return true;
 }
 
-bool Ppu::getSpriteCurrentPixel(
-    int x,
-    int y,
-    const ScreenConfig& screenConfig,
-    int priority,
-    uint32_t* c,
-    int* palette)
+int Ppu::run()
 {
-    if (!m_RenderObjInfo[y].m_ObjCount) {
-        return false;
-    }
-
-    // Check if Sprites are enabled
-    if (!screenConfig.m_ObjEnabled) {
-        return false;
-    }
-
-    // Check if background is inside window
-    bool pixelInWindow = false;
-
-    if (screenConfig.m_Window_ObjDisable) {
-        pixelInWindow = applyWindowLogic(
-            x,
-            m_Window1Config.m_ObjConfig,
-            m_Window2Config.m_ObjConfig,
-            m_WindowLogicObj);
-    }
-
-    if (pixelInWindow) {
-        return false;
-    }
-
-    // Search sprite
-    ObjProperty* prop = nullptr;
-
-    for (int i = 0; i < m_RenderObjInfo[y].m_ObjCount; i++) {
-        auto searchProp = m_RenderObjInfo[y].m_Obj[i];
-        assert(searchProp);
-
-        if (x < searchProp->m_X || searchProp->m_xEnd <= x) {
-            continue;
-        }
-
-        if (searchProp->m_Priority < priority) {
-            continue;
-        }
-
-        prop = searchProp;
-
-        // Sprite found, lets read the requested pixel
-        // Define some callbacks to get some data depending of the current PPU
-        // configuration
-        auto colorReadCb = getColorReadCb(kPpuObjBpp);
-
-        // Extract the pixel coordinates in the tile
-        int tileX = x - prop->m_X;
-
-        int tileY = y - prop->m_Y;
-        if (tileY < 0) {
-            tileY += 0x100;
-        }
-
-        // Use the flip status to point to the correct subtile
-        // Then compute the subtile coordinate to be able to compute
-        // the subtile location
-        int subtileX;
-        if (prop->m_HorizontalFlip) {
-            subtileX = prop->m_WidthPixel - tileX - 1;
-        } else {
-            subtileX = tileX;
-        }
-
-        int subtileY;
-        if (prop->m_VerticalFlip) {
-            subtileY = prop->m_HeightPixel - tileY - 1;
-        } else {
-            subtileY = tileY;
-        }
-
-        subtileX /= kPpuBaseTileWidth;
-        subtileY /= kPpuBaseTileHeight;
-
-        // Compute the final tile location
-        // The second row of tiles is located 0x10 tiles after
-        int tileBaseAddr = m_ObjBase + prop->m_TileIndex * kPpuObjTileSize;
-        if (prop->m_TileIndex >= 0x100) {
-            tileBaseAddr += m_ObjGapSize;
-        }
-
-        int tileAddr = tileBaseAddr + subtileX * kPpuObjTileSize +
-                       subtileY * 0x10 * kPpuObjTileSize;
-        tileAddr &= 0xFFFF;
-
-        const uint8_t* tileData = m_Vram + tileAddr;
-
-        // Update coordinates before draw to apply some tile modifiers
-        if (prop->m_VerticalFlip) {
-            tileY = (kPpuBaseTileHeight - 1) - (tileY % kPpuBaseTileHeight);
-        } else {
-            tileY %= kPpuBaseTileHeight;
-        }
-
-        // Pixel horizontal order is reversed in the tile. Bit 7 is the first
-        // pixel
-        if (!prop->m_HorizontalFlip) {
-            tileX = (kPpuBaseTileWidth - 1) - (tileX % kPpuBaseTileWidth);
-        } else {
-            tileX %= kPpuBaseTileWidth;
-        }
-
-        // Read tile color and get the color from the palette
-        int color = colorReadCb(tileData, kPpuObjTileSize, tileY, tileX);
-        if (color == 0) {
-            continue;
-        }
-
-        *c = getObjColorFromCgram(prop->m_Palette, color);
-
-        if (palette) {
-            *palette = prop->m_Palette;
-        }
+    m_Events = 0;
 
-        return true;
-    }
+    // Draw the dots left since the previous event, then handle this one
+    catchUp();
+    assert(m_RenderDotCycle == m_MasterClock);
+    runDot();
 
-    return false;
+    return getNextEventCycle() - m_MasterClock;
 }
 
-void Ppu::moveToNextPixel(RendererBgInfo* renderBg)
+void Ppu::catchUp()
 {
-    Background* bg = renderBg->background;
-
-    // Go to the next pixel
-    if (!renderBg->horizontalFlip) {
-        renderBg->tilePixelX =
-            (renderBg->tilePixelX + 1) % renderBg->tileWidthPixel;
-        renderBg->subtilePixelX++;
-
-        // There is only things to do when we've reached to end of the
-        // current subtile
-        if (renderBg->subtilePixelX == kPpuBaseTileWidth) {
-            renderBg->subtilePixelX = 0;
-            renderBg->subtileX++;
-
-            if (renderBg->subtileX < renderBg->tileWidth) {
-                updateSubtileData(bg, renderBg);
-            } else {
-                renderBg->tilemapX =
-                    (renderBg->tilemapX + 1) % renderBg->tilemapWidth;
-
-                updateTileData(bg, renderBg);
-                updateSubtileData(bg, renderBg);
-            }
+    // Dots between two events don't trigger anything, they are only drawn
+    // once something needs them: a register write or the next event
+    if (m_DrawConfig != DrawConfig::Draw && m_RenderX > 0 &&
+        m_RenderDotCycle < m_MasterClock) {
+        // Nothing to draw, move to the last dot of the line at most, which
+        // is left to runDot() to start the next line
+        int dots = (m_MasterClock - m_RenderDotCycle + kTimingPpuDot - 1) /
+            kTimingPpuDot;
+        dots = std::min(dots, kPpuScanWidth - 1 - m_RenderX);
+
+        m_RenderX += dots;
+        m_RenderDotCycle += dots * kTimingPpuDot;
+    }
+
+    while (m_RenderDotCycle < m_MasterClock) {
+        if (m_RenderX > 0 && m_RenderX < kPpuDisplayWidth &&
+            m_RenderY < kPpuDisplayHeight) {
+            // Visible dots are only drawn, render them all at once
+            int dots = (m_MasterClock - m_RenderDotCycle + kTimingPpuDot - 1) /
+                kTimingPpuDot;
+            dots = std::min(dots, kPpuDisplayWidth - m_RenderX);
+
+            renderDots(m_RenderX, m_RenderX + dots, m_RenderY);
+
+            m_RenderX += dots;
+            m_RenderDotCycle += dots * kTimingPpuDot;
+            continue;
         }
-    } else {
-        renderBg->tilePixelX =
-            (renderBg->tilePixelX + 1) % renderBg->tileWidthPixel;
-        renderBg->subtilePixelX--;
-
-        // There is only things to do when we've reached to end of the
-        // current subtile
-        if (renderBg->subtilePixelX < 0) {
-            renderBg->subtilePixelX = kPpuBaseTileWidth - 1;
-            renderBg->subtileX--;
-
-            if (renderBg->subtileX >= 0) {
-                updateSubtileData(bg, renderBg);
-            } else {
-                renderBg->tilemapX =
-                    (renderBg->tilemapX + 1) % renderBg->tilemapWidth;
 
-                updateTileData(bg, renderBg);
-                updateSubtileData(bg, renderBg);
-            }
-        }
+        runDot();
     }
 }
 
-void Ppu::setHVIRQ(int x, int y)
+int Ppu::getDotsToNextEvent() const
 {
-    if (m_HVIRQ.m_Config == HVIRQConfig::Disable) {
-        return;
+    // New line, H-Blank end, V-Blank start and V IRQ
+    if (m_RenderX == 0) {
+        return 0;
     }
 
-    switch (m_HVIRQ.m_Config) {
-    case HVIRQConfig::H:
-        if (x == m_HVIRQ.m_H) {
-            m_Events |= Event_HV_IRQ;
-        }
-
-        break;
-
-    case HVIRQConfig::V:
-        if (x == 0 && y == m_HVIRQ.m_V) {
-            m_Events |= Event_HV_IRQ;
-        }
+    int nextX;
 
-        break;
+    if (m_RenderX <= kPpuDisplayWidth) {
+        // H-Blank start
+        nextX = kPpuDisplayWidth;
+    } else if (m_RenderY == kPpuScanHeight - 1) {
+        // Screen end
+        nextX = kPpuScanWidth - 1;
+    } else {
+        nextX = kPpuScanWidth;
+    }
 
-    case HVIRQConfig::HV:
-        if (x == m_HVIRQ.m_H && y == m_HVIRQ.m_V) {
-            m_Events |= Event_HV_IRQ;
-        }
+    bool hIrq = m_HVIRQ.m_Config == HVIRQConfig::H ||
+        (m_HVIRQ.m_Config == HVIRQConfig::HV && m_RenderY == m_HVIRQ.m_V);
 
-        break;
-
-    default:
-        break;
+    if (hIrq && m_HVIRQ.m_H >= m_RenderX && m_HVIRQ.m_H < nextX) {
+        nextX = m_HVIRQ.m_H;
     }
+
+    return nextX - m_RenderX;
 }
 
-int Ppu::run()
+uint64_t Ppu::getNextEventCycle() const
 {
-    m_Events = 0;
+    return m_RenderDotCycle + getDotsToNextEvent() * kTimingPpuDot;
+}
 
+void Ppu::runDot()
+{
     if (m_RenderX == 0) {
         if (m_RenderY == 0) {
             // Start of screen
@@ -1637,7 +1772,7 @@ int Ppu::run()
             m_Events |= Event_ScanStarted;
             m_ScanStartedCb();
 
-            renderDot(m_RenderX, m_RenderY);
+            renderDots(m_RenderX, m_RenderX + 1, m_RenderY);
         } else if (m_RenderY == kPpuDisplayHeight) {
             // V-Blank
             m_Events |= Event_VBlankStart;
@@ -1645,7 +1780,7 @@ int Ppu::run()
         } else if (m_RenderY < kPpuDisplayHeight) {
             // New line
             initLineRender(m_RenderY);
-            renderDot(m_RenderX, m_RenderY);
+            renderDots(m_RenderX, m_RenderX + 1, m_RenderY);
 
             m_Events |= Event_HBlankEnd;
         }
@@ -1657,7 +1792,7 @@ int Ppu::run()
     } else if (m_RenderY >= kPpuDisplayHeight) {
         // V-Blank
     } else {
-        renderDot(m_RenderX, m_RenderY);
+        renderDots(m_RenderX, m_RenderX + 1, m_RenderY);
     }
 
     setHVIRQ(m_RenderX, m_RenderY);
@@ -1673,7 +1808,7 @@ int Ppu::run()
         }
     }
 
-    return kTimingPpuDot;
+    m_RenderDotCycle += kTimingPpuDot;
 }
 
 void Ppu::initScreenRender()
@@ -1683,7 +1818,6 @@ void Ppu::initScreenRender()
     }
 
     if (m_Bgmode == 7) {
-        initScreenRenderMode7();
         return;
     }
 
@@ -1707,13 +1841,6 @@ void Ppu::initScreenRender()
             renderBg->mosaic.size = 0;
         }
     }
-
-    // Prepare sprites
-    for (size_t i = 0; i < SIZEOF_ARRAY(m_RenderObjInfo); i++) {
-        m_RenderObjInfo[i].m_ObjCount = 0;
-    }
-
-    loadObjs();
 }
 
 void Ppu::initLineRender(int y)
@@ -1722,6 +1849,8 @@ void Ppu::initLineRender(int y)
         return;
     }
 
+    renderObjs(y);
+
     if (m_Bgmode == 7) {
         initLineRenderMode7(y);
         return;
@@ -1754,339 +1883,689 @@ void Ppu::initLineRender(int y)
         }
 
         // Compute some dimensions that will be ready for future use
-        getTileDimension(
-            bg->m_TileSize, &renderBg->tileWidth, &renderBg->tileHeight);
-        renderBg->tileWidthPixel = renderBg->tileWidth * kPpuBaseTileWidth;
-        renderBg->tileHeightPixel = renderBg->tileHeight * kPpuBaseTileHeight;
+        int tileWidth;
+        int tileHeight;
+        getTileDimension(bg->m_TileSize, &tileWidth, &tileHeight);
+        const int tileWidthPixel = tileWidth * kPpuBaseTileWidth;
+        const int tileHeightPixel = tileHeight * kPpuBaseTileHeight;
+
+        int tilemapWidth;
+        int tilemapHeight;
+        getTilemapDimension(bg->m_TilemapSize, &tilemapWidth, &tilemapHeight);
+        const int tilemapWidthPixel = tilemapWidth * tileWidthPixel;
+        const int tilemapHeightPixel = tilemapHeight * tileHeightPixel;
 
-        getTilemapDimension(
-            bg->m_TilemapSize,
-            &renderBg->tilemapWidth,
-            &renderBg->tilemapHeight);
-        renderBg->tilemapWidthPixel =
-            renderBg->tilemapWidth * renderBg->tileWidthPixel;
-        renderBg->tilemapHeightPixel =
-            renderBg->tilemapHeight * renderBg->tileHeightPixel;
-
-        renderBg->tileBpp = getTileBppFromMode(m_Bgmode, renderBg->bgIdx);
-
-        // Compute the tile size in bytes. Tiles are always 8x8.
-        // 16x16 tiles are just a composition of multiple 8x8 tiles.
-        renderBg->tileSize = renderBg->tileBpp * 8;
-
-        renderBg->tilemapMapper = getTilemapMapper(bg->m_TilemapSize);
+        // In mode 0, all bg have a dedicated 0x20 bytes palette
+        renderBg->cgramOffset = m_Bgmode == 0 ? renderBg->bgIdx * 0x20 : 0;
 
         // Compute background start coordinates in pixels at first
-        int bgX = bg->m_HOffset % renderBg->tilemapWidthPixel;
-        int bgY = (bg->m_VOffset + renderY) % renderBg->tilemapHeightPixel;
+        int bgX = bg->m_HOffset % tilemapWidthPixel;
+        int bgY = (bg->m_VOffset + renderY) % tilemapHeightPixel;
 
         // Get the tile coordinates inside the tilemap
-        renderBg->tilemapX = bgX / renderBg->tileWidthPixel;
-        renderBg->tilemapY = bgY / renderBg->tileHeightPixel;
+        renderBg->tilemapX = bgX / tileWidthPixel;
+        renderBg->tilemapY = bgY / tileHeightPixel;
 
         // Get the pixel coordinates inside the tile.
         // Doesn't take account of horizontal/vertical flip (info unknown at
         // this point)
-        renderBg->tilePixelX = bgX % renderBg->tileWidthPixel;
-        renderBg->tilePixelY = bgY % renderBg->tileHeightPixel;
+        renderBg->tilePixelX = bgX % tileWidthPixel;
+        renderBg->tilePixelY = bgY % tileHeightPixel;
+
+        // Select the renderer matching the BG configuration, then prepare
+        // work info
+        const BgRenderer renderer = getBgRenderer(
+            getTileBppFromMode(m_Bgmode, renderBg->bgIdx),
+            bg->m_TileSize,
+            bg->m_TilemapSize);
 
-        // Prepare work info
-        updateTileData(bg, renderBg);
-        updateSubtileData(bg, renderBg);
+        if (renderBg->mosaic.size > 1) {
+            renderBg->renderLine = renderer.m_RenderLineMosaic;
+        } else {
+            renderBg->renderLine = renderer.m_RenderLine;
+        }
+
+        (this->*renderer.m_FetchTile)(renderBg);
     }
 
     if (m_Bgmode == 0) {
-        m_RenderLayerPriority = s_LayerPriorityMode0;
+        setLayerPriority(s_LayerPriorityMode0);
     } else if (m_Bgmode == 1) {
-        m_RenderLayerPriority = m_Bg3Priority ? s_LayerPriorityMode1_BG3_On
-                                              : s_LayerPriorityMode1_BG3_Off;
+        setLayerPriority(
+            m_Bg3Priority ? s_LayerPriorityMode1_BG3_On
+                          : s_LayerPriorityMode1_BG3_Off);
     } else if (m_Bgmode == 3) {
-        m_RenderLayerPriority = s_LayerPriorityMode3;
+        setLayerPriority(s_LayerPriorityMode3);
     } else if (m_Bgmode == 7) {
-        m_RenderLayerPriority = s_LayerPriorityMode7;
+        setLayerPriority(s_LayerPriorityMode7);
     } else {
-        m_RenderLayerPriority = nullptr;
+        setLayerPriority(nullptr);
     }
 }
 
-void Ppu::renderDot(int x, int y)
+void Ppu::drawPixel(int x, int y, uint32_t rawColor)
 {
-    if (m_ForcedBlanking) {
-        m_RenderCb({0, 0, 0});
+    if (!m_Framebuffer.data) {
         return;
     }
 
-    if (m_DrawConfig != DrawConfig::Draw) {
+    uint8_t* pixel = m_Framebuffer.data + y * m_Framebuffer.pitch +
+                     x * getPixelSize(m_Framebuffer.format);
+
+    if (m_Framebuffer.format == PixelFormat::BGR555) {
+        // Brightness is left to the frame consumer
+        if (x == 0) {
+            m_LineBrightness[y] = m_Brightness;
+        }
+
+        *reinterpret_cast<uint16_t*>(pixel) = rawColor & 0x7FFF;
         return;
     }
 
-    // Mode not supported
-    if (!m_RenderLayerPriority) {
-        return;
+    // Compute final color
+    Color color = rawColorToRgb(rawColor);
+    applyBrightness(&color, m_Brightness);
+
+    switch (m_Framebuffer.format) {
+    case PixelFormat::XRGB8888:
+        *reinterpret_cast<uint32_t*>(pixel) =
+            0xFF000000 | (color.r << 16) | (color.g << 8) | color.b;
+        break;
+
+    case PixelFormat::RGB565:
+        *reinterpret_cast<uint16_t*>(pixel) =
+            ((color.r >> 3) << 11) | ((color.g >> 2) << 5) | (color.b >> 3);
+        break;
+
+    case PixelFormat::RGB24:
+        pixel[0] = color.r;
+        pixel[1] = color.g;
+        pixel[2] = color.b;
+        break;
+
+    default:
+        assert(false);
+        break;
     }
+}
 
-    // Check if current pixel is inside the color math window
-    const bool insideMathWindow = applyWindowLogic(
-        x,
-        m_Window1Config.m_MathConfig,
-        m_Window2Config.m_MathConfig,
-        m_WindowLogicMath);
+void Ppu::setLayerPriority(const LayerPriority* chart)
+{
+    m_RenderLayerPriority = chart;
 
-    // Check if color math is enabled and pixel is in the window
-    bool colorMathEnable;
+    memset(m_RenderBgZ, kZTransparent, sizeof(m_RenderBgZ));
+    memset(m_RenderObjZ, kZTransparent, sizeof(m_RenderObjZ));
 
-    if (m_ColorMathEnabled == ColorMathConfig::Never) {
-        colorMathEnable = false;
-    } else if (m_ColorMathEnabled == ColorMathConfig::Always) {
-        colorMathEnable = true;
-    } else if (m_ColorMathEnabled == ColorMathConfig::MathWin) {
-        colorMathEnable = insideMathWindow;
-    } else {
-        colorMathEnable = !insideMathWindow;
+    if (!chart) {
+        return;
     }
 
-    // Render MainScreen
-    BgColorProp colorProp;
-    uint32_t rawColor;
-    bool colorValid;
+    // Only the first entry of a layer priority can be drawn, later ones are
+    // always hidden by it
+    for (int z = 0; chart[z].m_Layer != Layer::none; z++) {
+        const auto& layer = chart[z];
+        uint8_t* layerZ;
 
-    if ((m_ForceMainScreenBlack == ColorMathConfig::Always) ||
-        (m_ForceMainScreenBlack == ColorMathConfig::MathWin &&
-         insideMathWindow) ||
-        (m_ForceMainScreenBlack == ColorMathConfig::NotMathWin &&
-         !insideMathWindow)) {
-        rawColor = 0;
-        colorValid = true;
-    } else {
-        if (m_Bgmode == 7) {
-            colorValid =
-                renderDotMode7(x, y, m_MainScreenConfig, &rawColor, &colorProp);
+        if (layer.m_Layer == Layer::background) {
+            layerZ = &m_RenderBgZ[layer.m_BgIdx][layer.m_Priority];
         } else {
-            colorValid = getScreenCurrentPixel(
-                x, y, m_MainScreenConfig, &rawColor, &colorProp);
+            layerZ = &m_RenderObjZ[layer.m_Priority];
+        }
+
+        if (*layerZ == kZTransparent) {
+            *layerZ = z;
         }
     }
+}
 
-    // Check if color math should be applied to this color
-    bool doMath;
+template <int kBpp, int kTileSize, int kTilemapSize, bool kMosaic>
+void Ppu::renderBgLine(RendererBgInfo* renderBg, int x, int xEnd, bool draw)
+{
+    LayerLine* layer = &m_RenderLayers[renderBg->bgIdx];
+    const uint8_t* z = m_RenderBgZ[renderBg->bgIdx];
+
+    if (draw) {
+        memset(
+            layer->m_Math + x,
+            m_ColorMathBackground[renderBg->bgIdx] ? 0xFF : 0,
+            xEnd - x);
+    }
 
-    if (colorMathEnable) {
-        if (!colorValid) {
-            doMath = m_ColorMathBackdrop;
-        } else if (colorProp.m_Layer == Ppu::Layer::background) {
-            doMath = m_ColorMathBackground[colorProp.m_BgIdx];
-        } else if (colorProp.m_Layer == Ppu::Layer::sprite) {
-            doMath = m_ColorMathObj && colorProp.m_Palette >= 4;
+    auto drawDot = [&](int dotX, int color) {
+        if (color == 0) {
+            layer->m_Z[dotX] = kZTransparent;
         } else {
-            doMath = false;
+            layer->m_Z[dotX] = z[renderBg->priority];
+            layer->m_Color[dotX] = m_Cgram[renderBg->colorBase + color];
         }
-    } else {
-        doMath = false;
+    };
+
+    if (kMosaic) {
+        for (; x < xEnd; x++) {
+            if (draw) {
+                drawDot(x, renderBg->tileRow[renderBg->subtilePixelX]);
+            }
+
+            // Redraw the same dot N times
+            const int nextBlockX =
+                renderBg->mosaic.startX + renderBg->mosaic.size;
+            if (x == nextBlockX) {
+                renderBg->mosaic.startX = x;
+
+                // Move to the next block start
+                for (int j = 0; j < renderBg->mosaic.size; j++) {
+                    moveBgDots<kBpp, kTileSize, kTilemapSize>(renderBg, 1);
+                }
+            }
+        }
+
+        return;
     }
 
-    // Apply math if enabled
-    if (doMath) {
-        // Force backdrop if color is invalid
-        if (!colorValid) {
-            rawColor = getMainBackdropColor();
+    // Draw the dots left in the current subtile row at once
+    while (x < xEnd) {
+        int dots;
+        if (!renderBg->horizontalFlip) {
+            dots = kPpuBaseTileWidth - renderBg->subtilePixelX;
+        } else {
+            dots = renderBg->subtilePixelX + 1;
         }
 
-        // Render SubScreen
-        uint32_t subscreenRawColor;
+        dots = std::min(dots, xEnd - x);
 
-        if (m_SubscreenEnabled) {
-            bool subscreenColorValid;
+        if (draw) {
+            const uint8_t* tileRow =
+                renderBg->tileRow + renderBg->subtilePixelX;
 
-            if (m_Bgmode == 7) {
-                subscreenColorValid = renderDotMode7(
-                    x, y, m_SubScreenConfig, &subscreenRawColor, nullptr);
+            if (!renderBg->horizontalFlip) {
+                for (int i = 0; i < dots; i++) {
+                    drawDot(x + i, tileRow[i]);
+                }
             } else {
-                subscreenColorValid = getScreenCurrentPixel(
-                    x, y, m_SubScreenConfig, &subscreenRawColor, nullptr);
+                for (int i = 0; i < dots; i++) {
+                    drawDot(x + i, tileRow[-i]);
+                }
             }
+        }
 
-            if (!subscreenColorValid) {
-                subscreenRawColor = m_SubscreenBackdrop;
-            }
-        } else {
-            subscreenRawColor = m_SubscreenBackdrop;
+        moveBgDots<kBpp, kTileSize, kTilemapSize>(renderBg, dots);
+        x += dots;
+    }
+}
+
+void Ppu::renderObjLine(int x, int xEnd)
+{
+    LayerLine* layer = &m_RenderLayers[kLayerObj];
+
+    // Palettes 4-7 take part in color math
+    constexpr int kObjMathColor =
+        kPpuObjPaletteOffset + 4 * (1 << kPpuObjBpp);
+
+    for (; x < xEnd; x++) {
+        const uint8_t cgramIdx = m_RenderObjLine.m_Color[x];
+
+        if (!cgramIdx) {
+            layer->m_Z[x] = kZTransparent;
+            continue;
         }
 
-        struct SplittedRawColor {
-            uint32_t r;
-            uint32_t g;
-            uint32_t b;
+        layer->m_Color[x] = m_Cgram[cgramIdx];
+        layer->m_Z[x] = m_RenderObjZ[m_RenderObjLine.m_Priority[x]];
+        layer->m_Math[x] =
+            m_ColorMathObj && cgramIdx >= kObjMathColor ? 0xFF : 0;
+    }
+}
 
-            static SplittedRawColor fromU32(uint32_t c)
-            {
-                return {
-                    c & 0b11111,
-                    (c >> 5) & 0b11111,
-                    (c >> 10) & 0b11111,
-                };
-            }
+void Ppu::resolveScreen(
+    const ScreenConfig& screenConfig,
+    int bgCount,
+    int x,
+    int xEnd,
+    uint16_t backdrop,
+    bool backdropMath,
+    uint16_t* color,
+    uint8_t* math)
+{
+    // Layers enabled on this screen
+    const LayerLine* layers[kLayerCount];
+    bool windows[kLayerCount];
+    int layerCount = 0;
 
-            uint32_t toU32() const
-            {
-                constexpr uint32_t kMaxFrag = 0b11111;
-                uint32_t c;
+    for (int i = 0; i < bgCount; i++) {
+        if (screenConfig.m_BgEnabled[i]) {
+            layers[layerCount] = &m_RenderLayers[i];
+            windows[layerCount] = screenConfig.m_Window_BgDisable[i];
+            layerCount++;
+        }
+    }
+
+    if (screenConfig.m_ObjEnabled) {
+        layers[layerCount] = &m_RenderLayers[kLayerObj];
+        windows[layerCount] = screenConfig.m_Window_ObjDisable;
+        layerCount++;
+    }
+
+    // Keep the pixel of the lowest Z, masked and transparent pixels are
+    // never drawn as their Z is kZTransparent
+#if defined(__SSE2__)
+    assert(x % kRenderBlockSize == 0 && xEnd % kRenderBlockSize == 0);
 
-                c = std::min(r, kMaxFrag);
-                c |= std::min(g, kMaxFrag) << 5;
-                c |= std::min(b, kMaxFrag) << 10;
+    const __m128i ones = _mm_set1_epi8(-1);
 
-                return c;
+    for (; x < xEnd; x += kRenderBlockSize) {
+        __m128i bestZ = _mm_set1_epi8(static_cast<char>(kZTransparent));
+        __m128i bestMath = _mm_set1_epi8(backdropMath ? -1 : 0);
+        __m128i bestColorLo = _mm_set1_epi16(backdrop);
+        __m128i bestColorHi = bestColorLo;
+
+        for (int i = 0; i < layerCount; i++) {
+            const LayerLine* layer = layers[i];
+
+            __m128i z = loadBlock(layer->m_Z + x);
+            if (windows[i]) {
+                z = _mm_or_si128(z, loadBlock(layer->m_Window + x));
             }
-        };
 
-        SplittedRawColor splittedMainColor =
-            SplittedRawColor::fromU32(rawColor);
-        SplittedRawColor splittedSubColor =
-            SplittedRawColor::fromU32(subscreenRawColor);
-
-        // Add/Sub
-        if (m_ColorMathOperation & (1 << 1)) {
-            auto subCb = [](uint32_t a, uint32_t b) -> uint32_t {
-                if (b > a) {
-                    return 0;
-                } else {
-                    return a - b;
-                }
-            };
-
-            splittedMainColor.r =
-                subCb(splittedMainColor.r, splittedSubColor.r);
-            splittedMainColor.g =
-                subCb(splittedMainColor.g, splittedSubColor.g);
-            splittedMainColor.b =
-                subCb(splittedMainColor.b, splittedSubColor.b);
-        } else {
-            splittedMainColor.r += splittedSubColor.r;
-            splittedMainColor.g += splittedSubColor.g;
-            splittedMainColor.b += splittedSubColor.b;
+            // z < bestZ
+            __m128i front =
+                _mm_xor_si128(_mm_cmpeq_epi8(_mm_max_epu8(z, bestZ), z), ones);
+
+            bestZ = _mm_min_epu8(z, bestZ);
+            bestMath =
+                selectBlock(front, loadBlock(layer->m_Math + x), bestMath);
+            bestColorLo = selectBlock(
+                _mm_unpacklo_epi8(front, front),
+                loadBlock(layer->m_Color + x),
+                bestColorLo);
+            bestColorHi = selectBlock(
+                _mm_unpackhi_epi8(front, front),
+                loadBlock(layer->m_Color + x + 8),
+                bestColorHi);
+        }
+
+        storeBlock(color + x, bestColorLo);
+        storeBlock(color + x + 8, bestColorHi);
+        if (math) {
+            storeBlock(math + x, bestMath);
+        }
+    }
+#else
+    for (; x < xEnd; x++) {
+        uint8_t bestZ = kZTransparent;
+        uint8_t bestMath = backdropMath ? 0xFF : 0;
+        uint16_t bestColor = backdrop;
+
+        for (int i = 0; i < layerCount; i++) {
+            const LayerLine* layer = layers[i];
+
+            uint8_t z = layer->m_Z[x];
+            if (windows[i]) {
+                z |= layer->m_Window[x];
+            }
+
+            if (z < bestZ) {
+                bestZ = z;
+                bestMath = layer->m_Math[x];
+                bestColor = layer->m_Color[x];
+            }
         }
 
-        // Divide
-        if (m_ColorMathOperation & 1) {
-            splittedMainColor.r /= 2;
-            splittedMainColor.g /= 2;
-            splittedMainColor.b /= 2;
+        color[x] = bestColor;
+        if (math) {
+            math[x] = bestMath;
         }
+    }
+#endif
+}
 
-        // Repack into raw color + saturate
-        rawColor = splittedMainColor.toU32();
-    } else if (!colorValid) {
-        rawColor = getMainBackdropColor();
+void Ppu::renderDots(int x, int xEnd, int y)
+{
+    if (m_DrawConfig != DrawConfig::Draw) {
+        return;
     }
 
-    // Compute final color
-    Color color = rawColorToRgb(rawColor);
-    applyBrightness(&color, m_Brightness);
+    if (m_ForcedBlanking) {
+        for (int i = x; i < xEnd; i++) {
+            drawPixel(i, y, 0);
+        }
 
-    m_RenderCb(color);
+        return;
+    }
+
+    // Mode not supported
+    if (!m_RenderLayerPriority) {
+        return;
+    }
+
+    // Subscreen is only read by color math, its configuration is ignored
+    // otherwise
+    const bool subscreen =
+        m_SubscreenEnabled && m_ColorMathEnabled != ColorMathConfig::Never;
+
+    auto isSetOnScreens = [&](bool mainEnabled, bool subEnabled) {
+        return mainEnabled || (subscreen && subEnabled);
+    };
+
+    // Render each layer
+    int bgCount;
+
+    if (m_Bgmode == 7) {
+        bgCount = 1;
+
+        if (isSetOnScreens(
+                m_MainScreenConfig.m_BgEnabled[0],
+                m_SubScreenConfig.m_BgEnabled[0])) {
+            renderBgLineMode7(x, xEnd);
+        }
+    } else {
+        bgCount = getBackgroundCountFromMode(m_Bgmode);
+
+        for (int i = 0; i < bgCount; i++) {
+            bool draw = isSetOnScreens(
+                m_MainScreenConfig.m_BgEnabled[i],
+                m_SubScreenConfig.m_BgEnabled[i]);
 
-    if (m_Bgmode != 7) {
-        // Move to next pixel
-        const size_t bgCount = getBackgroundCountFromMode(m_Bgmode);
-        for (size_t i = 0; i < bgCount; i++) {
             RendererBgInfo* renderBg = &m_RenderBgInfo[i];
+            (this->*renderBg->renderLine)(renderBg, x, xEnd, draw);
+        }
+    }
+
+    if (isSetOnScreens(
+            m_MainScreenConfig.m_ObjEnabled, m_SubScreenConfig.m_ObjEnabled)) {
+        renderObjLine(x, xEnd);
+    }
+
+    // Window masks only change with window registers
+    if (m_WindowMasksDirty) {
+        updateWindowMasks();
+    }
+
+    // Screens are resolved by whole blocks, extra dots are dropped
+    const int blockX = x / kRenderBlockSize * kRenderBlockSize;
+    const int blockXEnd =
+        (xEnd + kRenderBlockSize - 1) / kRenderBlockSize * kRenderBlockSize;
+
+    uint16_t mainColor[kPpuDisplayWidth];
+    uint8_t mainMath[kPpuDisplayWidth];
+    uint16_t subColor[kPpuDisplayWidth];
+    uint16_t color[kPpuDisplayWidth];
+
+    resolveScreen(
+        m_MainScreenConfig,
+        bgCount,
+        blockX,
+        blockXEnd,
+        getMainBackdropColor(),
+        m_ColorMathBackdrop,
+        mainColor,
+        mainMath);
+
+    if (subscreen) {
+        resolveScreen(
+            m_SubScreenConfig,
+            bgCount,
+            blockX,
+            blockXEnd,
+            m_SubscreenBackdrop,
+            false,
+            subColor,
+            nullptr);
+    } else {
+        std::fill(
+            subColor + blockX, subColor + blockXEnd, m_SubscreenBackdrop);
+    }
 
-            // If mosaic is enabled, redraw the same line N times
-            if (renderBg->mosaic.size > 1) {
-                const int nextBlockX =
-                    renderBg->mosaic.startX + renderBg->mosaic.size;
-                if (x == nextBlockX) {
-                    renderBg->mosaic.startX = x;
-
-                    // Move to the next block start
-                    for (int j = 0; j < renderBg->mosaic.size; j++) {
-                        moveToNextPixel(renderBg);
-                    }
-                }
+    // Math and force black configurations, as masks for pixels inside and
+    // outside of the color math window
+    auto getMathWindowMask = [](ColorMathConfig config, bool inside) {
+        if (config == ColorMathConfig::Never) {
+            return 0;
+        } else if (config == ColorMathConfig::Always) {
+            return 0xFF;
+        } else {
+            return (config == ColorMathConfig::MathWin) == inside ? 0xFF : 0;
+        }
+    };
+
+    const uint8_t mathInside = getMathWindowMask(m_ColorMathEnabled, true);
+    const uint8_t mathOutside = getMathWindowMask(m_ColorMathEnabled, false);
+    const uint8_t blackInside = getMathWindowMask(m_ForceMainScreenBlack, true);
+    const uint8_t blackOutside =
+        getMathWindowMask(m_ForceMainScreenBlack, false);
+
+    const bool subtract = m_ColorMathOperation & (1 << 1);
+    const bool half = m_ColorMathOperation & 1;
+
+#if defined(__SSE2__)
+    const __m128i vMathInside = _mm_set1_epi8(mathInside);
+    const __m128i vMathOutside = _mm_set1_epi8(mathOutside);
+    const __m128i vBlackInside = _mm_set1_epi8(blackInside);
+    const __m128i vBlackOutside = _mm_set1_epi8(blackOutside);
+
+    for (int i = blockX; i < blockXEnd; i += kRenderBlockSize) {
+        const __m128i window = loadBlock(m_RenderMathWindow + i);
+        const __m128i black = selectBlock(window, vBlackInside, vBlackOutside);
+        const __m128i doMath = _mm_and_si128(
+            selectBlock(window, vMathInside, vMathOutside),
+            loadBlock(mainMath + i));
+
+        for (int half8 = 0; half8 < 2; half8++) {
+            const int j = i + half8 * 8;
+
+            __m128i black16;
+            __m128i doMath16;
+            if (half8 == 0) {
+                black16 = _mm_unpacklo_epi8(black, black);
+                doMath16 = _mm_unpacklo_epi8(doMath, doMath);
             } else {
-                moveToNextPixel(renderBg);
+                black16 = _mm_unpackhi_epi8(black, black);
+                doMath16 = _mm_unpackhi_epi8(doMath, doMath);
             }
+
+            __m128i c = _mm_andnot_si128(black16, loadBlock(mainColor + j));
+            __m128i mathColor =
+                applyColorMath(c, loadBlock(subColor + j), subtract, half);
+
+            storeBlock(color + j, selectBlock(doMath16, mathColor, c));
         }
     }
+#else
+    for (int i = x; i < xEnd; i++) {
+        const bool window = m_RenderMathWindow[i];
+        const bool black = window ? blackInside : blackOutside;
+        const bool doMath =
+            (window ? mathInside : mathOutside) && mainMath[i];
+
+        uint16_t c = black ? 0 : mainColor[i];
+        if (doMath) {
+            c = applyColorMath(c, subColor[i], subtract, half);
+        }
+
+        color[i] = c;
+    }
+#endif
+
+    for (int i = x; i < xEnd; i++) {
+        drawPixel(i, y, color[i]);
+    }
+}
+
+void Ppu::decodeObj(int objIdx)
+{
+    ObjProperty& prop = m_Objs[objIdx];
+
+    // Attributes are 4 bytes long
+    const uint8_t* objBase = m_Oam + objIdx * 4;
+
+    // Other parts of the attributes are located after the first 512 bytes.
+    // Each byte has 2 bits for 4 sprites. Bytes are ordered like this:
+    // | 3 2 1 0 | 7 6 5 4 | 11 10 9 8 | ... |
+    uint8_t extra = m_Oam[512 + objIdx / 4];
+    extra >>= 2 * (objIdx % 4);
+    extra &= 0b11;
+
+    prop.m_X = objBase[0];
+
+    // Decode sprite coordinates
+    if (extra & 1) {
+        // The extra byte is a sign number
+        // Craft a negative int16 and decode it
+        prop.m_X |= 0xFF00;
+    }
+
+    prop.m_Y = objBase[1];
+
+    // Decode sprite size
+    prop.m_Size = (extra >> 1) & 1;
+
+    // Decode attributes (third byte)
+    prop.m_VerticalFlip = (objBase[3] >> 7) & 1;
+    prop.m_HorizontalFlip = (objBase[3] >> 6) & 1;
+    prop.m_Priority = (objBase[3] >> 4) & 0b11;
+    prop.m_Palette = (objBase[3] >> 1) & 0b111;
+
+    // Decode tile index (upper bit is within attribute byte)
+    prop.m_TileIndex = ((objBase[3] & 1) << 8) | objBase[2];
+
+    // Compute other data
+    getSpriteSize(m_ObjSize, prop.m_Size, &prop.m_Width, &prop.m_Height);
+    prop.m_HeightPixel = prop.m_Height * kPpuBaseTileHeight;
+    prop.m_WidthPixel = prop.m_Width * kPpuBaseTileWidth;
+
+    prop.m_xEnd = prop.m_X + prop.m_WidthPixel;
+
+    prop.m_Dirty = false;
 }
 
-void Ppu::loadObjs()
+void Ppu::renderObjs(int y)
 {
+    memset(m_RenderObjLine.m_Color, 0, sizeof(m_RenderObjLine.m_Color));
+
+    // Range: keep the first sprites of the line, starting from the
+    // priority rotation one
+    const ObjProperty* lineObjs[kPpuObjLineCount];
+    int lineObjCount = 0;
+
     int firstObj = m_OamForcedPriority ? m_OamHighestPriorityObj : 0;
-    int objIdx = firstObj;
 
-    do {
+    for (int i = 0; i < kObjCount; i++) {
+        int objIdx = (firstObj + i) % kObjCount;
         ObjProperty& prop = m_Objs[objIdx];
 
-        // Attributes are 4 bytes long
-        const uint8_t* objBase = m_Oam + objIdx * 4;
+        if (prop.m_Dirty) {
+            decodeObj(objIdx);
+        }
+
+        if (((y - prop.m_Y) & 0xFF) >= prop.m_HeightPixel) {
+            continue;
+        }
+
+        // Like on hardware, X = -256 is in range even if never visible
+        if (prop.m_xEnd <= 0 && prop.m_X != -256) {
+            continue;
+        }
+
+        if (lineObjCount == kPpuObjLineCount) {
+            break;
+        }
+
+        lineObjs[lineObjCount] = &prop;
+        lineObjCount++;
+    }
 
-        // Other parts of the attributes are located after the first 512 bytes.
-        // Each byte has 2 bits for 4 sprites. Bytes are ordered like this:
-        // | 3 2 1 0 | 7 6 5 4 | 11 10 9 8 | ... |
-        uint8_t extra = m_Oam[512 + objIdx / 4];
-        extra >>= 2 * (objIdx % 4);
-        extra &= 0b11;
+    // Time: tiles of the last sprites are fetched first. Tiles left of the
+    // screen are skipped, except for X = -256.
+    int lineObjXEnd[kPpuObjLineCount];
+    int tileCount = 0;
 
-        prop.m_X = objBase[0];
+    for (int i = lineObjCount - 1; i >= 0; i--) {
+        const ObjProperty* prop = lineObjs[i];
 
-        // Decode sprite coordinates
-        if (extra & 1) {
-            // The extra byte is a sign number
-            // Craft a negative int16 and decode it
-            prop.m_X |= 0xFF00;
+        int firstTile = 0;
+        if (prop->m_X < 0 && prop->m_X != -256) {
+            firstTile = -prop->m_X / kPpuBaseTileWidth;
         }
 
-        prop.m_Y = objBase[1];
+        int lastTile = std::min(
+            prop->m_Width,
+            (kPpuDisplayWidth - prop->m_X + kPpuBaseTileWidth - 1) /
+                kPpuBaseTileWidth);
 
-        // Decode sprite size
-        prop.m_Size = (extra >> 1) & 1;
+        int tiles = std::max(lastTile - firstTile, 0);
+        tiles = std::min(tiles, kPpuObjLineTileCount - tileCount);
+        tileCount += tiles;
 
-        // Decode attributes (third byte)
-        prop.m_VerticalFlip = (objBase[3] >> 7) & 1;
-        prop.m_HorizontalFlip = (objBase[3] >> 6) & 1;
-        prop.m_Priority = (objBase[3] >> 4) & 0b11;
-        prop.m_Palette = (objBase[3] >> 1) & 0b111;
+        lineObjXEnd[i] = prop->m_X + (firstTile + tiles) * kPpuBaseTileWidth;
+    }
 
-        // Decode tile index (upper bit is within attribute byte)
-        prop.m_TileIndex = ((objBase[3] & 1) << 8) | objBase[2];
+    // Rasterise, a pixel shows the first sprite of the highest priority
+    for (int i = 0; i < lineObjCount; i++) {
+        const ObjProperty* prop = lineObjs[i];
 
-        // Compute other data
-        getSpriteSize(m_ObjSize, prop.m_Size, &prop.m_Width, &prop.m_Height);
-        prop.m_HeightPixel = prop.m_Height * kPpuBaseTileHeight;
-        prop.m_WidthPixel = prop.m_Width * kPpuBaseTileWidth;
+        const int objX = std::max(0, static_cast<int>(prop->m_X));
+        const int objXEnd = std::min(kPpuDisplayWidth, lineObjXEnd[i]);
+        if (objX >= objXEnd) {
+            continue;
+        }
 
-        prop.m_xEnd = prop.m_X + prop.m_WidthPixel;
+        // Extract the line coordinates in the sprite
+        int tileY = (y - prop->m_Y) & 0xFF;
 
-        if (prop.m_X + prop.m_WidthPixel < 0) {
-            prop.m_OnScreen = false;
-        } else if (prop.m_X > kPpuDisplayWidth) {
-            prop.m_OnScreen = false;
-        } else if (
-            prop.m_Y > kPpuDisplayHeight &&
-            prop.m_Y + prop.m_HeightPixel < 0x100) {
-            prop.m_OnScreen = false;
+        int subtileY;
+        int row;
+        if (prop->m_VerticalFlip) {
+            subtileY = prop->m_HeightPixel - tileY - 1;
+            row = (kPpuBaseTileHeight - 1) - (tileY % kPpuBaseTileHeight);
         } else {
-            prop.m_OnScreen = true;
+            subtileY = tileY;
+            row = tileY % kPpuBaseTileHeight;
         }
 
-        if (prop.m_OnScreen) {
-            // Save the lines where the sprite could be displayed
-            for (int16_t i = 0; i < prop.m_HeightPixel; i++) {
-                int16_t y = (i + prop.m_Y) % 0x100;
-                if (y >= kPpuDisplayHeight) {
-                    continue;
-                }
+        subtileY /= kPpuBaseTileHeight;
+
+        // The second row of tiles is located 0x10 tiles after
+        int tileBaseAddr = m_ObjBase + prop->m_TileIndex * kPpuObjTileSize;
+        if (prop->m_TileIndex >= 0x100) {
+            tileBaseAddr += m_ObjGapSize;
+        }
 
-                assert(static_cast<size_t>(i) < SIZEOF_ARRAY(m_RenderObjInfo));
+        tileBaseAddr += subtileY * 0x10 * kPpuObjTileSize;
 
-                m_RenderObjInfo[y].m_Obj[m_RenderObjInfo[y].m_ObjCount] = &prop;
-                m_RenderObjInfo[y].m_ObjCount++;
+        const uint8_t paletteIdx =
+            kPpuObjPaletteOffset + prop->m_Palette * (1 << kPpuObjBpp);
+
+        for (int x = objX; x < objXEnd; x++) {
+            if (m_RenderObjLine.m_Color[x] &&
+                m_RenderObjLine.m_Priority[x] >= prop->m_Priority) {
+                continue;
             }
-        }
 
-        objIdx = (objIdx + 1) % kObjCount;
-    } while (objIdx != firstObj);
+            int tileX = x - prop->m_X;
+
+            int subtileX;
+            if (prop->m_HorizontalFlip) {
+                subtileX = prop->m_WidthPixel - tileX - 1;
+                tileX = (kPpuBaseTileWidth - 1) - (tileX % kPpuBaseTileWidth);
+            } else {
+                subtileX = tileX;
+                tileX %= kPpuBaseTileWidth;
+            }
+
+            subtileX /= kPpuBaseTileWidth;
+
+            int tileAddr = tileBaseAddr + subtileX * kPpuObjTileSize;
+            tileAddr &= 0xFFFF;
+
+            const uint8_t* tileRow = getTileRow(kPpuObjBpp, tileAddr, row);
+            int color = tileRow[tileX];
+            if (color == 0) {
+                continue;
+            }
+
+            m_RenderObjLine.m_Color[x] = paletteIdx + color;
+            m_RenderObjLine.m_Priority[x] = prop->m_Priority;
+        }
+    }
 }
 
 void Ppu::printObjsCoordinates()
@@ -2364,140 +2843,187 @@ bool Ppu::getPixelFromObj(int screenX, int screenY, Color* c, int* outPriority)
     return true;
 }
 
-void Ppu::dumpToFile(FILE* f)
-{
-    SchedulerTask::dumpToFile(f);
-
-    fwrite(&m_ForcedBlanking, sizeof(m_ForcedBlanking), 1, f);
-    fwrite(&m_Brightness, sizeof(m_Brightness), 1, f);
-    fwrite(&m_HPos, sizeof(&m_HPos), 1, f);
-    fwrite(&m_HPosReadFlip, sizeof(&m_HPosReadFlip), 1, f);
-    fwrite(&m_VPos, sizeof(&m_VPos), 1, f);
-    fwrite(&m_VPosReadFlip, sizeof(&m_VPosReadFlip), 1, f);
-    fwrite(&m_VramIncrementHigh, sizeof(m_VramIncrementHigh), 1, f);
-    fwrite(&m_VramAddressTranslate, sizeof(m_VramAddressTranslate), 1, f);
-    fwrite(&m_VramIncrementStep, sizeof(m_VramIncrementStep), 1, f);
-    fwrite(m_Vram, sizeof(m_Vram), 1, f);
-    fwrite(&m_VramAddress, sizeof(m_VramAddress), 1, f);
-    fwrite(&m_VramPrefetch, sizeof(m_VramPrefetch), 1, f);
-    fwrite(&m_Cgram, sizeof(m_Cgram), 1, f);
-    fwrite(&m_CgdataAddress, sizeof(m_CgdataAddress), 1, f);
-    fwrite(&m_CgramLsbSet, sizeof(m_CgramLsbSet), 1, f);
-    fwrite(&m_CgramLsb, sizeof(m_CgramLsb), 1, f);
-    fwrite(&m_Oam, sizeof(m_Oam), 1, f);
-    fwrite(&m_OamAddress, sizeof(m_OamAddress), 1, f);
-    fwrite(&m_OamAddressReload, sizeof(m_OamAddressReload), 1, f);
-    fwrite(&m_OamHighestPriorityObj, sizeof(m_OamHighestPriorityObj), 1, f);
-    fwrite(&m_OamForcedPriority, sizeof(m_OamForcedPriority), 1, f);
-    fwrite(&m_OamFlip, sizeof(m_OamFlip), 1, f);
-    fwrite(&m_OamWriteRegister, sizeof(m_OamWriteRegister), 1, f);
-    fwrite(&m_ObjSize, sizeof(m_ObjSize), 1, f);
-    fwrite(&m_ObjGapSize, sizeof(m_ObjGapSize), 1, f);
-    fwrite(&m_ObjBase, sizeof(m_ObjBase), 1, f);
-    fwrite(&m_Backgrounds, sizeof(m_Backgrounds), 1, f);
-    fwrite(&m_OldBgByte, sizeof(m_OldBgByte), 1, f);
-    fwrite(&m_Bgmode, sizeof(m_Bgmode), 1, f);
-    fwrite(&m_Bg3Priority, sizeof(m_Bg3Priority), 1, f);
-    fwrite(&m_SubscreenBackdrop, sizeof(m_SubscreenBackdrop), 1, f);
-    fwrite(&m_Window1Config, sizeof(m_Window1Config), 1, f);
-    fwrite(&m_Window2Config, sizeof(m_Window2Config), 1, f);
-    fwrite(&m_WindowLogicBackground, sizeof(m_WindowLogicBackground), 1, f);
-    fwrite(&m_WindowLogicObj, sizeof(m_WindowLogicObj), 1, f);
-    fwrite(&m_WindowLogicMath, sizeof(m_WindowLogicMath), 1, f);
-    fwrite(&m_MainScreenConfig, sizeof(m_MainScreenConfig), 1, f);
-    fwrite(&m_SubScreenConfig, sizeof(m_SubScreenConfig), 1, f);
-    fwrite(&m_ForceMainScreenBlack, sizeof(m_ForceMainScreenBlack), 1, f);
-    fwrite(&m_ColorMathEnabled, sizeof(m_ColorMathEnabled), 1, f);
-    fwrite(&m_SubscreenEnabled, sizeof(m_SubscreenEnabled), 1, f);
-    fwrite(&m_ColorMathOperation, sizeof(m_ColorMathOperation), 1, f);
-    fwrite(&m_ColorMathBackground, sizeof(m_ColorMathBackground), 1, f);
-    fwrite(&m_ColorMathObj, sizeof(m_ColorMathObj), 1, f);
-    fwrite(&m_ColorMathBackdrop, sizeof(m_ColorMathBackdrop), 1, f);
-    fwrite(&m_Mosaic, sizeof(m_Mosaic), 1, f);
-    fwrite(&m_M7ScreenOver, sizeof(m_M7ScreenOver), 1, f);
-    fwrite(&m_M7HFlip, sizeof(m_M7HFlip), 1, f);
-    fwrite(&m_M7VFlip, sizeof(m_M7VFlip), 1, f);
-    fwrite(&m_M7Old, sizeof(m_M7Old), 1, f);
-    fwrite(&m_M7HOFS, sizeof(m_M7HOFS), 1, f);
-    fwrite(&m_M7VOFS, sizeof(m_M7VOFS), 1, f);
-    fwrite(&m_M7A, sizeof(m_M7A), 1, f);
-    fwrite(&m_M7B, sizeof(m_M7B), 1, f);
-    fwrite(&m_M7C, sizeof(m_M7C), 1, f);
-    fwrite(&m_M7D, sizeof(m_M7D), 1, f);
-    fwrite(&m_M7X, sizeof(m_M7X), 1, f);
-    fwrite(&m_M7Y, sizeof(m_M7Y), 1, f);
-    fwrite(&m_MPY, sizeof(m_MPY), 1, f);
-    fwrite(&m_Ppu1OpenBus, sizeof(m_Ppu1OpenBus), 1, f);
-    fwrite(&m_Ppu2OpenBus, sizeof(m_Ppu2OpenBus), 1, f);
-    fwrite(&m_HVIRQ, sizeof(m_HVIRQ), 1, f);
-}
-
-void Ppu::loadFromFile(FILE* f)
-{
-    SchedulerTask::loadFromFile(f);
-
-    fread(&m_ForcedBlanking, sizeof(m_ForcedBlanking), 1, f);
-    fread(&m_Brightness, sizeof(m_Brightness), 1, f);
-    fread(&m_HPos, sizeof(&m_HPos), 1, f);
-    fread(&m_HPosReadFlip, sizeof(&m_HPosReadFlip), 1, f);
-    fread(&m_VPos, sizeof(&m_VPos), 1, f);
-    fread(&m_VPosReadFlip, sizeof(&m_VPosReadFlip), 1, f);
-    fread(&m_VramIncrementHigh, sizeof(m_VramIncrementHigh), 1, f);
-    fread(&m_VramAddressTranslate, sizeof(m_VramAddressTranslate), 1, f);
-    fread(&m_VramIncrementStep, sizeof(m_VramIncrementStep), 1, f);
-    fread(m_Vram, sizeof(m_Vram), 1, f);
-    fread(&m_VramAddress, sizeof(m_VramAddress), 1, f);
-    fread(&m_VramPrefetch, sizeof(m_VramPrefetch), 1, f);
-    fread(&m_Cgram, sizeof(m_Cgram), 1, f);
-    fread(&m_CgdataAddress, sizeof(m_CgdataAddress), 1, f);
-    fread(&m_CgramLsbSet, sizeof(m_CgramLsbSet), 1, f);
-    fread(&m_CgramLsb, sizeof(m_CgramLsb), 1, f);
-    fread(&m_Oam, sizeof(m_Oam), 1, f);
-    fread(&m_OamAddress, sizeof(m_OamAddress), 1, f);
-    fread(&m_OamAddressReload, sizeof(m_OamAddressReload), 1, f);
-    fread(&m_OamHighestPriorityObj, sizeof(m_OamHighestPriorityObj), 1, f);
-    fread(&m_OamForcedPriority, sizeof(m_OamForcedPriority), 1, f);
-    fread(&m_OamFlip, sizeof(m_OamFlip), 1, f);
-    fread(&m_OamWriteRegister, sizeof(m_OamWriteRegister), 1, f);
-    fread(&m_ObjSize, sizeof(m_ObjSize), 1, f);
-    fread(&m_ObjGapSize, sizeof(m_ObjGapSize), 1, f);
-    fread(&m_ObjBase, sizeof(m_ObjBase), 1, f);
-    fread(&m_Backgrounds, sizeof(m_Backgrounds), 1, f);
-    fread(&m_OldBgByte, sizeof(m_OldBgByte), 1, f);
-    fread(&m_Bgmode, sizeof(m_Bgmode), 1, f);
-    fread(&m_Bg3Priority, sizeof(m_Bg3Priority), 1, f);
-    fread(&m_SubscreenBackdrop, sizeof(m_SubscreenBackdrop), 1, f);
-    fread(&m_Window1Config, sizeof(m_Window1Config), 1, f);
-    fread(&m_Window2Config, sizeof(m_Window2Config), 1, f);
-    fread(&m_WindowLogicBackground, sizeof(m_WindowLogicBackground), 1, f);
-    fread(&m_WindowLogicObj, sizeof(m_WindowLogicObj), 1, f);
-    fread(&m_WindowLogicMath, sizeof(m_WindowLogicMath), 1, f);
-    fread(&m_MainScreenConfig, sizeof(m_MainScreenConfig), 1, f);
-    fread(&m_SubScreenConfig, sizeof(m_SubScreenConfig), 1, f);
-    fread(&m_ForceMainScreenBlack, sizeof(m_ForceMainScreenBlack), 1, f);
-    fread(&m_ColorMathEnabled, sizeof(m_ColorMathEnabled), 1, f);
-    fread(&m_SubscreenEnabled, sizeof(m_SubscreenEnabled), 1, f);
-    fread(&m_ColorMathOperation, sizeof(m_ColorMathOperation), 1, f);
-    fread(&m_ColorMathBackground, sizeof(m_ColorMathBackground), 1, f);
-    fread(&m_ColorMathObj, sizeof(m_ColorMathObj), 1, f);
-    fread(&m_ColorMathBackdrop, sizeof(m_ColorMathBackdrop), 1, f);
-    fread(&m_Mosaic, sizeof(m_Mosaic), 1, f);
-    fread(&m_M7ScreenOver, sizeof(m_M7ScreenOver), 1, f);
-    fread(&m_M7HFlip, sizeof(m_M7HFlip), 1, f);
-    fread(&m_M7VFlip, sizeof(m_M7VFlip), 1, f);
-    fread(&m_M7Old, sizeof(m_M7Old), 1, f);
-    fread(&m_M7HOFS, sizeof(m_M7HOFS), 1, f);
-    fread(&m_M7VOFS, sizeof(m_M7VOFS), 1, f);
-    fread(&m_M7A, sizeof(m_M7A), 1, f);
-    fread(&m_M7B, sizeof(m_M7B), 1, f);
-    fread(&m_M7C, sizeof(m_M7C), 1, f);
-    fread(&m_M7D, sizeof(m_M7D), 1, f);
-    fread(&m_M7X, sizeof(m_M7X), 1, f);
-    fread(&m_M7Y, sizeof(m_M7Y), 1, f);
-    fread(&m_MPY, sizeof(m_MPY), 1, f);
-    fread(&m_Ppu1OpenBus, sizeof(m_Ppu1OpenBus), 1, f);
-    fread(&m_Ppu2OpenBus, sizeof(m_Ppu2OpenBus), 1, f);
-    fread(&m_HVIRQ, sizeof(m_HVIRQ), 1, f);
+void Ppu::serialize(Serializer* s)
+{
+    SchedulerTask::serialize(s);
+
+    s->write(&m_ForcedBlanking, sizeof(m_ForcedBlanking));
+    s->write(&m_Brightness, sizeof(m_Brightness));
+    s->write(&m_HPos, sizeof(m_HPos));
+    s->write(&m_HPosReadFlip, sizeof(m_HPosReadFlip));
+    s->write(&m_VPos, sizeof(m_VPos));
+    s->write(&m_VPosReadFlip, sizeof(m_VPosReadFlip));
+    s->write(&m_VramIncrementHigh, sizeof(m_VramIncrementHigh));
+    s->write(&m_VramAddressTranslate, sizeof(m_VramAddressTranslate));
+    s->write(&m_VramIncrementStep, sizeof(m_VramIncrementStep));
+    s->write(m_Vram, sizeof(m_Vram));
+    s->write(&m_VramAddress, sizeof(m_VramAddress));
+    s->write(&m_VramPrefetch, sizeof(m_VramPrefetch));
+    s->write(&m_Cgram, sizeof(m_Cgram));
+    s->write(&m_CgdataAddress, sizeof(m_CgdataAddress));
+    s->write(&m_CgramLsbSet, sizeof(m_CgramLsbSet));
+    s->write(&m_CgramLsb, sizeof(m_CgramLsb));
+    s->write(&m_Oam, sizeof(m_Oam));
+    s->write(&m_OamAddress, sizeof(m_OamAddress));
+    s->write(&m_OamAddressReload, sizeof(m_OamAddressReload));
+    s->write(&m_OamHighestPriorityObj, sizeof(m_OamHighestPriorityObj));
+    s->write(&m_OamForcedPriority, sizeof(m_OamForcedPriority));
+    s->write(&m_OamFlip, sizeof(m_OamFlip));
+    s->write(&m_OamWriteRegister, sizeof(m_OamWriteRegister));
+    s->write(&m_ObjSize, sizeof(m_ObjSize));
+    s->write(&m_ObjGapSize, sizeof(m_ObjGapSize));
+    s->write(&m_ObjBase, sizeof(m_ObjBase));
+    s->write(&m_Backgrounds, sizeof(m_Backgrounds));
+    s->write(&m_OldBgByte, sizeof(m_OldBgByte));
+    s->write(&m_Bgmode, sizeof(m_Bgmode));
+    s->write(&m_Bg3Priority, sizeof(m_Bg3Priority));
+    s->write(&m_SubscreenBackdrop, sizeof(m_SubscreenBackdrop));
+    s->write(&m_Window1Config, sizeof(m_Window1Config));
+    s->write(&m_Window2Config, sizeof(m_Window2Config));
+    s->write(&m_WindowLogicBackground, sizeof(m_WindowLogicBackground));
+    s->write(&m_WindowLogicObj, sizeof(m_WindowLogicObj));
+    s->write(&m_WindowLogicMath, sizeof(m_WindowLogicMath));
+    s->write(&m_MainScreenConfig, sizeof(m_MainScreenConfig));
+    s->write(&m_SubScreenConfig, sizeof(m_SubScreenConfig));
+    s->write(&m_ForceMainScreenBlack, sizeof(m_ForceMainScreenBlack));
+    s->write(&m_ColorMathEnabled, sizeof(m_ColorMathEnabled));
+    s->write(&m_SubscreenEnabled, sizeof(m_SubscreenEnabled));
+    s->write(&m_ColorMathOperation, sizeof(m_ColorMathOperation));
+    s->write(&m_ColorMathBackground, sizeof(m_ColorMathBackground));
+    s->write(&m_ColorMathObj, sizeof(m_ColorMathObj));
+    s->write(&m_ColorMathBackdrop, sizeof(m_ColorMathBackdrop));
+    s->write(&m_Mosaic, sizeof(m_Mosaic));
+    s->write(&m_M7ScreenOver, sizeof(m_M7ScreenOver));
+    s->write(&m_M7HFlip, sizeof(m_M7HFlip));
+    s->write(&m_M7VFlip, sizeof(m_M7VFlip));
+    s->write(&m_M7Old, sizeof(m_M7Old));
+    s->write(&m_M7HOFS, sizeof(m_M7HOFS));
+    s->write(&m_M7VOFS, sizeof(m_M7VOFS));
+    s->write(&m_M7A, sizeof(m_M7A));
+    s->write(&m_M7B, sizeof(m_M7B));
+    s->write(&m_M7C, sizeof(m_M7C));
+    s->write(&m_M7D, sizeof(m_M7D));
+    s->write(&m_M7X, sizeof(m_M7X));
+    s->write(&m_M7Y, sizeof(m_M7Y));
+    s->write(&m_MPY, sizeof(m_MPY));
+    s->write(&m_Ppu1OpenBus, sizeof(m_Ppu1OpenBus));
+    s->write(&m_Ppu2OpenBus, sizeof(m_Ppu2OpenBus));
+    s->write(&m_HVIRQ, sizeof(m_HVIRQ));
+}
+
+void Ppu::unserialize(Deserializer* d)
+{
+    SchedulerTask::unserialize(d);
+
+    // States are saved between two frames, next run is the first dot
+    m_RenderDotCycle = getNextRunCycle();
+
+    d->read(&m_ForcedBlanking, sizeof(m_ForcedBlanking));
+    d->read(&m_Brightness, sizeof(m_Brightness));
+    d->read(&m_HPos, sizeof(m_HPos));
+    d->read(&m_HPosReadFlip, sizeof(m_HPosReadFlip));
+    d->read(&m_VPos, sizeof(m_VPos));
+    d->read(&m_VPosReadFlip, sizeof(m_VPosReadFlip));
+    d->read(&m_VramIncrementHigh, sizeof(m_VramIncrementHigh));
+    d->read(&m_VramAddressTranslate, sizeof(m_VramAddressTranslate));
+    d->read(&m_VramIncrementStep, sizeof(m_VramIncrementStep));
+    unserializeVram(d);
+    d->read(&m_VramAddress, sizeof(m_VramAddress));
+    d->read(&m_VramPrefetch, sizeof(m_VramPrefetch));
+    d->read(&m_Cgram, sizeof(m_Cgram));
+    d->read(&m_CgdataAddress, sizeof(m_CgdataAddress));
+    d->read(&m_CgramLsbSet, sizeof(m_CgramLsbSet));
+    d->read(&m_CgramLsb, sizeof(m_CgramLsb));
+    unserializeOam(d);
+    d->read(&m_OamAddress, sizeof(m_OamAddress));
+    d->read(&m_OamAddressReload, sizeof(m_OamAddressReload));
+    d->read(&m_OamHighestPriorityObj, sizeof(m_OamHighestPriorityObj));
+    d->read(&m_OamForcedPriority, sizeof(m_OamForcedPriority));
+    d->read(&m_OamFlip, sizeof(m_OamFlip));
+    d->read(&m_OamWriteRegister, sizeof(m_OamWriteRegister));
+
+    const uint16_t objSize = m_ObjSize;
+    d->read(&m_ObjSize, sizeof(m_ObjSize));
+    if (m_ObjSize != objSize) {
+        for (auto& obj : m_Objs) {
+            obj.m_Dirty = true;
+        }
+    }
+
+    d->read(&m_ObjGapSize, sizeof(m_ObjGapSize));
+    d->read(&m_ObjBase, sizeof(m_ObjBase));
+    d->read(&m_Backgrounds, sizeof(m_Backgrounds));
+    d->read(&m_OldBgByte, sizeof(m_OldBgByte));
+    d->read(&m_Bgmode, sizeof(m_Bgmode));
+    d->read(&m_Bg3Priority, sizeof(m_Bg3Priority));
+    d->read(&m_SubscreenBackdrop, sizeof(m_SubscreenBackdrop));
+    d->read(&m_Window1Config, sizeof(m_Window1Config));
+    d->read(&m_Window2Config, sizeof(m_Window2Config));
+    d->read(&m_WindowLogicBackground, sizeof(m_WindowLogicBackground));
+    d->read(&m_WindowLogicObj, sizeof(m_WindowLogicObj));
+    d->read(&m_WindowLogicMath, sizeof(m_WindowLogicMath));
+    d->read(&m_MainScreenConfig, sizeof(m_MainScreenConfig));
+    d->read(&m_SubScreenConfig, sizeof(m_SubScreenConfig));
+    d->read(&m_ForceMainScreenBlack, sizeof(m_ForceMainScreenBlack));
+    d->read(&m_ColorMathEnabled, sizeof(m_ColorMathEnabled));
+    d->read(&m_SubscreenEnabled, sizeof(m_SubscreenEnabled));
+    d->read(&m_ColorMathOperation, sizeof(m_ColorMathOperation));
+    d->read(&m_ColorMathBackground, sizeof(m_ColorMathBackground));
+    d->read(&m_ColorMathObj, sizeof(m_ColorMathObj));
+    d->read(&m_ColorMathBackdrop, sizeof(m_ColorMathBackdrop));
+    d->read(&m_Mosaic, sizeof(m_Mosaic));
+    d->read(&m_M7ScreenOver, sizeof(m_M7ScreenOver));
+    d->read(&m_M7HFlip, sizeof(m_M7HFlip));
+    d->read(&m_M7VFlip, sizeof(m_M7VFlip));
+    d->read(&m_M7Old, sizeof(m_M7Old));
+    d->read(&m_M7HOFS, sizeof(m_M7HOFS));
+    d->read(&m_M7VOFS, sizeof(m_M7VOFS));
+    d->read(&m_M7A, sizeof(m_M7A));
+    d->read(&m_M7B, sizeof(m_M7B));
+    d->read(&m_M7C, sizeof(m_M7C));
+    d->read(&m_M7D, sizeof(m_M7D));
+    d->read(&m_M7X, sizeof(m_M7X));
+    d->read(&m_M7Y, sizeof(m_M7Y));
+    d->read(&m_MPY, sizeof(m_MPY));
+    d->read(&m_Ppu1OpenBus, sizeof(m_Ppu1OpenBus));
+    d->read(&m_Ppu2OpenBus, sizeof(m_Ppu2OpenBus));
+    d->read(&m_HVIRQ, sizeof(m_HVIRQ));
+
+    // Rebuild state derived from registers
+    m_WindowMasksDirty = true;
+}
+
+void Ppu::unserializeVram(Deserializer* d)
+{
+    // Run-ahead restores a state close to the current one on each frame,
+    // only tiles whose bytes differ are decoded again
+    constexpr size_t kBlockSize = TileCache<2>::kTileSize;
+    uint8_t buffer[1024];
+
+    for (size_t offset = 0; offset < sizeof(m_Vram); offset += sizeof(buffer)) {
+        d->read(buffer, sizeof(buffer));
+
+        for (size_t i = 0; i < sizeof(buffer); i += kBlockSize) {
+            uint8_t* vram = m_Vram + offset + i;
+            if (memcmp(vram, buffer + i, kBlockSize) != 0) {
+                memcpy(vram, buffer + i, kBlockSize);
+                invalidateTileCaches(offset + i);
+            }
+        }
+    }
+}
+
+void Ppu::unserializeOam(Deserializer* d)
+{
+    uint8_t oam[sizeof(m_Oam)];
+    d->read(oam, sizeof(oam));
+
+    for (size_t i = 0; i < sizeof(oam); i++) {
+        if (m_Oam[i] != oam[i]) {
+            m_Oam[i] = oam[i];
+            invalidateObjs(i);
+        }
+    }
 }
 
 Ppu::WindowConfig::Config Ppu::getWindowConfig(uint32_t value)
@@ -2511,274 +3037,264 @@ Ppu::WindowConfig::Config Ppu::getWindowConfig(uint32_t value)
     }
 };
 
-bool Ppu::isInsideWindow(
-    int x,
+bool Ppu::getWindowMask(
+    uint8_t* mask,
     const WindowConfig& config,
-    WindowConfig::Config layerConfig,
-    bool* enabled)
+    WindowConfig::Config layerConfig)
 {
-    bool insideWindow = config.m_Left <= x && x <= config.m_Right;
+    if (layerConfig == WindowConfig::Config::disabled) {
+        return false;
+    }
 
-    if (layerConfig == WindowConfig::Config::outside) {
-        *enabled = true;
-        insideWindow = !insideWindow;
-    } else if (layerConfig == WindowConfig::Config::disabled) {
-        *enabled = false;
-        insideWindow = true;
-    } else {
-        *enabled = true;
+    const uint8_t invert =
+        layerConfig == WindowConfig::Config::inside ? 0xFF : 0;
+
+    for (int x = 0; x < kPpuDisplayWidth; x++) {
+        bool insideWindow = config.m_Left <= x && x <= config.m_Right;
+        mask[x] = (insideWindow ? 0xFF : 0) ^ invert;
     }
 
-    return insideWindow;
+    return true;
 }
 
-bool Ppu::applyWindowLogic(
-    int x,
-    WindowConfig::Config window1BgConfig,
-    WindowConfig::Config window2BgConfig,
+void Ppu::updateWindowMask(
+    uint8_t* mask,
+    WindowConfig::Config window1Config,
+    WindowConfig::Config window2Config,
     WindowLogic logic)
 {
-    bool pixelInWindow;
-
-    bool insideWindow1, window1Enabled;
-    insideWindow1 =
-        isInsideWindow(x, m_Window1Config, window1BgConfig, &window1Enabled);
+    uint8_t window1[kPpuDisplayWidth];
+    uint8_t window2[kPpuDisplayWidth];
 
-    bool insideWindow2, window2Enabled;
-    insideWindow2 =
-        isInsideWindow(x, m_Window2Config, window2BgConfig, &window2Enabled);
+    bool window1Enabled =
+        getWindowMask(window1, m_Window1Config, window1Config);
+    bool window2Enabled =
+        getWindowMask(window2, m_Window2Config, window2Config);
 
     if (window1Enabled && window2Enabled) {
         switch (logic) {
         case WindowLogic::OR:
-            pixelInWindow = !insideWindow1 || !insideWindow2;
+            for (int x = 0; x < kPpuDisplayWidth; x++) {
+                mask[x] = window1[x] | window2[x];
+            }
             break;
 
         case WindowLogic::AND:
-            pixelInWindow = !insideWindow1 && !insideWindow2;
+            for (int x = 0; x < kPpuDisplayWidth; x++) {
+                mask[x] = window1[x] & window2[x];
+            }
             break;
 
         case WindowLogic::XOR:
-            pixelInWindow = !insideWindow1 != !insideWindow2;
+            for (int x = 0; x < kPpuDisplayWidth; x++) {
+                mask[x] = window1[x] ^ window2[x];
+            }
             break;
 
         case WindowLogic::XNOR:
-            pixelInWindow = !insideWindow1 == !insideWindow2;
+            for (int x = 0; x < kPpuDisplayWidth; x++) {
+                mask[x] = ~(window1[x] ^ window2[x]);
+            }
             break;
 
         default:
             LOGE(TAG, "Unknown logic %d", static_cast<int>(logic));
-            pixelInWindow = false;
+            memset(mask, 0, kPpuDisplayWidth);
             assert(false);
             break;
         }
     } else if (window1Enabled) {
-        pixelInWindow = !insideWindow1;
+        memcpy(mask, window1, kPpuDisplayWidth);
     } else if (window2Enabled) {
-        pixelInWindow = !insideWindow2;
+        memcpy(mask, window2, kPpuDisplayWidth);
     } else {
-        pixelInWindow = false;
+        memset(mask, 0, kPpuDisplayWidth);
     }
-
-    return pixelInWindow;
 }
 
-void Ppu::initScreenRenderMode7()
+void Ppu::updateWindowMasks()
 {
-    // Prepare sprites
-    for (size_t i = 0; i < SIZEOF_ARRAY(m_RenderObjInfo); i++) {
-        m_RenderObjInfo[i].m_ObjCount = 0;
-    }
+    for (int i = 0; i < kBackgroundCount; i++) {
+        updateWindowMask(
+            m_RenderLayers[i].m_Window,
+            m_Window1Config.m_BackgroundConfig[i],
+            m_Window2Config.m_BackgroundConfig[i],
+            m_WindowLogicBackground[i]);
+    }
+
+    updateWindowMask(
+        m_RenderLayers[kLayerObj].m_Window,
+        m_Window1Config.m_ObjConfig,
+        m_Window2Config.m_ObjConfig,
+        m_WindowLogicObj);
+
+    updateWindowMask(
+        m_RenderMathWindow,
+        m_Window1Config.m_MathConfig,
+        m_Window2Config.m_MathConfig,
+        m_WindowLogicMath);
 
-    loadObjs();
+    m_WindowMasksDirty = false;
 }
 
 void Ppu::initLineRenderMode7(int y)
 {
-    m_RenderLayerPriority = s_LayerPriorityMode7;
+    setLayerPriority(s_LayerPriorityMode7);
+
+    // Registers are latched for the whole line, map coordinates of the
+    // next dots are then reached by steps of (A, C)
+    if (m_M7VFlip) {
+        y = 256 - y;
+    }
+
+    const int m7HOFS = signExtend13(m_M7HOFS);
+    const int m7VOFS = signExtend13(m_M7VOFS);
+    const int m7X = signExtend13(m_M7X);
+    const int m7Y = signExtend13(m_M7Y);
+
+    const int offsetX = m7HOFS - m7X;
+    const int offsetY = m7VOFS - m7Y;
+
+    // Hardware drops the 6 low bits of each origin product
+    m_RenderMode7.m_X = (m_M7A * offsetX & ~63) + (m_M7B * offsetY & ~63) +
+                        (m_M7B * y & ~63) + (m7X << 8);
+    m_RenderMode7.m_Y = (m_M7C * offsetX & ~63) + (m_M7D * offsetY & ~63) +
+                        (m_M7D * y & ~63) + (m7Y << 8);
+    m_RenderMode7.m_StepX = m_M7A;
+    m_RenderMode7.m_StepY = m_M7C;
+
+    if (m_M7HFlip) {
+        m_RenderMode7.m_X += 256 * m_M7A;
+        m_RenderMode7.m_Y += 256 * m_M7C;
+        m_RenderMode7.m_StepX = -m_M7A;
+        m_RenderMode7.m_StepY = -m_M7C;
+    }
 }
 
 // https://github.com/bsnes-emu/bsnes/blob/master/bsnes/sfc/ppu/mode7.cpp
-bool Ppu::renderDotMode7(
-    int x,
-    int y,
-    const ScreenConfig& screenConfig,
-    uint32_t* color,
-    BgColorProp* colorProp)
+void Ppu::renderBgLineMode7(int x, int xEnd)
 {
-    for (size_t prioIdx = 0;
-         m_RenderLayerPriority[prioIdx].m_Layer != Layer::none;
-         prioIdx++) {
-        const auto& layer = m_RenderLayerPriority[prioIdx];
+    LayerLine* layer = &m_RenderLayers[0];
+    const uint8_t z = m_RenderBgZ[0][0];
 
-        if (layer.m_Layer == Layer::background) {
-            RendererBgInfo* renderBg = &m_RenderBgInfo[layer.m_BgIdx];
-            bool colorValid = renderGetColorMode7(x, y, screenConfig, color);
+    memset(layer->m_Math + x, m_ColorMathBackground[0] ? 0xFF : 0, xEnd - x);
 
-            if (colorValid) {
-                if (colorProp) {
-                    colorProp->m_Layer = Layer::background;
-                    colorProp->m_BgIdx = 0;
-                }
+    // Outside of the map, dots either wrap, are transparent or use tile 0
+    const bool wrap = m_M7ScreenOver == 0 || m_M7ScreenOver == 1;
+    const uint8_t outsideTileMask = m_M7ScreenOver == 3 ? 0 : 0xFF;
+    const uint8_t outsideColorMask = m_M7ScreenOver == 2 ? 0 : 0xFF;
 
-                return true;
-            }
-        } else if (layer.m_Layer == Layer::sprite) {
-            int palette;
-            bool colorValid = getSpriteCurrentPixel(
-                x, y, screenConfig, layer.m_Priority, color, &palette);
-
-            if (colorValid) {
-                if (colorProp) {
-                    colorProp->m_Layer = Layer::sprite;
-                    colorProp->m_Palette = palette;
-                }
+    // VRAM words hold a tilemap entry in their low byte and a tile pixel in
+    // their high byte
+    auto drawDot = [&](int dotX, int mapAddr, int tileAddr, bool outside) {
+        uint8_t tile = m_Vram[mapAddr];
+        if (outside) {
+            tile &= outsideTileMask;
+        }
 
-                return true;
-            }
+        uint8_t cgramIdx = m_Vram[tile * kPpuMode7TileSize + tileAddr];
+        if (outside) {
+            cgramIdx &= outsideColorMask;
         }
-    }
 
-    return false;
-}
+        if (cgramIdx) {
+            layer->m_Color[dotX] = m_Cgram[cgramIdx];
+            layer->m_Z[dotX] = z;
+        } else {
+            layer->m_Z[dotX] = kZTransparent;
+        }
+    };
 
-bool Ppu::renderGetColorMode7(
-    int x,
-    int y,
-    const ScreenConfig& screenConfig,
-    uint32_t* c)
-{
-    if (!screenConfig.m_BgEnabled[0]) {
-        return false;
-    }
+#if defined(__SSE2__)
+    // Addresses are computed for 8 dots at once, fetches stay scalar
+    constexpr int kDotCount = 8;
 
-    // Check if background is inside window
-    bool pixelInWindow = false;
+    const __m128i ones = _mm_set1_epi32(-1);
+    const __m128i tilemapMask = _mm_set1_epi32(kPpuMode7TilemapWidth - 1);
+    const __m128i tileMask = _mm_set1_epi32(kPpuBaseTileWidth - 1);
+    const __m128i outsideBits = _mm_set1_epi32(~(kPpuMode7MapSize - 1));
+    const __m128i vWrap = _mm_set1_epi32(wrap ? -1 : 0);
 
-    if (m_MainScreenConfig.m_Window_BgDisable[0]) {
-        pixelInWindow = applyWindowLogic(
-            x,
-            m_Window1Config.m_BackgroundConfig[0],
-            m_Window2Config.m_BackgroundConfig[0],
-            m_WindowLogicBackground[0]);
-    }
+    const int stepX = m_RenderMode7.m_StepX;
+    const int stepY = m_RenderMode7.m_StepY;
+    const __m128i vStepX = _mm_set1_epi32(kDotCount * stepX);
+    const __m128i vStepY = _mm_set1_epi32(kDotCount * stepY);
 
-    if (pixelInWindow) {
-        return false;
-    }
+    __m128i mapX[2];
+    __m128i mapY[2];
 
-    if (m_M7HFlip) {
-        x = 256 - x;
-    }
+    for (int i = 0; i < 2; i++) {
+        const int firstX = m_RenderMode7.m_X + (x + i * 4) * stepX;
+        const int firstY = m_RenderMode7.m_Y + (x + i * 4) * stepY;
 
-    if (m_M7VFlip) {
-        y = 256 - y;
+        mapX[i] = _mm_setr_epi32(
+            firstX, firstX + stepX, firstX + 2 * stepX, firstX + 3 * stepX);
+        mapY[i] = _mm_setr_epi32(
+            firstY, firstY + stepY, firstY + 2 * stepY, firstY + 3 * stepY);
     }
 
-    auto int13ToInt = [](int16_t value) -> int {
-        // Extract bit sign
-        const int sign = (value >> 12) & 1;
-        value &= ~(1 << 12);
+    for (; x + kDotCount <= xEnd; x += kDotCount) {
+        alignas(16) int32_t mapAddr[kDotCount];
+        alignas(16) int32_t tileAddr[kDotCount];
+        alignas(16) int32_t outside[kDotCount];
 
-        // Add scale factor (0x100)
-        int intValue = value << 8;
+        for (int i = 0; i < 2; i++) {
+            const __m128i dotX = _mm_srai_epi32(mapX[i], 8);
+            const __m128i dotY = _mm_srai_epi32(mapY[i], 8);
 
-        if (sign) {
-            // Extend sign
-            return intValue | 0xFFF00000;
-        } else {
-            return intValue;
-        }
-    };
+            const __m128i tilemapX =
+                _mm_and_si128(_mm_srai_epi32(dotX, 3), tilemapMask);
+            const __m128i tilemapY =
+                _mm_and_si128(_mm_srai_epi32(dotY, 3), tilemapMask);
+            const __m128i map = _mm_slli_epi32(
+                _mm_or_si128(_mm_slli_epi32(tilemapY, 7), tilemapX), 1);
 
-    // Initial type: with 0 scale factor
-    // Add 0x100 scale factor
-    int scaledX = x << 8;
-    int scaledY = y << 8;
-
-    // Initial type: int16 with 0x100 scale factor
-    int m7A = m_M7A;
-    int m7B = m_M7B;
-    int m7C = m_M7C;
-    int m7D = m_M7D;
-
-    // Initial type: int13 with 0 scale factor
-    // Switch to int16 and add 0x100 scale factor
-    int m7HOFS = int13ToInt(m_M7HOFS);
-    int m7VOFS = int13ToInt(m_M7VOFS);
-    int m7X = int13ToInt(m_M7X);
-    int m7Y = int13ToInt(m_M7Y);
-
-    // Apply transformation
-    int offsetX = scaledX + m7HOFS - m7X;
-    int offsetY = scaledY + m7VOFS - m7Y;
-
-    int vramX = (m7A * offsetX & ~63) + (m7B * offsetY & ~63) + (m7X << 8);
-    int vramY = (m7C * offsetX & ~63) + (m7D * offsetY & ~63) + (m7Y << 8);
-
-    // Remove scale factor (multiplication double the scale factor)
-    vramX >>= 16;
-    vramY >>= 16;
-
-    // Handle wrap
-    if (m_M7ScreenOver == 0 || m_M7ScreenOver == 1) {
-        if (vramX > 1024) {
-            vramX %= 1024;
-        } else if (vramX < 0) {
-            vramX += 1024;
-        }
-
-        if (vramY > 1024) {
-            vramY %= 1024;
-        } else if (vramY < 0) {
-            vramY += 1024;
-        }
-    } else if (m_M7ScreenOver == 2) {
-        if (vramX < 0 || vramX > 1024) {
-            return 0;
-        }
+            const __m128i tileX = _mm_and_si128(dotX, tileMask);
+            const __m128i tileY = _mm_and_si128(dotY, tileMask);
+            const __m128i tile = _mm_or_si128(
+                _mm_slli_epi32(
+                    _mm_or_si128(_mm_slli_epi32(tileY, 3), tileX), 1),
+                _mm_set1_epi32(1));
 
-        if (vramY < 0 || vramY > 1024) {
-            return 0;
-        }
-    } else if (m_M7ScreenOver == 3) {
-        if (vramX > 1024) {
-            vramX %= 8;
-            vramY %= 8;
-        } else if (vramX < 0) {
-            vramX = (vramX + 1024) % 8;
-            vramY = (vramY + 1024) % 8;
+            const __m128i inside = _mm_cmpeq_epi32(
+                _mm_and_si128(_mm_or_si128(dotX, dotY), outsideBits),
+                _mm_setzero_si128());
+            const __m128i out =
+                _mm_xor_si128(_mm_or_si128(inside, vWrap), ones);
+
+            storeBlock(mapAddr + i * 4, map);
+            storeBlock(tileAddr + i * 4, tile);
+            storeBlock(outside + i * 4, out);
+
+            mapX[i] = _mm_add_epi32(mapX[i], vStepX);
+            mapY[i] = _mm_add_epi32(mapY[i], vStepY);
         }
 
-        if (vramY > 1024) {
-            vramX %= 8;
-            vramY %= 8;
-        } else if (vramY < 0) {
-            vramX = (vramX + 1024) % 8;
-            vramY = (vramY + 1024) % 8;
+        for (int i = 0; i < kDotCount; i++) {
+            drawDot(x + i, mapAddr[i], tileAddr[i], outside[i]);
         }
     }
+#endif
 
-    // Compute tile address
-    const int tilemapX = vramX / 8;
-    const int tilemapY = vramY / 8;
+    for (; x < xEnd; x++) {
+        const int dotX =
+            (m_RenderMode7.m_X + x * m_RenderMode7.m_StepX) >> 8;
+        const int dotY =
+            (m_RenderMode7.m_Y + x * m_RenderMode7.m_StepY) >> 8;
 
-    const int tileX = vramX % 8;
-    const int tileY = vramY % 8;
+        const int tilemapX = (dotX >> 3) & (kPpuMode7TilemapWidth - 1);
+        const int tilemapY = (dotY >> 3) & (kPpuMode7TilemapWidth - 1);
+        const int mapAddr = (tilemapY * kPpuMode7TilemapWidth + tilemapX) * 2;
 
-    const int kPpuMode7TilemapWidth = 128;
-    const int mapEntryIdx = kPpuMode7TilemapWidth * tilemapY + tilemapX;
-    const int charIdx = m_Vram[mapEntryIdx * 2];
+        const int tileX = dotX & (kPpuBaseTileWidth - 1);
+        const int tileY = dotY & (kPpuBaseTileHeight - 1);
+        const int tileAddr = (tileY * kPpuBaseTileWidth + tileX) * 2 + 1;
 
-    // Read palette index
-    const int tileBaseAddr = charIdx * 0x80 + 1;
-    const uint32_t cgramIdx = m_Vram[tileBaseAddr + tileY * 0x10 + tileX * 2];
-    if (cgramIdx == 0) {
-        return false;
-    }
+        const bool outside =
+            !wrap && ((dotX | dotY) & ~(kPpuMode7MapSize - 1));
 
-    *c = m_Cgram[cgramIdx];
-    return true;
+        drawDot(x, mapAddr, tileAddr, outside);
+    }
 }
 
 } // namespace msfce::core
@@ -10,9 +10,12 @@
 #include "memcomponent.h"
 #include "registers.h"
 #include "schedulertask.h"
+#include "tilecache.h"
 
 namespace msfce::core {
 
+class Scheduler;
+
 class Ppu
     : public MemComponent
     , public SchedulerTask {
@@ -40,19 +43,30 @@ public:
 
     using ScanStartedCb = std::function<void()>;
     using ScanEndedCb = std::function<void()>;
-    using RenderCb = std::function<void(const Color& c)>;
 
 public:
-    Ppu(ScanStartedCb scanStartedCb,
-        ScanEndedCb scanEndedCb,
-        RenderCb renderCb);
+    Ppu(const uint64_t& masterClock,
+        ScanStartedCb scanStartedCb,
+        ScanEndedCb scanEndedCb);
     ~Ppu() = default;
 
+    void setScheduler(const std::shared_ptr<Scheduler>& scheduler);
+
+    void setFramebuffer(const Framebuffer& framebuffer);
+    const uint8_t* getLineBrightness() const;
+
     void dump() const;
 
     uint8_t readU8(uint32_t addr) override;
     void writeU8(uint32_t addr, uint8_t value) override;
 
+    void writeRegisterBlock(
+        uint32_t address,
+        const uint8_t* offsets,
+        size_t offsetCount,
+        const uint8_t* data,
+        size_t size) override;
+
     int run() override;
 
     uint32_t getEvents() const;
@@ -60,8 +74,8 @@ public:
 
     void setHVIRQConfig(HVIRQConfig config, uint16_t H, uint16_t V);
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
 
 private:
     typedef uint32_t (*TilemapMapper)(uint16_t tilemapBase, int x, int y);
@@ -69,6 +83,13 @@ private:
     static const int kObjCount = 128;
     static const int kBackgroundCount = 4;
 
+    // Backgrounds then OBJ
+    static const int kLayerCount = kBackgroundCount + 1;
+    static const int kLayerObj = kBackgroundCount;
+
+    // Z of transparent pixels and layers missing from the priority chart
+    static const uint8_t kZTransparent = 0xFF;
+
 private:
     struct Background {
         uint16_t m_TilemapBase = 0;
@@ -114,38 +135,35 @@ private:
 
         int m_xEnd;
 
-        bool m_OnScreen;
+        // OAM or OBJ size changed since the last decode
+        bool m_Dirty = true;
     };
 
-    struct RendererBgInfo {
-        int bgIdx;
-        Background* background;
-
-        /**
-         * BG global configuration.
-         * Unit "tile" is a base 8x8 tile.
-         */
-
-        // Unit: tile
-        int tilemapWidth;
-        int tilemapHeight;
+    struct RendererBgInfo;
 
-        // Unit: pixel
-        int tilemapWidthPixel;
-        int tilemapHeightPixel;
+    // BG functions specialised for a bpp, tile size and tilemap size
+    typedef void (Ppu::*BgTileFetcher)(RendererBgInfo* renderBg);
+    typedef void (Ppu::*BgLineRenderer)(
+        RendererBgInfo* renderBg,
+        int x,
+        int xEnd,
+        bool draw);
 
-        // Unit: tile
-        int tileWidth;
-        int tileHeight;
+    struct BgRenderer {
+        BgTileFetcher m_FetchTile;
+        BgLineRenderer m_RenderLine;
+        BgLineRenderer m_RenderLineMosaic;
+    };
 
-        // Unit: pixel
-        int tileWidthPixel;
-        int tileHeightPixel;
+    struct RendererBgInfo {
+        int bgIdx;
+        Background* background;
 
-        int tileBpp;
-        int tileSize;
+        // Selected for the current line
+        BgLineRenderer renderLine;
 
-        TilemapMapper tilemapMapper;
+        // First CGRAM index of the BG palettes
+        int cgramOffset;
 
         /**
          * Current position in the tilemap (unit: tile)
@@ -169,6 +187,9 @@ private:
         int palette;
         int tileIndex;
 
+        // CGRAM index of the current tile palette
+        int colorBase;
+
         /**
          * Current tile info
          */
@@ -176,11 +197,8 @@ private:
         int subtilePixelX;
         int subtilePixelY;
 
-        // Tile data
-        const uint8_t* tileDataPlane0; // 2 first bits
-        const uint8_t* tileDataPlane1; // 2 next bits
-        const uint8_t* tileDataPlane2; // 2 next bits
-        const uint8_t* tileDataPlane3; // 2 next bits
+        // Decoded colors of the current subtile row
+        const uint8_t* tileRow;
 
         // Mosaic
         struct {
@@ -190,9 +208,11 @@ private:
         } mosaic;
     };
 
-    struct RenderObjInfo {
-        ObjProperty* m_Obj[kObjCount];
-        int m_ObjCount;
+    // OBJ pixels of the current line, rasterised at line start
+    struct ObjLine {
+        // CGRAM index, 0 where no sprite is drawn
+        uint8_t m_Color[kPpuDisplayWidth];
+        uint8_t m_Priority[kPpuDisplayWidth];
     };
 
     // Window
@@ -235,50 +255,62 @@ private:
         Always,
     };
 
-    struct BgColorProp {
-        Layer m_Layer;
+    // Layer pixels of the dots being drawn, composited by resolveScreen()
+    struct LayerLine {
+        uint16_t m_Color[kPpuDisplayWidth];
 
-        // Background attributes
-        int m_BgIdx;
+        // Position in the priority chart, the lowest one is drawn
+        uint8_t m_Z[kPpuDisplayWidth];
 
-        // Sprite attributes
-        int m_Palette;
+        // 0xFF where the pixel is masked by the layer window
+        uint8_t m_Window[kPpuDisplayWidth];
+
+        // 0xFF where the pixel takes part in color math
+        uint8_t m_Math[kPpuDisplayWidth];
     };
 
 private:
     void setHVIRQ(int x, int y);
 
-    TilemapMapper getTilemapMapper(uint16_t tilemapSize) const;
-
-    void updateTileData(const Background* bg, RendererBgInfo* renderBg);
-    void updateSubtileData(const Background* bg, RendererBgInfo* renderBg);
+    void runDot();
+    void catchUp();
+    int getDotsToNextEvent() const;
+    uint64_t getNextEventCycle() const;
 
-    bool getScreenCurrentPixel(
-        int x,
-        int y,
-        const ScreenConfig& screenConfig,
-        uint32_t* color,
-        BgColorProp* colorProp);
+    TilemapMapper getTilemapMapper(uint16_t tilemapSize) const;
 
-    bool getBackgroundCurrentPixel(
-        int x,
-        const ScreenConfig& screenConfig,
-        const RendererBgInfo* renderBg,
-        int priority,
-        uint32_t* color);
+    template <int kBpp, int kTileSize, int kTilemapSize>
+    static BgRenderer makeBgRenderer();
+    template <int kBpp, int kTileSize>
+    static BgRenderer getBgRenderer(uint16_t tilemapSize);
+    static BgRenderer getBgRenderer(
+        int tileBpp,
+        uint16_t tileSize,
+        uint16_t tilemapSize);
+
+    template <int kBpp, int kTileSize, int kTilemapSize>
+    void fetchBgTile(RendererBgInfo* renderBg);
+    template <int kBpp>
+    void fetchBgSubtile(RendererBgInfo* renderBg);
+
+    template <int kBpp, int kTileSize, int kTilemapSize>
+    void moveBgDots(RendererBgInfo* renderBg, int dots);
+    void incrementVramAddress();
+    void invalidateTileCaches(uint16_t address);
+    template <int kBpp>
+    const uint8_t* getTileRow(uint16_t tileAddress, int row);
+    const uint8_t* getTileRow(int bpp, uint16_t tileAddress, int row);
 
-    bool getSpriteCurrentPixel(
-        int x,
-        int y,
-        const ScreenConfig& screenConfig,
-        int priority,
-        uint32_t* color,
-        int* palette = nullptr);
+    void writeVramData(bool high, uint8_t value);
+    void writeCgramData(uint8_t value);
+    void writeOamData(uint8_t value);
 
-    void moveToNextPixel(RendererBgInfo* renderBg);
-    void incrementVramAddress();
+    void unserializeVram(Deserializer* d);
+    void unserializeOam(Deserializer* d);
 
-    void loadObjs();
+    void decodeObj(int objIdx);
+    void invalidateObjs(uint16_t oamAddress);
+    void renderObjs(int y);
     void printObjsCoordinates();
 
     uint32_t getColorFromCgram(int bgIdx, int bpp, int palette, int colorIdx);
@@ -296,41 +328,53 @@ private:
 
     void initScreenRender();
     void initLineRender(int y);
-    void renderDot(int x, int y);
+    void setLayerPriority(const LayerPriority* chart);
+
+    template <int kBpp, int kTileSize, int kTilemapSize, bool kMosaic>
+    void renderBgLine(RendererBgInfo* renderBg, int x, int xEnd, bool draw);
+    void renderObjLine(int x, int xEnd);
+
+    void resolveScreen(
+        const ScreenConfig& screenConfig,
+        int bgCount,
+        int x,
+        int xEnd,
+        uint16_t backdrop,
+        bool backdropMath,
+        uint16_t* color,
+        uint8_t* math);
+
+    void renderDots(int x, int xEnd, int y);
+    void drawPixel(int x, int y, uint32_t rawColor);
     void renderStep();
 
     static WindowConfig::Config getWindowConfig(uint32_t value);
-    static bool isInsideWindow(
-        int x,
+
+    // Fill `mask` with the pixels masked by a single window, false if the
+    // window is disabled for the layer
+    static bool getWindowMask(
+        uint8_t* mask,
         const WindowConfig& config,
-        WindowConfig::Config layerConfig,
-        bool* enabled);
-    bool applyWindowLogic(
-        int x,
+        WindowConfig::Config layerConfig);
+    void updateWindowMask(
+        uint8_t* mask,
         WindowConfig::Config window1Config,
         WindowConfig::Config window2Config,
         WindowLogic logic);
+    void updateWindowMasks();
 
-    void initScreenRenderMode7();
     void initLineRenderMode7(int y);
 
-    bool renderDotMode7(
-        int x,
-        int y,
-        const ScreenConfig& screenConfig,
-        uint32_t* color,
-        BgColorProp* colorProp);
-
-    bool renderGetColorMode7(
-        int x,
-        int y,
-        const ScreenConfig& screenConfig,
-        uint32_t* color);
+    void renderBgLineMode7(int x, int xEnd);
 
 private:
+    const uint64_t& m_MasterClock;
+    std::shared_ptr<Scheduler> m_Scheduler;
+
     ScanStartedCb m_ScanStartedCb;
     ScanEndedCb m_ScanEndedCb;
-    RenderCb m_RenderCb;
+    Framebuffer m_Framebuffer;
+    uint8_t m_LineBrightness[kPpuDisplayHeight] = {};
     DrawConfig m_DrawConfig = DrawConfig::Draw;
     uint32_t m_Events = 0;
 
@@ -358,6 +402,9 @@ private:
     uint8_t m_VramAddressTranslate = 0;
     uint8_t m_VramIncrementStep = 0;
     uint8_t m_Vram[64 * 1024];
+    TileCache<2> m_TileCache2bpp;
+    TileCache<4> m_TileCache4bpp;
+    TileCache<8> m_TileCache8bpp;
     uint16_t m_VramAddress = 0;
     uint16_t m_VramPrefetch = 0;
 
@@ -396,27 +443,30 @@ private:
     // Mosaic
     struct {
         uint8_t m_Size = 0;
-        bool m_Backgrounds[kBackgroundCount];
+        bool m_Backgrounds[kBackgroundCount] = {};
     } m_Mosaic;
 
     // Window
-    WindowConfig m_Window1Config;
-    WindowConfig m_Window2Config;
+    WindowConfig m_Window1Config = {};
+    WindowConfig m_Window2Config = {};
+
+    WindowLogic m_WindowLogicBackground[kBackgroundCount] = {};
+    WindowLogic m_WindowLogicObj = WindowLogic::OR;
+    WindowLogic m_WindowLogicMath = WindowLogic::OR;
 
-    WindowLogic m_WindowLogicBackground[kBackgroundCount];
-    WindowLogic m_WindowLogicObj;
-    WindowLogic m_WindowLogicMath;
+    // Layer and math window masks need an update
+    bool m_WindowMasksDirty = true;
 
-    ScreenConfig m_MainScreenConfig;
-    ScreenConfig m_SubScreenConfig;
+    ScreenConfig m_MainScreenConfig = {};
+    ScreenConfig m_SubScreenConfig = {};
 
     // Color math
-    ColorMathConfig m_ForceMainScreenBlack;
-    ColorMathConfig m_ColorMathEnabled;
+    ColorMathConfig m_ForceMainScreenBlack = ColorMathConfig::Never;
+    ColorMathConfig m_ColorMathEnabled = ColorMathConfig::Never;
     bool m_SubscreenEnabled = false;
 
     uint8_t m_ColorMathOperation = 0;
-    bool m_ColorMathBackground[kBackgroundCount];
+    bool m_ColorMathBackground[kBackgroundCount] = {};
     bool m_ColorMathObj = false;
     bool m_ColorMathBackdrop = false;
 
@@ -447,9 +497,29 @@ private:
     int m_RenderX = 0;
     int m_RenderY = 0;
 
+    // Master clock cycle of the dot at m_RenderX/m_RenderY
+    uint64_t m_RenderDotCycle = 0;
+
     RendererBgInfo m_RenderBgInfo[kBackgroundCount];
-    RenderObjInfo m_RenderObjInfo[kPpuDisplayHeight];
+    ObjLine m_RenderObjLine = {};
+
+    // Mode 7 map coordinates of the first dot of the line and their step
+    // per dot, with 0x100 scale factor
+    struct {
+        int m_X = 0;
+        int m_Y = 0;
+        int m_StepX = 0;
+        int m_StepY = 0;
+    } m_RenderMode7;
+
     const Ppu::LayerPriority* m_RenderLayerPriority = nullptr;
+
+    // Z of each layer and priority in m_RenderLayerPriority
+    uint8_t m_RenderBgZ[kBackgroundCount][2] = {};
+    uint8_t m_RenderObjZ[4] = {};
+
+    LayerLine m_RenderLayers[kLayerCount] = {};
+    uint8_t m_RenderMathWindow[kPpuDisplayWidth] = {};
 };
 
 } // namespace msfce::core
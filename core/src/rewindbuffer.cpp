@@ -0,0 +1,266 @@
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "msfce/core/log.h"
+#include "msfce/core/snes.h"
+#include "msfce/core/rewindbuffer.h"
+
+#define TAG "rewind"
+
+namespace {
+
+// Equal bytes needed to end a literal run
+constexpr size_t kMinSkip = 4;
+
+// Worst case overhead of a delta, see encodeDelta()
+constexpr size_t kDeltaOverhead = 32;
+
+uint8_t* writeVarint(uint8_t* out, size_t value)
+{
+    while (value >= 0x80) {
+        *out++ = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+
+    *out++ = value;
+    return out;
+}
+
+const uint8_t* readVarint(const uint8_t* in, size_t* value)
+{
+    int shift = 0;
+
+    *value = 0;
+    while (*in & 0x80) {
+        *value |= static_cast<size_t>(*in++ & 0x7F) << shift;
+        shift += 7;
+    }
+
+    *value |= static_cast<size_t>(*in++) << shift;
+    return in;
+}
+
+size_t countEqualBytes(const uint8_t* a, const uint8_t* b, size_t size)
+{
+    size_t pos = 0;
+
+    while (pos + sizeof(uint64_t) <= size) {
+        uint64_t va;
+        uint64_t vb;
+
+        memcpy(&va, a + pos, sizeof(va));
+        memcpy(&vb, b + pos, sizeof(vb));
+        if (va != vb) {
+            break;
+        }
+
+        pos += sizeof(uint64_t);
+    }
+
+    while (pos < size && a[pos] == b[pos]) {
+        pos++;
+    }
+
+    return pos;
+}
+
+// Delta is a list of (equal byte count, literal count, XORed literals).
+// Literal runs only end on kMinSkip equal bytes, so each run takes at least
+// as many bytes as it encodes, except the first one.
+size_t encodeDelta(
+    const uint8_t* a,
+    const uint8_t* b,
+    size_t size,
+    uint8_t* out)
+{
+    uint8_t* outBegin = out;
+    size_t pos = 0;
+
+    while (pos < size) {
+        size_t skip = countEqualBytes(a + pos, b + pos, size - pos);
+        pos += skip;
+
+        size_t literalBegin = pos;
+        while (pos < size) {
+            if (a[pos] != b[pos]) {
+                pos++;
+                continue;
+            }
+
+            size_t equal = 0;
+            while (pos + equal < size && equal < kMinSkip &&
+                   a[pos + equal] == b[pos + equal]) {
+                equal++;
+            }
+
+            if (equal == kMinSkip || pos + equal == size) {
+                break;
+            }
+
+            pos += equal;
+        }
+
+        size_t literalCount = pos - literalBegin;
+
+        out = writeVarint(out, skip);
+        out = writeVarint(out, literalCount);
+        for (size_t i = literalBegin; i < pos; i++) {
+            *out++ = a[i] ^ b[i];
+        }
+    }
+
+    return out - outBegin;
+}
+
+void applyDelta(uint8_t* data, const uint8_t* delta, size_t deltaSize)
+{
+    const uint8_t* deltaEnd = delta + deltaSize;
+
+    while (delta < deltaEnd) {
+        size_t skip;
+        size_t literalCount;
+
+        delta = readVarint(delta, &skip);
+        delta = readVarint(delta, &literalCount);
+
+        data += skip;
+        for (size_t i = 0; i < literalCount; i++) {
+            *data++ ^= *delta++;
+        }
+    }
+}
+
+} // anonymous namespace
+
+namespace msfce::core {
+
+RewindBuffer::RewindBuffer(
+    const std::shared_ptr<Snes>& snes,
+    size_t maxSize,
+    int interval)
+    : m_Snes(snes)
+    , m_Interval(interval)
+    , m_Ring(maxSize)
+{
+    assert(m_Interval > 0);
+}
+
+void RewindBuffer::onFrameEnded()
+{
+    m_FrameCounter++;
+    if (m_FrameCounter < m_Interval) {
+        return;
+    }
+
+    m_FrameCounter = 0;
+    m_Snes->serialize(m_Snapshot);
+
+    if (m_HasCurrent && m_Current.size() == m_Snapshot.size()) {
+        // Delta to go back from the new snapshot to the previous one
+        m_Delta.resize(m_Snapshot.size() + kDeltaOverhead);
+
+        size_t deltaSize = encodeDelta(
+            m_Current.data(),
+            m_Snapshot.data(),
+            m_Snapshot.size(),
+            m_Delta.data());
+        assert(deltaSize <= m_Delta.size());
+
+        pushDelta(m_Delta.data(), deltaSize);
+    } else {
+        m_Entries.clear();
+    }
+
+    std::swap(m_Current, m_Snapshot);
+    m_HasCurrent = true;
+}
+
+int RewindBuffer::stepBack()
+{
+    if (!m_HasCurrent) {
+        return -ENOENT;
+    }
+
+    int ret = m_Snes->unserialize(m_Current.data(), m_Current.size());
+    if (ret < 0) {
+        clear();
+        return ret;
+    }
+
+    m_FrameCounter = 0;
+
+    if (m_Entries.empty()) {
+        m_HasCurrent = false;
+        return 0;
+    }
+
+    const Entry& entry = m_Entries.back();
+    applyDelta(m_Current.data(), &m_Ring[entry.offset], entry.size);
+    m_Entries.pop_back();
+
+    return 0;
+}
+
+void RewindBuffer::clear()
+{
+    m_Entries.clear();
+    m_HasCurrent = false;
+    m_FrameCounter = 0;
+}
+
+size_t RewindBuffer::getSnapshotCount() const
+{
+    return m_HasCurrent ? m_Entries.size() + 1 : 0;
+}
+
+size_t RewindBuffer::getUsedSize() const
+{
+    size_t size = 0;
+
+    for (const auto& entry : m_Entries) {
+        size += entry.size;
+    }
+
+    return size;
+}
+
+void RewindBuffer::pushDelta(const uint8_t* data, size_t size)
+{
+    if (size > m_Ring.size()) {
+        LOGW(TAG, "Delta of %zu bytes doesn't fit, dropping history", size);
+        m_Entries.clear();
+        return;
+    }
+
+    size_t offset = 0;
+
+    if (!m_Entries.empty()) {
+        const Entry& last = m_Entries.back();
+
+        offset = last.offset + last.size;
+        if (offset + size > m_Ring.size()) {
+            // Wrap, entries left after the end are the oldest ones
+            while (!m_Entries.empty() && m_Entries.front().offset >= offset) {
+                m_Entries.pop_front();
+            }
+
+            offset = 0;
+        }
+    }
+
+    // Oldest entries follow the write position, drop those overwritten
+    while (!m_Entries.empty()) {
+        const Entry& front = m_Entries.front();
+        if (front.offset < offset || front.offset >= offset + size) {
+            break;
+        }
+
+        m_Entries.pop_front();
+    }
+
+    memcpy(&m_Ring[offset], data, size);
+    m_Entries.push_back({offset, size});
+}
+
+} // namespace msfce::core
@@ -0,0 +1,58 @@
+#include <assert.h>
+
+#include "msfce/core/snes.h"
+#include "msfce/core/runahead.h"
+
+namespace msfce::core {
+
+RunAhead::RunAhead(const std::shared_ptr<Snes>& snes, int frames)
+    : m_Snes(snes)
+    , m_Frames(frames)
+{
+    assert(m_Frames >= 0 && m_Frames <= kMaxFrames);
+}
+
+int RunAhead::renderSingleFrame()
+{
+    m_Timings = {};
+
+    if (m_Frames == 0) {
+        return runFrame(true, true);
+    }
+
+    // Emulated frame, only its audio is played
+    int ret = runFrame(false, true);
+    if (ret < 0) {
+        return ret;
+    }
+
+    m_Snes->serialize(m_State);
+
+    // Frames ahead only update the state, but the last one that is shown
+    for (int i = 0; i < m_Frames - 1; i++) {
+        runFrame(false, false);
+    }
+
+    runFrame(true, false);
+
+    return m_Snes->unserialize(m_State.data(), m_State.size());
+}
+
+FrameTimings RunAhead::getFrameTimings() const
+{
+    return m_Timings;
+}
+
+int RunAhead::runFrame(bool renderPpu, bool renderAudio)
+{
+    int ret = m_Snes->renderSingleFrame(renderPpu, renderAudio);
+
+    FrameTimings timings = m_Snes->getFrameTimings();
+    m_Timings.cpuUs += timings.cpuUs;
+    m_Timings.ppuUs += timings.ppuUs;
+    m_Timings.apuUs += timings.apuUs;
+
+    return ret;
+}
+
+} // namespace msfce::core
@@ -1,5 +1,12 @@
+#include <limits>
 #include "schedulertask.h"
 
+namespace {
+
+constexpr uint64_t kSleepingCycle = std::numeric_limits<uint64_t>::max();
+
+} // anonymous namespace
+
 namespace msfce::core {
 
 SchedulerTask::State SchedulerTask::getState()
@@ -23,16 +30,26 @@ uint64_t SchedulerTask::getNextRunCycle()
     return m_NextRunCycle;
 }
 
-void SchedulerTask::dumpToFile(FILE* f)
+void SchedulerTask::sleep()
+{
+    m_NextRunCycle = kSleepingCycle;
+}
+
+bool SchedulerTask::isSleeping()
+{
+    return m_NextRunCycle == kSleepingCycle;
+}
+
+void SchedulerTask::serialize(Serializer* s)
 {
-    fwrite(&m_State, sizeof(m_State), 1, f);
-    fwrite(&m_NextRunCycle, sizeof(m_NextRunCycle), 1, f);
+    s->write(&m_State, sizeof(m_State));
+    s->write(&m_NextRunCycle, sizeof(m_NextRunCycle));
 }
 
-void SchedulerTask::loadFromFile(FILE* f)
+void SchedulerTask::unserialize(Deserializer* d)
 {
-    fread(&m_State, sizeof(m_State), 1, f);
-    fread(&m_NextRunCycle, sizeof(m_NextRunCycle), 1, f);
+    d->read(&m_State, sizeof(m_State));
+    d->read(&m_NextRunCycle, sizeof(m_NextRunCycle));
 }
 
 } // namespace msfce::core
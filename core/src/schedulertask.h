@@ -1,8 +1,9 @@
 #pragma once
 
-#include <stdio.h>
 #include <cstdint>
 
+#include "serializer.h"
+
 namespace msfce::core {
 
 class SchedulerTask {
@@ -23,8 +24,12 @@ public:
     void setNextRunCycle(uint64_t cycle);
     uint64_t getNextRunCycle();
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    // Task won't run until another one resumes it
+    void sleep();
+    bool isSleeping();
+
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
 
     virtual int run() = 0;
 
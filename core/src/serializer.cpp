@@ -0,0 +1,151 @@
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "serializer.h"
+
+namespace {
+
+constexpr uint32_t kStateMagic = msfce::core::makeChunkId("MSFC");
+
+struct ChunkHeader {
+    uint32_t id;
+    uint32_t size;
+};
+
+} // anonymous namespace
+
+namespace msfce::core {
+
+Serializer::Serializer(
+    std::vector<uint8_t>* buffer,
+    std::vector<StateChunk>* chunks)
+    : m_Buffer(buffer)
+    , m_Chunks(chunks)
+{
+    if (m_Buffer) {
+        m_Buffer->clear();
+    }
+}
+
+void Serializer::writeHeader()
+{
+    write(&kStateMagic, sizeof(kStateMagic));
+    write(&kStateVersion, sizeof(kStateVersion));
+}
+
+void Serializer::beginChunk(uint32_t id)
+{
+    ChunkHeader header = {id, 0};
+
+    m_ChunkId = id;
+    m_ChunkBegin = m_Size;
+    write(&header, sizeof(header));
+}
+
+void Serializer::endChunk()
+{
+    uint32_t size = m_Size - m_ChunkBegin - sizeof(ChunkHeader);
+
+    if (m_Buffer) {
+        memcpy(
+            m_Buffer->data() + m_ChunkBegin + offsetof(ChunkHeader, size),
+            &size,
+            sizeof(size));
+    }
+
+    if (m_Chunks) {
+        m_Chunks->push_back({m_ChunkId, size});
+    }
+}
+
+void Serializer::write(const void* data, size_t size)
+{
+    if (m_Buffer) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        m_Buffer->insert(m_Buffer->end(), bytes, bytes + size);
+    }
+
+    m_Size += size;
+}
+
+size_t Serializer::getSize() const
+{
+    return m_Size;
+}
+
+Deserializer::Deserializer(const uint8_t* data, size_t size)
+    : m_Data(data)
+    , m_Size(size)
+{
+}
+
+int Deserializer::readHeader()
+{
+    uint32_t magic;
+    uint32_t version;
+
+    if (m_Size - m_Pos < sizeof(magic) + sizeof(version)) {
+        return -EINVAL;
+    }
+
+    read(&magic, sizeof(magic));
+    read(&version, sizeof(version));
+
+    if (magic != kStateMagic || version != kStateVersion) {
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+int Deserializer::checkChunks(const std::vector<StateChunk>& layout) const
+{
+    size_t pos = m_Pos;
+
+    for (const auto& chunk : layout) {
+        ChunkHeader header;
+
+        if (m_Size - pos < sizeof(header)) {
+            return -EINVAL;
+        }
+
+        memcpy(&header, m_Data + pos, sizeof(header));
+        pos += sizeof(header);
+
+        if (header.id != chunk.id || header.size != chunk.size ||
+            m_Size - pos < header.size) {
+            return -EINVAL;
+        }
+
+        pos += header.size;
+    }
+
+    return pos == m_Size ? 0 : -EINVAL;
+}
+
+void Deserializer::beginChunk(uint32_t id)
+{
+    ChunkHeader header;
+
+    read(&header, sizeof(header));
+    assert(header.id == id);
+
+    m_ChunkEnd = m_Pos + header.size;
+    assert(m_ChunkEnd <= m_Size);
+}
+
+void Deserializer::endChunk()
+{
+    assert(m_Pos == m_ChunkEnd);
+}
+
+void Deserializer::read(void* data, size_t size)
+{
+    assert(size <= m_Size - m_Pos);
+
+    memcpy(data, m_Data + m_Pos, size);
+    m_Pos += size;
+}
+
+} // namespace msfce::core
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <cstdint>
+#include <vector>
+
+namespace msfce::core {
+
+constexpr uint32_t makeChunkId(const char (&id)[5])
+{
+    return static_cast<uint32_t>(id[0]) |
+        (static_cast<uint32_t>(id[1]) << 8) |
+        (static_cast<uint32_t>(id[2]) << 16) |
+        (static_cast<uint32_t>(id[3]) << 24);
+}
+
+// Bump on any change of the serialized data
+constexpr uint32_t kStateVersion = 3;
+
+struct StateChunk {
+    uint32_t id;
+    uint32_t size;
+};
+
+// State layout:
+// * Header: magic, version
+// * Chunks: id, payload size, payload
+class Serializer {
+public:
+    // `buffer` is cleared but keeps its capacity. Without buffer, data is
+    // only measured. Chunks are appended to `chunks` if provided.
+    Serializer(
+        std::vector<uint8_t>* buffer,
+        std::vector<StateChunk>* chunks = nullptr);
+
+    void writeHeader();
+
+    void beginChunk(uint32_t id);
+    void endChunk();
+
+    void write(const void* data, size_t size);
+
+    size_t getSize() const;
+
+private:
+    std::vector<uint8_t>* m_Buffer;
+    std::vector<StateChunk>* m_Chunks;
+    size_t m_Size = 0;
+
+    uint32_t m_ChunkId = 0;
+    size_t m_ChunkBegin = 0;
+};
+
+class Deserializer {
+public:
+    Deserializer(const uint8_t* data, size_t size);
+
+    int readHeader();
+
+    // Check remaining chunks match `layout`, without consuming them
+    int checkChunks(const std::vector<StateChunk>& layout) const;
+
+    void beginChunk(uint32_t id);
+    void endChunk();
+
+    void read(void* data, size_t size);
+
+private:
+    const uint8_t* m_Data;
+    size_t m_Size;
+    size_t m_Pos = 0;
+
+    size_t m_ChunkEnd = 0;
+};
+
+} // namespace msfce::core
@@ -35,6 +35,25 @@ constexpr uint32_t kHeader_TitleSize = 21;
 
 constexpr bool kLogTimings = true;
 
+// Save state chunks
+constexpr uint32_t kChunkWram = msfce::core::makeChunkId("WRAM");
+constexpr uint32_t kChunkIndirectWram = msfce::core::makeChunkId("WMAD");
+constexpr uint32_t kChunkSram = msfce::core::makeChunkId("SRAM");
+constexpr uint32_t kChunkApu = msfce::core::makeChunkId("APU ");
+constexpr uint32_t kChunkApuFast = msfce::core::makeChunkId("APUF");
+constexpr uint32_t kChunkPpu = msfce::core::makeChunkId("PPU ");
+constexpr uint32_t kChunkMaths = msfce::core::makeChunkId("MATH");
+constexpr uint32_t kChunkDma = msfce::core::makeChunkId("DMA ");
+constexpr uint32_t kChunkControllerPorts = msfce::core::makeChunkId("JOYP");
+constexpr uint32_t kChunkCpu = msfce::core::makeChunkId("CPU ");
+constexpr uint32_t kChunkSnes = msfce::core::makeChunkId("SNES");
+
+// Each DSP has its own state, keep them apart
+uint32_t getApuChunk(msfce::core::DspType dsp)
+{
+    return dsp == msfce::core::DspType::fast ? kChunkApuFast : kChunkApu;
+}
+
 } // anonymous namespace
 
 namespace msfce::core {
@@ -73,13 +92,17 @@ int64_t SnesImpl::DurationTool::total()
     return std::chrono::duration_cast<Duration>(total_duration).count();
 }
 
-std::shared_ptr<Snes> Snes::create()
+std::shared_ptr<Snes> Snes::create(DspType dsp)
 {
-    return std::make_shared<SnesImpl>();
+    return std::make_shared<SnesImpl>(dsp);
 }
 
-SnesImpl::SnesImpl() : MemComponent(MemComponentType::irq), Scheduler()
+SnesImpl::SnesImpl(DspType dsp)
+    : MemComponent(MemComponentType::irq)
+    , Scheduler()
+    , m_Dsp(dsp)
 {
+    setFramebuffer({});
 }
 
 int SnesImpl::addRenderer(const std::shared_ptr<Renderer>& renderer)
@@ -301,33 +324,50 @@ int SnesImpl::start()
     }
 
     auto audioRenderCb = [this](const uint8_t* data, size_t sampleCount) {
+        if (!m_RenderAudio) {
+            return;
+        }
+
         for (const auto& renderer : m_RendererList) {
             renderer->playAudioSamples(data, sampleCount);
         }
     };
 
-    m_Apu = std::make_shared<Apu>(m_MasterClock, audioRenderCb);
+    m_Apu = std::make_shared<Apu>(
+        m_MasterClock, audioRenderCb, m_Dsp, m_ThreadedApu);
     membus->plugComponent(m_Apu);
 
     auto scanStartedCb = [this]() {
+        if (!m_RenderPpu) {
+            return;
+        }
+
         for (const auto& renderer : m_RendererList) {
             renderer->scanStarted();
         }
     };
 
     auto scanEndedCb = [this]() {
-        for (const auto& renderer : m_RendererList) {
-            renderer->scanEnded();
+        if (!m_RenderPpu) {
+            return;
         }
-    };
 
-    auto renderCb = [this](const Color& c) {
+        FrameView frame;
+        frame.data = m_Framebuffer.data;
+        frame.pitch = m_Framebuffer.pitch;
+        frame.format = m_Framebuffer.format;
+        frame.width = kPpuDisplayWidth;
+        frame.height = kPpuDisplayHeight;
+        frame.brightness = m_Ppu->getLineBrightness();
+
         for (const auto& renderer : m_RendererList) {
-            renderer->drawPixel(c);
+            renderer->drawFrame(frame);
+            renderer->scanEnded();
         }
     };
 
-    m_Ppu = std::make_shared<Ppu>(scanStartedCb, scanEndedCb, renderCb);
+    m_Ppu = std::make_shared<Ppu>(m_MasterClock, scanStartedCb, scanEndedCb);
+    m_Ppu->setFramebuffer(m_Framebuffer);
     membus->plugComponent(m_Ppu);
 
     m_Maths = std::make_shared<Maths>();
@@ -344,7 +384,15 @@ int SnesImpl::start()
     auto snes = shared_from_this();
     membus->plugComponent(snes);
 
+    m_Cpu->setScheduler(snes);
+    m_Cpu->setIdleLoopDetection(m_IdleLoopSkip);
     m_Dma->setScheduler(snes);
+    m_Ppu->setScheduler(snes);
+
+    // Measure states once, layout depends on the cartridge
+    Serializer layoutSerializer(nullptr, &m_StateLayout);
+    m_StateLayout.clear();
+    serializeChunks(&layoutSerializer);
 
     return 0;
 }
@@ -373,10 +421,37 @@ SnesConfig SnesImpl::getConfig()
     return config;
 }
 
-int SnesImpl::renderSingleFrame(bool renderPpu)
+DspType SnesImpl::getDspType() const
+{
+    return m_Dsp;
+}
+
+void SnesImpl::setFramebuffer(const Framebuffer& framebuffer)
+{
+    if (framebuffer.data) {
+        m_Framebuffer = framebuffer;
+        m_DefaultFramebuffer.clear();
+    } else {
+        m_Framebuffer.format = PixelFormat::RGB24;
+        m_Framebuffer.pitch =
+            kPpuDisplayWidth * getPixelSize(m_Framebuffer.format);
+
+        m_DefaultFramebuffer.resize(m_Framebuffer.pitch * kPpuDisplayHeight);
+        m_Framebuffer.data = m_DefaultFramebuffer.data();
+    }
+
+    if (m_Ppu) {
+        m_Ppu->setFramebuffer(m_Framebuffer);
+    }
+}
+
+int SnesImpl::renderSingleFrame(bool renderPpu, bool renderAudio)
 {
     bool scanEnded = false;
 
+    m_RenderPpu = renderPpu;
+    m_RenderAudio = renderAudio;
+
     if (renderPpu) {
         m_Ppu->setDrawConfig(Ppu::DrawConfig::Draw);
     } else {
@@ -408,7 +483,16 @@ int SnesImpl::renderSingleFrame(bool renderPpu)
             int cpuCycles = m_Cpu->run();
             m_CpuTime.end();
 
-            m_Cpu->setNextRunCycle(m_MasterClock + cpuCycles);
+            if (cpuCycles == 0) {
+                // Waiting for an interrupt, NMI or IRQ will resume it
+                m_Cpu->sleep();
+            } else {
+                if (m_IdleLoopSkip) {
+                    cpuCycles += getIdleLoopSkipCycles(cpuCycles);
+                }
+
+                m_Cpu->setNextRunCycle(m_MasterClock + cpuCycles);
+            }
         }
 
         // Check if Joypad autoread is complete
@@ -417,6 +501,7 @@ int SnesImpl::renderSingleFrame(bool renderPpu)
             m_HVBJOY &= ~1; // Autoread
             m_JoypadAutoreadEndcycle = 0;
             m_ControllerPorts->readController();
+            m_Cpu->resetIdleLoop();
         }
 
         // Always run PPU
@@ -428,6 +513,11 @@ int SnesImpl::renderSingleFrame(bool renderPpu)
             m_Ppu->setNextRunCycle(m_MasterClock + ppuCycles);
             auto ppuEvents = m_Ppu->getEvents();
 
+            if (ppuEvents) {
+                // System state has changed, idle loop has to be checked again
+                m_Cpu->resetIdleLoop();
+            }
+
             if (ppuEvents & Ppu::Event_ScanStarted) {
                 m_Dma->onScanStarted();
             }
@@ -440,7 +530,7 @@ int SnesImpl::renderSingleFrame(bool renderPpu)
 
             if (ppuEvents & Ppu::Event_HBlankEnd) {
                 m_HVBJOY &= ~(1 << 6);
-                m_Apu->run();
+                m_Apu->catchUp();
             }
 
             if (ppuEvents & Ppu::Event_HV_IRQ) {
@@ -468,27 +558,95 @@ int SnesImpl::renderSingleFrame(bool renderPpu)
                 m_Vblank = false;
                 m_HVBJOY &= ~(1 << 7);
 
+                // APU runs once per frame, port accesses make it catch up
+                // meanwhile. A state saved between two frames has no
+                // pending audio.
+                m_ApuTime.begin();
+                m_Apu->run();
+                m_ApuTime.end();
+
                 if (kLogTimings) {
+                    m_FrameTimings.cpuUs =
+                        m_CpuTime.total<std::chrono::microseconds>();
+                    m_FrameTimings.ppuUs =
+                        m_PpuTime.total<std::chrono::microseconds>();
+                    m_FrameTimings.apuUs =
+                        m_ApuTime.total<std::chrono::microseconds>();
+
                     LOGI(
                         TAG,
-                        "CPU: %" PRId64 " ms - PPU: %" PRId64 " ms",
+                        "CPU: %" PRId64 " ms - PPU: %" PRId64
+                        " ms - APU: %" PRId64 " ms",
                         m_CpuTime.total<std::chrono::milliseconds>(),
-                        m_PpuTime.total<std::chrono::milliseconds>());
+                        m_PpuTime.total<std::chrono::milliseconds>(),
+                        m_ApuTime.total<std::chrono::milliseconds>());
 
                     m_CpuTime.reset();
                     m_PpuTime.reset();
+                    m_ApuTime.reset();
                 }
 
                 scanEnded = true;
             }
         }
 
-        m_MasterClock++;
+        // Nothing can happen before the next deadline, jump to it
+        m_MasterClock = getNextEventCycle();
     }
 
     return 0;
 }
 
+FrameTimings SnesImpl::getFrameTimings()
+{
+    return m_FrameTimings;
+}
+
+int SnesImpl::getIdleLoopSkipCycles(int cpuCycles)
+{
+    int period = m_Cpu->getIdleLoopPeriod();
+    if (period == 0) {
+        return 0;
+    }
+
+    // Registers polled by the loop can only change on PPU events or at the
+    // end of joypad autoread. Skip the iterations that would complete before.
+    uint64_t deadline = m_Ppu->getNextRunCycle();
+    if (m_JoypadAutoreadEndcycle) {
+        deadline = std::min(deadline, m_JoypadAutoreadEndcycle);
+    }
+
+    uint64_t loopStart = m_MasterClock + cpuCycles;
+    if (deadline <= loopStart) {
+        return 0;
+    }
+
+    return (deadline - loopStart) / period * period;
+}
+
+uint64_t SnesImpl::getNextEventCycle()
+{
+    uint64_t nextCycle;
+
+    // CPU is stalled while a DMA is running
+    if (m_Dma->getState() == SchedulerTask::State::running) {
+        nextCycle = m_Dma->getNextRunCycle();
+    } else {
+        nextCycle = m_Cpu->getNextRunCycle();
+    }
+
+    // PPU also drives H-Blank, V-Blank and H/V IRQ events
+    nextCycle = std::min(nextCycle, m_Ppu->getNextRunCycle());
+
+    if (m_JoypadAutoreadEndcycle) {
+        nextCycle = std::min(nextCycle, m_JoypadAutoreadEndcycle);
+    }
+
+    // A task that is already due has to be run on the next cycle, like it
+    // would be while ticking every cycle
+    return std::max(nextCycle, m_MasterClock + 1);
+}
+
 void SnesImpl::resumeTask(SchedulerTask* task, int cycles)
 {
     task->setNextRunCycle(m_MasterClock + cycles);
@@ -500,71 +658,214 @@ void SnesImpl::setHVIRQ_Flag(bool v)
     m_Cpu->setIRQ(v);
 }
 
+void SnesImpl::setIdleLoopSkip(bool enable)
+{
+    m_IdleLoopSkip = enable;
+
+    if (m_Cpu) {
+        m_Cpu->setIdleLoopDetection(enable);
+    }
+}
+
+void SnesImpl::setThreadedApu(bool enable)
+{
+    // Only used when the APU is created
+    assert(!m_Apu);
+    m_ThreadedApu = enable;
+}
+
 void SnesImpl::setController1(const Controller& controller)
 {
     m_ControllerPorts->setController1(controller);
 }
 
-void SnesImpl::saveState(const std::string& path)
+void SnesImpl::serialize(std::vector<uint8_t>& buffer)
+{
+    Serializer s(&buffer);
+    serializeChunks(&s);
+}
+
+int SnesImpl::unserialize(const uint8_t* data, size_t size)
+{
+    Deserializer d(data, size);
+
+    // Check the whole state before touching any component
+    int ret = d.readHeader();
+    if (ret < 0) {
+        LOGE(TAG, "Invalid state header");
+        return ret;
+    }
+
+    ret = d.checkChunks(m_StateLayout);
+    if (ret < 0) {
+        LOGE(TAG, "State chunks don't match the running cartridge");
+        return ret;
+    }
+
+    unserializeChunks(&d);
+
+    return 0;
+}
+
+int SnesImpl::saveState(const std::string& path)
 {
     LOGI(TAG, "Save state to %s", path.c_str());
 
+    std::vector<uint8_t> state;
+    serialize(state);
+
     FILE* f = fopen(path.c_str(), "wb");
-    assert(f);
-
-    m_Ram->dumpToFile(f);
-    m_IndirectWram->dumpToFile(f);
-    m_Apu->dumpToFile(f);
-    m_Ppu->dumpToFile(f);
-    m_Maths->dumpToFile(f);
-    m_Dma->dumpToFile(f);
-    m_ControllerPorts->dumpToFile(f);
-    m_Cpu->dumpToFile(f);
-
-    fwrite(&m_HVBJOY, sizeof(m_HVBJOY), 1, f);
-    fwrite(&m_NMIEnabled, sizeof(m_NMIEnabled), 1, f);
-    fwrite(&m_HVIRQ_Config, sizeof(m_HVIRQ_Config), 1, f);
-    fwrite(&m_HVIRQ_Flag, sizeof(m_HVIRQ_Flag), 1, f);
-    fwrite(&m_HVIRQ_H, sizeof(m_HVIRQ_H), 1, f);
-    fwrite(&m_HVIRQ_V, sizeof(m_HVIRQ_V), 1, f);
-    fwrite(&m_JoypadAutoread, sizeof(m_JoypadAutoread), 1, f);
-    fwrite(&m_JoypadAutoreadRunning, sizeof(m_JoypadAutoreadRunning), 1, f);
-    fwrite(&m_JoypadAutoreadEndcycle, sizeof(m_JoypadAutoreadEndcycle), 1, f);
-    fwrite(&m_Vblank, sizeof(m_Vblank), 1, f);
-    fwrite(&m_MasterClock, sizeof(m_MasterClock), 1, f);
+    if (!f) {
+        int ret = -errno;
+        LOG_ERRNO(TAG, "fopen");
+        return ret;
+    }
+
+    int ret = 0;
+    if (fwrite(state.data(), 1, state.size(), f) < state.size()) {
+        LOGE(TAG, "Fail to write state");
+        ret = -EIO;
+    }
 
     fclose(f);
+
+    return ret;
 }
 
-void SnesImpl::loadState(const std::string& path)
+int SnesImpl::loadState(const std::string& path)
 {
     LOGI(TAG, "Load state from %s", path.c_str());
 
     FILE* f = fopen(path.c_str(), "rb");
-    assert(f);
-
-    m_Ram->loadFromFile(f);
-    m_IndirectWram->loadFromFile(f);
-    m_Apu->loadFromFile(f);
-    m_Ppu->loadFromFile(f);
-    m_Maths->loadFromFile(f);
-    m_Dma->loadFromFile(f);
-    m_ControllerPorts->loadFromFile(f);
-    m_Cpu->loadFromFile(f);
-
-    fread(&m_HVBJOY, sizeof(m_HVBJOY), 1, f);
-    fread(&m_NMIEnabled, sizeof(m_NMIEnabled), 1, f);
-    fread(&m_HVIRQ_Config, sizeof(m_HVIRQ_Config), 1, f);
-    fread(&m_HVIRQ_Flag, sizeof(m_HVIRQ_Flag), 1, f);
-    fread(&m_HVIRQ_H, sizeof(m_HVIRQ_H), 1, f);
-    fread(&m_HVIRQ_V, sizeof(m_HVIRQ_V), 1, f);
-    fread(&m_JoypadAutoread, sizeof(m_JoypadAutoread), 1, f);
-    fread(&m_JoypadAutoreadRunning, sizeof(m_JoypadAutoreadRunning), 1, f);
-    fread(&m_JoypadAutoreadEndcycle, sizeof(m_JoypadAutoreadEndcycle), 1, f);
-    fread(&m_Vblank, sizeof(m_Vblank), 1, f);
-    fread(&m_MasterClock, sizeof(m_MasterClock), 1, f);
+    if (!f) {
+        int ret = -errno;
+        LOG_ERRNO(TAG, "fopen");
+        return ret;
+    }
+
+    std::vector<uint8_t> state;
+    uint8_t chunk[4096];
+    size_t readRet;
+
+    while ((readRet = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        state.insert(state.end(), chunk, chunk + readRet);
+    }
 
     fclose(f);
+
+    return unserialize(state.data(), state.size());
+}
+
+void SnesImpl::serializeChunks(Serializer* s)
+{
+    s->writeHeader();
+
+    s->beginChunk(kChunkWram);
+    m_Ram->serialize(s);
+    s->endChunk();
+
+    s->beginChunk(kChunkIndirectWram);
+    m_IndirectWram->serialize(s);
+    s->endChunk();
+
+    if (m_Sram) {
+        s->beginChunk(kChunkSram);
+        m_Sram->serialize(s);
+        s->endChunk();
+    }
+
+    s->beginChunk(getApuChunk(m_Dsp));
+    m_Apu->serialize(s);
+    s->endChunk();
+
+    s->beginChunk(kChunkPpu);
+    m_Ppu->serialize(s);
+    s->endChunk();
+
+    s->beginChunk(kChunkMaths);
+    m_Maths->serialize(s);
+    s->endChunk();
+
+    s->beginChunk(kChunkDma);
+    m_Dma->serialize(s);
+    s->endChunk();
+
+    s->beginChunk(kChunkControllerPorts);
+    m_ControllerPorts->serialize(s);
+    s->endChunk();
+
+    s->beginChunk(kChunkCpu);
+    m_Cpu->serialize(s);
+    s->endChunk();
+
+    s->beginChunk(kChunkSnes);
+    s->write(&m_HVBJOY, sizeof(m_HVBJOY));
+    s->write(&m_NMIEnabled, sizeof(m_NMIEnabled));
+    s->write(&m_HVIRQ_Config, sizeof(m_HVIRQ_Config));
+    s->write(&m_HVIRQ_Flag, sizeof(m_HVIRQ_Flag));
+    s->write(&m_HVIRQ_H, sizeof(m_HVIRQ_H));
+    s->write(&m_HVIRQ_V, sizeof(m_HVIRQ_V));
+    s->write(&m_JoypadAutoread, sizeof(m_JoypadAutoread));
+    s->write(&m_JoypadAutoreadRunning, sizeof(m_JoypadAutoreadRunning));
+    s->write(&m_JoypadAutoreadEndcycle, sizeof(m_JoypadAutoreadEndcycle));
+    s->write(&m_Vblank, sizeof(m_Vblank));
+    s->write(&m_MasterClock, sizeof(m_MasterClock));
+    s->endChunk();
+}
+
+void SnesImpl::unserializeChunks(Deserializer* d)
+{
+    d->beginChunk(kChunkWram);
+    m_Ram->unserialize(d);
+    d->endChunk();
+
+    d->beginChunk(kChunkIndirectWram);
+    m_IndirectWram->unserialize(d);
+    d->endChunk();
+
+    if (m_Sram) {
+        d->beginChunk(kChunkSram);
+        m_Sram->unserialize(d);
+        d->endChunk();
+    }
+
+    d->beginChunk(getApuChunk(m_Dsp));
+    m_Apu->unserialize(d);
+    d->endChunk();
+
+    d->beginChunk(kChunkPpu);
+    m_Ppu->unserialize(d);
+    d->endChunk();
+
+    d->beginChunk(kChunkMaths);
+    m_Maths->unserialize(d);
+    d->endChunk();
+
+    d->beginChunk(kChunkDma);
+    m_Dma->unserialize(d);
+    d->endChunk();
+
+    d->beginChunk(kChunkControllerPorts);
+    m_ControllerPorts->unserialize(d);
+    d->endChunk();
+
+    d->beginChunk(kChunkCpu);
+    m_Cpu->unserialize(d);
+    d->endChunk();
+
+    d->beginChunk(kChunkSnes);
+    d->read(&m_HVBJOY, sizeof(m_HVBJOY));
+    d->read(&m_NMIEnabled, sizeof(m_NMIEnabled));
+    d->read(&m_HVIRQ_Config, sizeof(m_HVIRQ_Config));
+    d->read(&m_HVIRQ_Flag, sizeof(m_HVIRQ_Flag));
+    d->read(&m_HVIRQ_H, sizeof(m_HVIRQ_H));
+    d->read(&m_HVIRQ_V, sizeof(m_HVIRQ_V));
+    d->read(&m_JoypadAutoread, sizeof(m_JoypadAutoread));
+    d->read(&m_JoypadAutoreadRunning, sizeof(m_JoypadAutoreadRunning));
+    d->read(&m_JoypadAutoreadEndcycle, sizeof(m_JoypadAutoreadEndcycle));
+    d->read(&m_Vblank, sizeof(m_Vblank));
+    d->read(&m_MasterClock, sizeof(m_MasterClock));
+    d->endChunk();
 }
 
 uint8_t SnesImpl::readU8(uint32_t addr)
@@ -576,6 +877,11 @@ uint8_t SnesImpl::readU8(uint32_t addr)
 
     case kRegTIMEUP: {
         uint8_t ret = m_HVIRQ_Flag << 7;
+        if (m_HVIRQ_Flag) {
+            // Reading the flag has a side effect, not an idle read
+            m_Cpu->resetIdleLoop();
+        }
+
         setHVIRQ_Flag(false);
         return ret;
     }
@@ -6,6 +6,7 @@
 #include <vector>
 
 #include "scheduler.h"
+#include "serializer.h"
 #include "msfce/core/snes.h"
 
 namespace msfce::core {
@@ -29,7 +30,7 @@ class SnesImpl
     , public Scheduler
     , public std::enable_shared_from_this<SnesImpl> {
 public:
-    SnesImpl();
+    SnesImpl(DspType dsp);
 
     // Snes methods
     int addRenderer(const std::shared_ptr<Renderer>& renderer) final;
@@ -42,13 +43,25 @@ public:
     int stop() final;
 
     SnesConfig getConfig() final;
+    DspType getDspType() const final;
 
-    int renderSingleFrame(bool renderPpu = true) final;
+    void setFramebuffer(const Framebuffer& framebuffer) final;
+
+    int renderSingleFrame(
+        bool renderPpu = true,
+        bool renderAudio = true) final;
+    FrameTimings getFrameTimings() final;
+
+    void setIdleLoopSkip(bool enable) final;
+    void setThreadedApu(bool enable) final;
 
     void setController1(const Controller& controller) final;
 
-    void saveState(const std::string& path) final;
-    void loadState(const std::string& path) final;
+    void serialize(std::vector<uint8_t>& buffer) final;
+    int unserialize(const uint8_t* data, size_t size) final;
+
+    int saveState(const std::string& path) final;
+    int loadState(const std::string& path) final;
 
     // Scheduler methods
     void resumeTask(SchedulerTask* task, int cycles) final;
@@ -62,6 +75,12 @@ private:
 
     void setHVIRQ_Flag(bool v);
 
+    int getIdleLoopSkipCycles(int cpuCycles);
+    uint64_t getNextEventCycle();
+
+    void serializeChunks(Serializer* s);
+    void unserializeChunks(Deserializer* d);
+
 private:
     using Clock = std::chrono::high_resolution_clock;
 
@@ -86,6 +105,10 @@ private:
 private:
     // Renderer variables
     std::vector<std::shared_ptr<Renderer>> m_RendererList;
+    std::vector<uint8_t> m_DefaultFramebuffer;
+    Framebuffer m_Framebuffer;
+    bool m_RenderPpu = true;
+    bool m_RenderAudio = true;
 
     // Rom
     std::string m_RomBasename;
@@ -128,9 +151,19 @@ private:
 
     // Scheduling
     uint64_t m_MasterClock = 0;
+    bool m_IdleLoopSkip = false;
+
+    // APU
+    DspType m_Dsp;
+    bool m_ThreadedApu = false;
 
     DurationTool m_CpuTime;
     DurationTool m_PpuTime;
+    DurationTool m_ApuTime;
+    FrameTimings m_FrameTimings = {};
+
+    // Expected chunks of a state, filled at start
+    std::vector<StateChunk> m_StateLayout;
 };
 
 } // namespace msfce::core
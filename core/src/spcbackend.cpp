@@ -0,0 +1,20 @@
+#include <snes_spc/SNES_SPC.h>
+
+#include "spcbackendimpl.h"
+
+namespace msfce::core {
+
+std::unique_ptr<SpcBackend> SpcBackend::create(DspType dsp)
+{
+    switch (dsp) {
+    case DspType::accurate:
+        return std::make_unique<SpcBackendImpl<SNES_SPC>>();
+
+    case DspType::fast:
+        return createFastSpcBackend();
+    }
+
+    return nullptr;
+}
+
+} // namespace msfce::core
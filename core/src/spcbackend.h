@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "msfce/core/snes.h"
+
+namespace msfce::core {
+
+// SNES_SPC methods used by the APU. Each DSP builds its own SNES_SPC, so
+// the APU picks one through this interface.
+class SpcBackend {
+public:
+    using CopyFunc = void (*)(unsigned char** io, void* state, size_t size);
+
+    static std::unique_ptr<SpcBackend> create(DspType dsp);
+
+public:
+    virtual ~SpcBackend() = default;
+
+    // `rom` is the 64 bytes IPL ROM
+    virtual void init(const uint8_t* rom) = 0;
+
+    virtual void setOutput(short* out, int outSize) = 0;
+    virtual int getSampleCount() const = 0;
+
+    // Times are SPC clocks since the beginning of the frame
+    virtual int readPort(int time, int port) = 0;
+    virtual void writePort(int time, int port, int data) = 0;
+    virtual void endFrame(int time) = 0;
+
+    // Copy the whole state, including the extra samples
+    virtual void copyState(unsigned char** io, CopyFunc copy) = 0;
+};
+
+} // namespace msfce::core
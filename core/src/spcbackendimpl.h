@@ -0,0 +1,55 @@
+#pragma once
+
+#include "spcbackend.h"
+
+namespace msfce::core {
+
+// Include SNES_SPC.h before, `Spc` is either SNES_SPC or Fast_SNES_SPC
+template <typename Spc>
+class SpcBackendImpl : public SpcBackend {
+public:
+    void init(const uint8_t* rom) final
+    {
+        m_SPC.init();
+        m_SPC.init_rom(rom);
+        m_SPC.reset();
+    }
+
+    void setOutput(short* out, int outSize) final
+    {
+        m_SPC.set_output(out, outSize);
+    }
+
+    int getSampleCount() const final
+    {
+        return m_SPC.sample_count();
+    }
+
+    int readPort(int time, int port) final
+    {
+        return m_SPC.read_port(time, port);
+    }
+
+    void writePort(int time, int port, int data) final
+    {
+        m_SPC.write_port(time, port, data);
+    }
+
+    void endFrame(int time) final
+    {
+        m_SPC.end_frame(time);
+    }
+
+    void copyState(unsigned char** io, CopyFunc copy) final
+    {
+        m_SPC.copy_state(io, copy);
+        m_SPC.copy_extra_state(io, copy);
+    }
+
+private:
+    Spc m_SPC;
+};
+
+std::unique_ptr<SpcBackend> createFastSpcBackend();
+
+} // namespace msfce::core
@@ -20,6 +20,16 @@ void Sram::writeU8(uint32_t address, uint8_t value)
     BufferMemComponent::writeU8(address & m_AddressMask, value);
 }
 
+uint8_t* Sram::getHostPointer(uint32_t address, size_t size)
+{
+    // Range must not wrap around the mask
+    if ((address & m_AddressMask) + size - 1 > m_AddressMask) {
+        return nullptr;
+    }
+
+    return BufferMemComponent::getHostPointer(address & m_AddressMask, size);
+}
+
 int Sram::save(const std::string& path)
 {
     FILE* f = fopen(path.c_str(), "wb");
@@ -12,6 +12,8 @@ public:
     uint8_t readU8(uint32_t address) override;
     void writeU8(uint32_t address, uint8_t value) override;
 
+    uint8_t* getHostPointer(uint32_t address, size_t size) override;
+
     int save(const std::string& path);
     int load(const std::string& path);
 
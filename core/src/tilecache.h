@@ -0,0 +1,75 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace msfce::core {
+
+// 8x8 tiles of a given bpp, converted from the VRAM planar format to one
+// color index per byte. A tile is decoded again on its first use after a
+// write to its VRAM area.
+template<int kBpp>
+class TileCache {
+public:
+    static constexpr size_t kTileSize = 8 * kBpp;
+    static constexpr size_t kTileCount = 0x10000 / kTileSize;
+
+public:
+    TileCache()
+    {
+        invalidateAll();
+    }
+
+    void invalidate(uint16_t vramAddress)
+    {
+        const size_t tile = vramAddress / kTileSize;
+        m_Dirty[tile / 64] |= UINT64_C(1) << (tile % 64);
+    }
+
+    void invalidateAll()
+    {
+        memset(m_Dirty, 0xFF, sizeof(m_Dirty));
+    }
+
+    // Get the color indices of a tile row, from left to right
+    const uint8_t* getRow(const uint8_t* vram, uint16_t tileAddress, int row)
+    {
+        const size_t tile = tileAddress / kTileSize;
+        const uint64_t dirtyMask = UINT64_C(1) << (tile % 64);
+
+        if (m_Dirty[tile / 64] & dirtyMask) {
+            decode(vram + tile * kTileSize, m_Tiles[tile]);
+            m_Dirty[tile / 64] &= ~dirtyMask;
+        }
+
+        return m_Tiles[tile] + row * 8;
+    }
+
+private:
+    static void decode(const uint8_t* tileData, uint8_t* pixels)
+    {
+        for (int row = 0; row < 8; row++) {
+            for (int column = 0; column < 8; column++) {
+                // Bit 7 is the first pixel
+                const int bit = 7 - column;
+                uint8_t color = 0;
+
+                // Each plane holds 2 bits of the color, as 8 words
+                for (int plane = 0; plane < kBpp / 2; plane++) {
+                    const uint8_t* rowData = tileData + plane * 0x10 + row * 2;
+
+                    color |= ((rowData[0] >> bit) & 1) << (plane * 2);
+                    color |= ((rowData[1] >> bit) & 1) << (plane * 2 + 1);
+                }
+
+                pixels[row * 8 + column] = color;
+            }
+        }
+    }
+
+private:
+    uint8_t m_Tiles[kTileCount][64];
+    uint64_t m_Dirty[kTileCount / 64];
+};
+
+} // namespace msfce::core
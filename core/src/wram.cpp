@@ -1,4 +1,6 @@
 #include <assert.h>
+#include <string.h>
+#include <algorithm>
 #include "msfce/core/log.h"
 #include "registers.h"
 #include "wram.h"
@@ -71,14 +73,43 @@ void IndirectWram::writeU8(uint32_t addr, uint8_t value)
     }
 }
 
-void IndirectWram::dumpToFile(FILE* f)
+void IndirectWram::writeRegisterBlock(
+    uint32_t address,
+    const uint8_t* offsets,
+    size_t offsetCount,
+    const uint8_t* data,
+    size_t size)
 {
-    fwrite(&m_Address, sizeof(m_Address), 1, f);
+    for (size_t i = 0; i < offsetCount; i++) {
+        if (address + offsets[i] != kRegisterWMDATA) {
+            MemComponent::writeRegisterBlock(
+                address, offsets, offsetCount, data, size);
+            return;
+        }
+    }
+
+    // Stream to WMDATA, copy to WRAM up to the address wrap
+    while (size) {
+        size_t count = std::min<size_t>(size, kWramSize - m_Address);
+
+        uint8_t* dest = m_Wram->getHostPointer(m_Address, count);
+        assert(dest);
+        memcpy(dest, data, count);
+
+        m_Address = (m_Address + count) & 0x1ffff;
+        data += count;
+        size -= count;
+    }
+}
+
+void IndirectWram::serialize(Serializer* s)
+{
+    s->write(&m_Address, sizeof(m_Address));
 }
 
-void IndirectWram::loadFromFile(FILE* f)
+void IndirectWram::unserialize(Deserializer* d)
 {
-    fread(&m_Address, sizeof(m_Address), 1, f);
+    d->read(&m_Address, sizeof(m_Address));
 }
 
 } // namespace msfce::core
@@ -18,8 +18,15 @@ public:
     uint8_t readU8(uint32_t address) override;
     void writeU8(uint32_t address, uint8_t value) override;
 
-    void dumpToFile(FILE* f);
-    void loadFromFile(FILE* f);
+    void writeRegisterBlock(
+        uint32_t address,
+        const uint8_t* offsets,
+        size_t offsetCount,
+        const uint8_t* data,
+        size_t size) override;
+
+    void serialize(Serializer* s);
+    void unserialize(Deserializer* d);
 
 private:
     std::shared_ptr<Wram> m_Wram;
@@ -2,7 +2,7 @@
 
 #include "SPC_DSP.h"
 
-#include "blargg_endian.h"
+#include "../snes_spc/blargg_endian.h"
 #include <string.h>
 
 /* Copyright (C) 2007 Shay Green. This module is free software; you
@@ -16,7 +16,7 @@ details. You should have received a copy of the GNU Lesser General Public
 License along with this module; if not, write to the Free Software Foundation,
 Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 
-#include "blargg_source.h"
+#include "../snes_spc/blargg_source.h"
 
 #ifdef BLARGG_ENABLE_OPTIMIZER
 	#include BLARGG_ENABLE_OPTIMIZER
@@ -209,6 +209,8 @@ void SPC_DSP::run( int clock_count )
 		{
 			m.new_kon &= ~m.kon;
 			m.kon    = m.new_kon;
+			if ( m.kon )
+				m.kon_check = true;
 			m.t_koff = REG(koff);
 		}
 
@@ -701,3 +703,106 @@ void SPC_DSP::load( uint8_t const regs [register_count] )
 }
 
 void SPC_DSP::reset() { load( initial_regs ); }
+
+
+//// State save/load
+
+void SPC_State_Copier::copy( void* state, size_t size )
+{
+	func( buf, state, size );
+}
+
+int SPC_State_Copier::copy_int( int state, int size )
+{
+	BOOST::uint8_t s [2];
+	SET_LE16( s, state );
+	func( buf, &s, size );
+	return GET_LE16( s );
+}
+
+void SPC_State_Copier::skip( int count )
+{
+	if ( count > 0 )
+	{
+		char temp [64];
+		memset( temp, 0, sizeof temp );
+		do
+		{
+			int n = sizeof temp;
+			if ( n > count )
+				n = count;
+			count -= n;
+			func( buf, temp, n );
+		}
+		while ( count );
+	}
+}
+
+void SPC_State_Copier::extra()
+{
+	int n = 0;
+	SPC_State_Copier& copier = *this;
+	SPC_COPY( uint8_t, n );
+	skip( n );
+}
+
+void SPC_DSP::copy_state( unsigned char** io, copy_func_t copy )
+{
+	SPC_State_Copier copier( io, copy );
+
+	// DSP registers
+	copier.copy( m.regs, register_count );
+
+	// Voices, volumes are derived from registers
+	int i;
+	for ( i = 0; i < voice_count; i++ )
+	{
+		voice_t* v = &m.voices [i];
+
+		// BRR buffer
+		int j;
+		for ( j = 0; j < brr_buf_size; j++ )
+		{
+			copier.copy( &v->buf [j], sizeof v->buf [j] );
+			v->buf [j + brr_buf_size] = v->buf [j];
+		}
+
+		int buf_pos = v->buf_pos - v->buf;
+		copier.copy( &buf_pos, sizeof buf_pos );
+		v->buf_pos = &v->buf [buf_pos];
+
+		copier.copy( &v->interp_pos, sizeof v->interp_pos );
+		copier.copy( &v->brr_addr, sizeof v->brr_addr );
+		copier.copy( &v->brr_offset, sizeof v->brr_offset );
+		copier.copy( &v->kon_delay, sizeof v->kon_delay );
+		copier.copy( &v->env_mode, sizeof v->env_mode );
+		copier.copy( &v->env, sizeof v->env );
+		copier.copy( &v->hidden_env, sizeof v->hidden_env );
+
+		update_voice_vol( i * 0x10 );
+	}
+
+	// Echo history
+	for ( i = 0; i < echo_hist_size; i++ )
+	{
+		int s [2];
+		s [0] = m.echo_hist_pos [i] [0];
+		s [1] = m.echo_hist_pos [i] [1];
+		copier.copy( s, sizeof s );
+		m.echo_hist [i] [0] = s [0]; // write back at offset 0
+		m.echo_hist [i] [1] = s [1];
+	}
+	m.echo_hist_pos = m.echo_hist;
+	memcpy( &m.echo_hist [echo_hist_size], m.echo_hist, echo_hist_size * sizeof m.echo_hist [0] );
+
+	// Misc
+	copier.copy( &m.every_other_sample, sizeof m.every_other_sample );
+	copier.copy( &m.kon, sizeof m.kon );
+	copier.copy( &m.noise, sizeof m.noise );
+	copier.copy( &m.echo_offset, sizeof m.echo_offset );
+	copier.copy( &m.echo_length, sizeof m.echo_length );
+	copier.copy( &m.phase, sizeof m.phase );
+	copier.copy( m.counters, sizeof m.counters );
+	copier.copy( &m.new_kon, sizeof m.new_kon );
+	copier.copy( &m.t_koff, sizeof m.t_koff );
+}
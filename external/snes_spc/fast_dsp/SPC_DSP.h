@@ -4,7 +4,15 @@
 #ifndef SPC_DSP_H
 #define SPC_DSP_H
 
-#include "blargg_common.h"
+// Renamed so that SNES_SPC can be built with both DSPs in the same program,
+// see SPC_FAST_DSP in SNES_SPC.h
+#define SPC_DSP Fast_SPC_DSP
+#define SNES_SPC Fast_SNES_SPC
+#define SPC_State_Copier Fast_SPC_State_Copier
+
+#include "../snes_spc/blargg_common.h"
+
+extern "C" { typedef void (*dsp_copy_func_t)( unsigned char** io, void* state, size_t ); }
 
 class SPC_DSP {
 public:
@@ -58,6 +66,14 @@ public:
 	enum { register_count = 128 };
 	void load( uint8_t const regs [register_count] );
 
+	// Saves/loads exact emulator state
+	enum { state_size = 1024 }; // maximum space needed when saving
+	typedef dsp_copy_func_t copy_func_t;
+	void copy_state( unsigned char** io, copy_func_t );
+
+	// Returns non-zero if new key-on events occurred since last call
+	bool check_kon();
+
 // DSP register addresses
 
 	// Global registers
@@ -129,6 +145,7 @@ private:
 
 		int new_kon;
 		int t_koff;
+		bool kon_check;         // set when a new KON occurs
 
 		voice_t voices [voice_count];
 
@@ -205,7 +222,29 @@ inline void SPC_DSP::disable_surround( bool disable )
 	m.surround_threshold = disable ? 0 : -0x4000;
 }
 
-#define SPC_NO_COPY_STATE_FUNCS 1
+inline bool SPC_DSP::check_kon()
+{
+	bool old = m.kon_check;
+	m.kon_check = 0;
+	return old;
+}
+
+class SPC_State_Copier {
+	SPC_DSP::copy_func_t func;
+	unsigned char** buf;
+public:
+	SPC_State_Copier( unsigned char** p, SPC_DSP::copy_func_t f ) { func = f; buf = p; }
+	void copy( void* state, size_t size );
+	int copy_int( int state, int size );
+	void skip( int count );
+	void extra();
+};
+
+#define SPC_COPY( type, state )\
+{\
+	state = (BOOST::type) copier.copy_int( state, sizeof (BOOST::type) );\
+	assert( (BOOST::type) state == state );\
+}
 
 #define SPC_LESS_ACCURATE 1
 
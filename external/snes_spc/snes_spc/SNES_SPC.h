@@ -4,7 +4,12 @@
 #ifndef SNES_SPC_H
 #define SNES_SPC_H
 
-#include "SPC_DSP.h"
+// Define SPC_FAST_DSP to 1 to build Fast_SNES_SPC, using the fast DSP
+#if SPC_FAST_DSP
+	#include "../fast_dsp/SPC_DSP.h"
+#else
+	#include "SPC_DSP.h"
+#endif
 #include "blargg_endian.h"
 
 struct SNES_SPC {
@@ -92,6 +97,11 @@ public:
 	typedef SPC_DSP::copy_func_t copy_func_t;
 	void copy_state( unsigned char** io, copy_func_t );
 
+	// Saves/loads clocks and samples left over by the last end_frame() and
+	// the input ports, so a restored state produces the same output. Call
+	// set_output() after loading.
+	void copy_extra_state( unsigned char** io, copy_func_t );
+
 	// Writes minimal header to spc_out
 	static void init_header( void* spc_out );
 
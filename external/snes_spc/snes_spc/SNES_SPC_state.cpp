@@ -91,14 +91,20 @@ void SNES_SPC::copy_state( unsigned char** io, copy_func_t copy )
 	{
 		// SMP registers
 		uint8_t out_ports [port_count];
+		uint8_t in_ports [port_count];
 		uint8_t regs [reg_count];
 		memcpy( out_ports, &REGS [r_cpuio0], sizeof out_ports );
+		memcpy( in_ports, &REGS_IN [r_cpuio0], sizeof in_ports );
 		save_regs( regs );
 		copier.copy( regs, sizeof regs );
 		copier.copy( out_ports, sizeof out_ports );
 		load_regs( regs );
 		regs_loaded();
 		memcpy( &REGS [r_cpuio0], out_ports, sizeof out_ports );
+
+		// load_regs() overwrote the input ports with the output ones, they
+		// are loaded by copy_extra_state()
+		memcpy( &REGS_IN [r_cpuio0], in_ports, sizeof in_ports );
 	}
 
 	// CPU registers
@@ -126,4 +132,19 @@ void SNES_SPC::copy_state( unsigned char** io, copy_func_t copy )
 	}
 	copier.extra();
 }
+
+void SNES_SPC::copy_extra_state( unsigned char** io, copy_func_t copy )
+{
+	SPC_State_Copier copier( io, copy );
+
+	copier.copy( &m.extra_clocks, sizeof m.extra_clocks );
+
+	// Input ports, RAM at $F4-$F7 also holds the output ones
+	copier.copy( &REGS_IN [r_cpuio0], port_count );
+
+	int count = m.extra_pos - m.extra_buf;
+	SPC_COPY( uint8_t, count );
+	copier.copy( m.extra_buf, sizeof m.extra_buf );
+	m.extra_pos = &m.extra_buf [count];
+}
 #endif
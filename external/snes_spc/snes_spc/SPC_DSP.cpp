@@ -26,6 +26,12 @@ Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA */
 	#error "Requires that int type have at least 32 bits"
 #endif
 
+// Define SPC_DSP_NO_SIMD to use scalar code only
+#if defined (__SSE2__) && !defined (SPC_DSP_NO_SIMD)
+	#define SPC_DSP_SSE2 1
+	#include <emmintrin.h>
+#endif
+
 // TODO: add to blargg_endian.h
 #define GET_LE16SA( addr )      ((BOOST::int16_t) GET_LE16( addr ))
 #define GET_LE16A( addr )       GET_LE16( addr )
@@ -285,20 +291,44 @@ inline void SPC_DSP::run_envelope( voice_t* const v )
 
 //// BRR Decoding
 
-inline void SPC_DSP::decode_brr( voice_t* v )
+// Applies IIR filter to shifted sample, then writes it
+static inline void filter_brr_sample( int* pos, int s, int filter )
 {
-	// Arrange the four input nybbles in 0xABCD order for easy decoding
-	int nybbles = m.t_brr_byte * 0x100 + m.ram [(v->brr_addr + v->brr_offset + 1) & 0xFFFF];
+	int const brr_buf_size = SPC_DSP::brr_buf_size;
 
-	int const header = m.t_brr_header;
+	// Apply IIR filter (8 is the most commonly used)
+	int const p1 = pos [brr_buf_size - 1];
+	int const p2 = pos [brr_buf_size - 2] >> 1;
+	if ( filter >= 8 )
+	{
+		s += p1;
+		s -= p2;
+		if ( filter == 8 ) // s += p1 * 0.953125 - p2 * 0.46875
+		{
+			s += p2 >> 4;
+			s += (p1 * -3) >> 6;
+		}
+		else // s += p1 * 0.8984375 - p2 * 0.40625
+		{
+			s += (p1 * -13) >> 7;
+			s += (p2 * 3) >> 4;
+		}
+	}
+	else if ( filter ) // s += p1 * 0.46875
+	{
+		s += p1 >> 1;
+		s += (-p1) >> 5;
+	}
 
-	// Write to next four samples in circular buffer
-	int* pos = &v->buf [v->buf_pos];
-	int* end;
-	if ( (v->buf_pos += 4) >= brr_buf_size )
-		v->buf_pos = 0;
+	// Adjust and write sample
+	CLAMP16( s );
+	s = (int16_t) (s * 2);
+	pos [brr_buf_size] = pos [0] = s; // second copy simplifies wrap-around
+}
 
-	// Decode four samples
+void SPC_DSP::decode_brr_samples_scalar( int* pos, int nybbles, int header )
+{
+	int* end;
 	for ( end = pos + 4; pos < end; pos++, nybbles <<= 4 )
 	{
 		// Extract nybble and sign-extend
@@ -310,36 +340,67 @@ inline void SPC_DSP::decode_brr( voice_t* v )
 		if ( shift >= 0xD ) // handle invalid range
 			s = (s >> 25) << 11; // same as: s = (s < 0 ? -0x800 : 0)
 
-		// Apply IIR filter (8 is the most commonly used)
-		int const filter = header & 0x0C;
-		int const p1 = pos [brr_buf_size - 1];
-		int const p2 = pos [brr_buf_size - 2] >> 1;
-		if ( filter >= 8 )
-		{
-			s += p1;
-			s -= p2;
-			if ( filter == 8 ) // s += p1 * 0.953125 - p2 * 0.46875
-			{
-				s += p2 >> 4;
-				s += (p1 * -3) >> 6;
-			}
-			else // s += p1 * 0.8984375 - p2 * 0.40625
-			{
-				s += (p1 * -13) >> 7;
-				s += (p2 * 3) >> 4;
-			}
-		}
-		else if ( filter ) // s += p1 * 0.46875
-		{
-			s += p1 >> 1;
-			s += (-p1) >> 5;
-		}
+		filter_brr_sample( pos, s, header & 0x0C );
+	}
+}
 
-		// Adjust and write sample
-		CLAMP16( s );
-		s = (int16_t) (s * 2);
-		pos [brr_buf_size] = pos [0] = s; // second copy simplifies wrap-around
+#if SPC_DSP_SSE2
+
+void SPC_DSP::decode_brr_samples( int* pos, int nybbles, int header )
+{
+	// Extract and sign-extend the four nybbles at once, 16-bit lane i is
+	// shifted left by i * 4 so that its nybble ends up on top
+	__m128i s = _mm_set1_epi16( (short) nybbles );
+	s = _mm_mullo_epi16( s, _mm_setr_epi16( 1, 0x10, 0x100, 0x1000, 0, 0, 0, 0 ) );
+	s = _mm_srai_epi16( s, 12 );
+	s = _mm_srai_epi32( _mm_unpacklo_epi16( s, s ), 16 );
+
+	// Shift samples based on header
+	int const shift = header >> 4;
+	s = _mm_srai_epi32( _mm_sll_epi32( s, _mm_cvtsi32_si128( shift ) ), 1 );
+	if ( shift >= 0xD ) // handle invalid range
+		s = _mm_slli_epi32( _mm_srai_epi32( s, 25 ), 11 );
+
+	int const filter = header & 0x0C;
+	if ( !filter )
+	{
+		// Samples don't depend on previous ones, saturating pack clamps
+		__m128i out = _mm_packs_epi32( s, s );
+		out = _mm_add_epi16( out, out );
+		out = _mm_srai_epi32( _mm_unpacklo_epi16( out, out ), 16 );
+		_mm_storeu_si128( (__m128i*) pos, out );
+		_mm_storeu_si128( (__m128i*) (pos + brr_buf_size), out );
+		return;
 	}
+
+	// IIR filter needs each previous output
+	int shifted [4];
+	_mm_storeu_si128( (__m128i*) shifted, s );
+
+	for ( int i = 0; i < 4; i++ )
+		filter_brr_sample( pos + i, shifted [i], filter );
+}
+
+#else
+
+void SPC_DSP::decode_brr_samples( int* pos, int nybbles, int header )
+{
+	decode_brr_samples_scalar( pos, nybbles, header );
+}
+
+#endif
+
+inline void SPC_DSP::decode_brr( voice_t* v )
+{
+	// Arrange the four input nybbles in 0xABCD order for easy decoding
+	int nybbles = m.t_brr_byte * 0x100 + m.ram [(v->brr_addr + v->brr_offset + 1) & 0xFFFF];
+
+	// Write to next four samples in circular buffer
+	int* pos = &v->buf [v->buf_pos];
+	if ( (v->buf_pos += 4) >= brr_buf_size )
+		v->buf_pos = 0;
+
+	decode_brr_samples( pos, nybbles, m.t_brr_header );
 }
 
 
@@ -119,6 +119,13 @@ public:
 		int hidden_env;         // used by GAIN mode 7, very obscure quirk
 		uint8_t t_envx_out;
 	};
+
+	// Decodes four BRR samples from nybbles in 0xABCD order to pos [0 to 3]
+	// and their copies at pos [brr_buf_size], using the previous samples at
+	// pos [brr_buf_size - 2] and pos [brr_buf_size - 1]. Uses SSE2 when
+	// available, the scalar version gives the reference output.
+	static void decode_brr_samples( int* pos, int nybbles, int header );
+	static void decode_brr_samples_scalar( int* pos, int nybbles, int header );
 private:
 	enum { brr_block_size = 9 };
 
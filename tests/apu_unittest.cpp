@@ -0,0 +1,220 @@
+#include <string.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "apu.h"
+#include "registers.h"
+
+using namespace msfce::core;
+
+namespace {
+
+// About one NTSC frame
+constexpr uint64_t kFrameClocks = 357368;
+
+// SPC may run a bit past the frame end, accesses happen after it
+constexpr uint64_t kAccessClocks = 1000;
+
+struct ApuRunner {
+    explicit ApuRunner(bool threaded = false)
+        : apu(
+              clock,
+              [this](const uint8_t* data, size_t sampleCount) {
+                  samples.insert(
+                      samples.end(),
+                      data,
+                      data + sampleCount * Apu::kSampleSize);
+              },
+              DspType::accurate,
+              threaded)
+    {
+    }
+
+    uint8_t read(uint32_t addr)
+    {
+        clock += kAccessClocks;
+        return apu.readU8(addr);
+    }
+
+    void write(uint32_t addr, uint8_t value)
+    {
+        clock += kAccessClocks;
+        apu.writeU8(addr, value);
+    }
+
+    void runFrame()
+    {
+        clock += kFrameClocks;
+        apu.run();
+    }
+
+    std::vector<uint8_t> serialize()
+    {
+        std::vector<uint8_t> buffer;
+        Serializer s(&buffer);
+
+        apu.serialize(&s);
+        return buffer;
+    }
+
+    void unserialize(const std::vector<uint8_t>& buffer)
+    {
+        Deserializer d(buffer.data(), buffer.size());
+        apu.unserialize(&d);
+    }
+
+    uint64_t clock = 0;
+    std::vector<uint8_t> samples;
+    Apu apu;
+};
+
+// IPL writes $BBAA to its APUIO0-1 while the CPU ones differ
+void writeIplPorts(ApuRunner* runner)
+{
+    runner->write(kRegApuPort1, 0x42);
+    runner->write(kRegApuPort2, 0x00);
+    runner->write(kRegApuPort3, 0x02);
+    runner->runFrame();
+}
+
+// Start an IPL transfer to $0200, the first byte is the one left in APUIO1
+void startIplTransfer(ApuRunner* runner, std::vector<uint8_t>* reads)
+{
+    runner->write(kRegApuPort0, 0xCC);
+    runner->runFrame();
+    reads->push_back(runner->read(kRegApuPort0));
+
+    runner->write(kRegApuPort0, 0x00);
+    runner->runFrame();
+    reads->push_back(runner->read(kRegApuPort0));
+}
+
+// Write a DSP register with a new IPL block of two bytes at $00F2
+void writeIplDsp(ApuRunner* runner, uint8_t* index, uint8_t reg, uint8_t value)
+{
+    uint8_t kick = *index + 2;
+    if (kick == 0) {
+        kick = 1;
+    }
+
+    runner->write(kRegApuPort1, 0x01);
+    runner->write(kRegApuPort2, 0xF2);
+    runner->write(kRegApuPort3, 0x00);
+    runner->write(kRegApuPort0, kick);
+    runner->runFrame();
+
+    runner->write(kRegApuPort1, reg);
+    runner->write(kRegApuPort0, 0);
+    runner->runFrame();
+
+    runner->write(kRegApuPort1, value);
+    runner->write(kRegApuPort0, 1);
+    runner->runFrame();
+
+    *index = 1;
+}
+
+} // anonymous namespace
+
+TEST(ApuTest, StateAfterSpcPortWrite)
+{
+    // Saving a state must not change the emulation either, the reference
+    // is never saved
+    ApuRunner reference;
+    writeIplPorts(&reference);
+
+    ApuRunner saved;
+    writeIplPorts(&saved);
+
+    ASSERT_EQ(saved.read(kRegApuPort0), 0xAA);
+    ASSERT_EQ(saved.read(kRegApuPort1), 0xBB);
+    reference.read(kRegApuPort0);
+    reference.read(kRegApuPort1);
+
+    // Master clock isn't part of the APU state
+    ApuRunner restored;
+    restored.clock = saved.clock;
+    restored.unserialize(saved.serialize());
+
+    std::vector<uint8_t> reads;
+    std::vector<uint8_t> savedReads;
+    std::vector<uint8_t> restoredReads;
+    startIplTransfer(&reference, &reads);
+    startIplTransfer(&saved, &savedReads);
+    startIplTransfer(&restored, &restoredReads);
+
+    EXPECT_EQ(reads, std::vector<uint8_t>({0xCC, 0x00}));
+    EXPECT_EQ(savedReads, reads);
+    EXPECT_EQ(restoredReads, reads);
+
+    const std::vector<uint8_t> state = reference.serialize();
+    EXPECT_EQ(saved.serialize(), state);
+    EXPECT_EQ(restored.serialize(), state);
+}
+
+TEST(ApuTest, ThreadedMatchesInline)
+{
+    // Uploaded at $0201, entry 1 of a sample directory at $0200 points to
+    // a looping BRR block at $0208
+    const uint8_t upload[] = {
+        0x11, 0x22, 0x33, // Entry 0, unused
+        0x08, 0x02, 0x08, 0x02, // Entry 1
+        0xB3, // BRR header, loop and end
+        0x17, 0x7F, 0x71, 0x10, 0x0F, 0xF7, 0x81, 0x9E,
+    };
+
+    // Play the sample on voice 0
+    const uint8_t dspWrites[][2] = {
+        {0x0C, 0x7F}, // MVOLL
+        {0x1C, 0x7F}, // MVOLR
+        {0x00, 0x7F}, // V0VOLL
+        {0x01, 0x40}, // V0VOLR
+        {0x02, 0x00}, // V0PITCHL
+        {0x03, 0x08}, // V0PITCHH
+        {0x04, 0x01}, // V0SRCN
+        {0x05, 0x00}, // V0ADSR1, use GAIN
+        {0x07, 0x7F}, // V0GAIN
+        {0x5D, 0x02}, // DIR
+        {0x6C, 0x20}, // FLG, unmute, no echo writes
+        {0x4C, 0x01}, // KON
+    };
+
+    ApuRunner inlineRunner;
+    ApuRunner threadedRunner(true);
+    ApuRunner* runners[] = {&inlineRunner, &threadedRunner};
+    std::vector<uint8_t> reads[2];
+
+    for (int i = 0; i < 2; i++) {
+        ApuRunner* runner = runners[i];
+
+        writeIplPorts(runner);
+        startIplTransfer(runner, &reads[i]);
+
+        // Reads happen both right after a write and a frame later
+        uint8_t index = 0;
+        for (uint8_t value : upload) {
+            index++;
+            runner->write(kRegApuPort1, value);
+            runner->write(kRegApuPort0, index);
+            reads[i].push_back(runner->read(kRegApuPort0));
+            runner->runFrame();
+            reads[i].push_back(runner->read(kRegApuPort0));
+            reads[i].push_back(runner->read(kRegApuPort2));
+        }
+
+        for (const auto& dspWrite : dspWrites) {
+            writeIplDsp(runner, &index, dspWrite[0], dspWrite[1]);
+            reads[i].push_back(runner->read(kRegApuPort0));
+        }
+
+        for (int frame = 0; frame < 8; frame++) {
+            runner->runFrame();
+        }
+    }
+
+    EXPECT_EQ(reads[1], reads[0]);
+    ASSERT_FALSE(inlineRunner.samples.empty());
+    EXPECT_EQ(threadedRunner.samples, inlineRunner.samples);
+}
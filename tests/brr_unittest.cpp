@@ -0,0 +1,64 @@
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include <snes_spc/SPC_DSP.h>
+
+namespace {
+
+constexpr int kBufSize = SPC_DSP::brr_buf_size * 2;
+
+// Decoded samples are even and in the 16 bits range
+int randomSample(uint32_t* seed)
+{
+    *seed = *seed * 1664525 + 1013904223;
+    return static_cast<int16_t>(*seed >> 16) & ~1;
+}
+
+} // anonymous namespace
+
+TEST(BrrTest, MatchesScalar)
+{
+    uint32_t seed = 1;
+
+    // Every shift, filter and nybbles, with random previous samples. Header
+    // low bits are the end and loop flags, not used to decode.
+    for (int header = 0; header < 0x100; header += 4) {
+        for (int nybbles = 0; nybbles < 0x10000; nybbles++) {
+            int expected[kBufSize] = {};
+            int buf[kBufSize] = {};
+
+            expected[SPC_DSP::brr_buf_size - 2] = randomSample(&seed);
+            expected[SPC_DSP::brr_buf_size - 1] = randomSample(&seed);
+            memcpy(buf, expected, sizeof(buf));
+
+            SPC_DSP::decode_brr_samples_scalar(expected, nybbles, header);
+            SPC_DSP::decode_brr_samples(buf, nybbles, header);
+
+            ASSERT_EQ(memcmp(buf, expected, sizeof(buf)), 0)
+                << "header " << header << ", nybbles " << nybbles;
+        }
+    }
+}
+
+TEST(BrrTest, Saturation)
+{
+    // Filter 3 with the largest shift and history pushing out of range
+    const int history[][2] = {{-0x8000, 0x7FFE}, {0x7FFE, -0x8000}};
+
+    for (const auto& h : history) {
+        for (int nybbles : {0x0000, 0x7777, 0x8888, 0xFFFF}) {
+            int expected[kBufSize] = {};
+            int buf[kBufSize] = {};
+
+            expected[SPC_DSP::brr_buf_size - 2] = h[0];
+            expected[SPC_DSP::brr_buf_size - 1] = h[1];
+            memcpy(buf, expected, sizeof(buf));
+
+            SPC_DSP::decode_brr_samples_scalar(expected, nybbles, 0xCC);
+            SPC_DSP::decode_brr_samples(buf, nybbles, 0xCC);
+
+            EXPECT_EQ(memcmp(buf, expected, sizeof(buf)), 0);
+        }
+    }
+}
@@ -4,6 +4,7 @@
 #include <gmock/gmock.h>
 
 #include "membus.h"
+#include "timings.h"
 
 using ::testing::Return;
 using namespace msfce::core;
@@ -111,6 +112,31 @@ TEST_F(MembusTest, LowRomSram)
     ASSERT_EQ(membus->readU8(0xFF6666), 0x43);
 }
 
+TEST_F(MembusTest, LowRomTimings)
+{
+    int cycles = 0;
+
+    // WRAM, across two pages
+    membus->writeU16(0x000FFF, 0x4243, &cycles);
+    ASSERT_EQ(cycles, 2 * kTimingRamAccess);
+    ASSERT_EQ(ram->readU8(0x0FFF), 0x43);
+    ASSERT_EQ(ram->readU8(0x1000), 0x42);
+
+    cycles = 0;
+    ASSERT_EQ(membus->readU16(0x7E0FFF, &cycles), 0x4243);
+    ASSERT_EQ(cycles, 2 * kTimingRamAccess);
+
+    // ROM
+    cycles = 0;
+    membus->readU8(0x808000, &cycles);
+    ASSERT_EQ(cycles, kTimingRomSlowAccess);
+
+    // SRAM
+    cycles = 0;
+    membus->writeU8(0x700000, 0x43, &cycles);
+    ASSERT_EQ(cycles, kTimingRamAccess);
+}
+
 TEST_F(MembusTest, LowRomApuReadU8)
 {
     EXPECT_CALL(*apu, readU8(0x2140)).Times(1).WillOnce(Return(0x43));
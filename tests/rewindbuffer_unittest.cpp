@@ -0,0 +1,242 @@
+#include <errno.h>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "msfce/core/rewindbuffer.h"
+#include "msfce/core/snes.h"
+
+using namespace msfce::core;
+
+namespace {
+
+// Odd size so deltas don't end on a whole word
+constexpr size_t kStateSize = 1021;
+
+// State is a plain buffer
+class FakeSnes : public Snes {
+public:
+    int addRenderer(const std::shared_ptr<Renderer>& renderer) override
+    {
+        return 0;
+    }
+
+    int removeRenderer(const std::shared_ptr<Renderer>& renderer) override
+    {
+        return 0;
+    }
+
+    int plugCartidge(const char* path) override
+    {
+        return 0;
+    }
+
+    std::string getRomBasename() const override
+    {
+        return {};
+    }
+
+    int start() override
+    {
+        return 0;
+    }
+
+    int stop() override
+    {
+        return 0;
+    }
+
+    SnesConfig getConfig() override
+    {
+        return {};
+    }
+
+    DspType getDspType() const override
+    {
+        return DspType::accurate;
+    }
+
+    void setFramebuffer(const Framebuffer& framebuffer) override
+    {
+    }
+
+    int renderSingleFrame(bool renderPpu, bool renderAudio) override
+    {
+        return 0;
+    }
+
+    FrameTimings getFrameTimings() override
+    {
+        return {};
+    }
+
+    void setIdleLoopSkip(bool enable) override
+    {
+    }
+
+    void setThreadedApu(bool enable) override
+    {
+    }
+
+    void setController1(const Controller& controller) override
+    {
+    }
+
+    void serialize(std::vector<uint8_t>& buffer) override
+    {
+        buffer = state;
+    }
+
+    int unserialize(const uint8_t* data, size_t size) override
+    {
+        state.assign(data, data + size);
+        return 0;
+    }
+
+    int saveState(const std::string& path) override
+    {
+        return -ENOTSUP;
+    }
+
+    int loadState(const std::string& path) override
+    {
+        return -ENOTSUP;
+    }
+
+    std::vector<uint8_t> state;
+};
+
+} // anonymous namespace
+
+class RewindBufferTest : public testing::Test {
+public:
+    void pushState(RewindBuffer* rewind, const std::vector<uint8_t>& state)
+    {
+        snes->state = state;
+        rewind->onFrameEnded();
+        pushed.push_back(state);
+    }
+
+    // Step back through all snapshots, the newest ones must be restored
+    void checkStepBack(RewindBuffer* rewind)
+    {
+        size_t count = rewind->getSnapshotCount();
+        ASSERT_LE(count, pushed.size());
+
+        for (size_t i = 0; i < count; i++) {
+            ASSERT_EQ(rewind->stepBack(), 0);
+            ASSERT_EQ(snes->state, pushed[pushed.size() - 1 - i]) << i;
+        }
+
+        ASSERT_EQ(rewind->getSnapshotCount(), 0u);
+        ASSERT_EQ(rewind->stepBack(), -ENOENT);
+    }
+
+    std::vector<uint8_t> randomState()
+    {
+        std::vector<uint8_t> state(kStateSize);
+        for (auto& byte : state) {
+            byte = rng();
+        }
+
+        return state;
+    }
+
+    // Change `count` random bytes of the last pushed state
+    std::vector<uint8_t> changeBytes(size_t count)
+    {
+        std::vector<uint8_t> state = pushed.back();
+        for (size_t i = 0; i < count; i++) {
+            state[rng() % state.size()] ^= 1 + rng() % 255;
+        }
+
+        return state;
+    }
+
+    std::shared_ptr<FakeSnes> snes = std::make_shared<FakeSnes>();
+    std::vector<std::vector<uint8_t>> pushed;
+    std::mt19937 rng{1234};
+};
+
+TEST_F(RewindBufferTest, DeltaRoundTrip)
+{
+    RewindBuffer rewind(snes, 1024 * 1024, 1);
+
+    pushState(&rewind, randomState());
+
+    // Whole buffer differs
+    pushState(&rewind, randomState());
+
+    // All equal
+    pushState(&rewind, pushed.back());
+
+    // Literals at the end of the buffer, shorter than a skip
+    std::vector<uint8_t> state = pushed.back();
+    state[kStateSize - 1] ^= 0xFF;
+    pushState(&rewind, state);
+
+    state[kStateSize - 3] ^= 0x01;
+    state[kStateSize - 2] ^= 0x80;
+    pushState(&rewind, state);
+
+    // First byte, then runs split by less and more than a skip
+    state[0] ^= 0x42;
+    pushState(&rewind, state);
+
+    for (size_t gap = 1; gap < 8; gap++) {
+        for (size_t pos = 100 * gap; pos < 100 * gap + 50; pos += gap + 1) {
+            state[pos] ^= 0x5A;
+        }
+
+        pushState(&rewind, state);
+    }
+
+    for (int i = 0; i < 32; i++) {
+        pushState(&rewind, changeBytes(1 + rng() % 64));
+    }
+
+    ASSERT_EQ(rewind.getSnapshotCount(), pushed.size());
+    checkStepBack(&rewind);
+}
+
+TEST_F(RewindBufferTest, RingKeepsNewest)
+{
+    constexpr size_t kRingSize = 4096;
+    RewindBuffer rewind(snes, kRingSize, 1);
+
+    pushState(&rewind, randomState());
+
+    for (int i = 0; i < 200; i++) {
+        pushState(&rewind, changeBytes(16 + rng() % 512));
+        ASSERT_LE(rewind.getUsedSize(), kRingSize);
+    }
+
+    // Older snapshots have been dropped
+    ASSERT_GT(rewind.getSnapshotCount(), 1u);
+    ASSERT_LT(rewind.getSnapshotCount(), pushed.size());
+    checkStepBack(&rewind);
+}
+
+TEST_F(RewindBufferTest, Interval)
+{
+    RewindBuffer rewind(snes, 1024 * 1024, 3);
+
+    snes->state = randomState();
+    for (int i = 0; i < 3; i++) {
+        rewind.onFrameEnded();
+    }
+
+    ASSERT_EQ(rewind.getSnapshotCount(), 1u);
+
+    std::vector<uint8_t> expected = snes->state;
+    snes->state = randomState();
+    rewind.onFrameEnded();
+    rewind.onFrameEnded();
+
+    ASSERT_EQ(rewind.getSnapshotCount(), 1u);
+    ASSERT_EQ(rewind.stepBack(), 0);
+    ASSERT_EQ(snes->state, expected);
+}
@@ -0,0 +1,129 @@
+#include <errno.h>
+#include <string.h>
+
+#include <gtest/gtest.h>
+
+#include "serializer.h"
+
+using namespace msfce::core;
+
+namespace {
+
+constexpr uint32_t kChunkA = makeChunkId("AAAA");
+constexpr uint32_t kChunkB = makeChunkId("BBBB");
+
+struct State {
+    uint32_t a = 0;
+    uint8_t b[3] = {};
+};
+
+void serializeState(Serializer* s, const State& state)
+{
+    s->writeHeader();
+
+    s->beginChunk(kChunkA);
+    s->write(&state.a, sizeof(state.a));
+    s->endChunk();
+
+    s->beginChunk(kChunkB);
+    s->write(state.b, sizeof(state.b));
+    s->endChunk();
+}
+
+} // anonymous namespace
+
+class SerializerTest : public testing::Test {
+public:
+    void SetUp()
+    {
+        Serializer measure(nullptr, &layout);
+        serializeState(&measure, State());
+        stateSize = measure.getSize();
+
+        state.a = 0x12345678;
+        state.b[0] = 1;
+        state.b[1] = 2;
+        state.b[2] = 3;
+
+        Serializer s(&buffer);
+        serializeState(&s, state);
+    }
+
+    std::vector<StateChunk> layout;
+    size_t stateSize = 0;
+
+    State state;
+    std::vector<uint8_t> buffer;
+};
+
+TEST_F(SerializerTest, Layout)
+{
+    ASSERT_EQ(layout.size(), 2);
+    EXPECT_EQ(layout[0].id, kChunkA);
+    EXPECT_EQ(layout[0].size, sizeof(state.a));
+    EXPECT_EQ(layout[1].id, kChunkB);
+    EXPECT_EQ(layout[1].size, sizeof(state.b));
+
+    EXPECT_EQ(buffer.size(), stateSize);
+}
+
+TEST_F(SerializerTest, RoundTrip)
+{
+    State loaded;
+    Deserializer d(buffer.data(), buffer.size());
+
+    ASSERT_EQ(d.readHeader(), 0);
+    ASSERT_EQ(d.checkChunks(layout), 0);
+
+    d.beginChunk(kChunkA);
+    d.read(&loaded.a, sizeof(loaded.a));
+    d.endChunk();
+
+    d.beginChunk(kChunkB);
+    d.read(loaded.b, sizeof(loaded.b));
+    d.endChunk();
+
+    EXPECT_EQ(loaded.a, state.a);
+    EXPECT_EQ(memcmp(loaded.b, state.b, sizeof(state.b)), 0);
+}
+
+TEST_F(SerializerTest, ReuseBuffer)
+{
+    const uint8_t* data = buffer.data();
+
+    Serializer s(&buffer);
+    serializeState(&s, state);
+
+    EXPECT_EQ(buffer.data(), data);
+    EXPECT_EQ(buffer.size(), stateSize);
+}
+
+TEST_F(SerializerTest, InvalidHeader)
+{
+    buffer[0] ^= 0xFF;
+
+    Deserializer d(buffer.data(), buffer.size());
+    EXPECT_EQ(d.readHeader(), -EINVAL);
+
+    Deserializer empty(buffer.data(), 2);
+    EXPECT_EQ(empty.readHeader(), -EINVAL);
+}
+
+TEST_F(SerializerTest, InvalidChunks)
+{
+    Deserializer truncated(buffer.data(), buffer.size() - 1);
+    ASSERT_EQ(truncated.readHeader(), 0);
+    EXPECT_EQ(truncated.checkChunks(layout), -EINVAL);
+
+    buffer.push_back(0);
+    Deserializer trailing(buffer.data(), buffer.size());
+    ASSERT_EQ(trailing.readHeader(), 0);
+    EXPECT_EQ(trailing.checkChunks(layout), -EINVAL);
+
+    std::vector<StateChunk> otherLayout = layout;
+    otherLayout[1].id = kChunkA;
+
+    Deserializer d(buffer.data(), buffer.size() - 1);
+    ASSERT_EQ(d.readHeader(), 0);
+    EXPECT_EQ(d.checkChunks(otherLayout), -EINVAL);
+}